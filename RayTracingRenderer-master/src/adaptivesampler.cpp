@@ -0,0 +1,261 @@
+#include "adaptivesampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+// Конструктор
+AdaptiveSampler::AdaptiveSampler(){
+    sampleCount = 1;
+    xRes = 0;
+    yRes = 0;
+    tilesX = 0;
+    tilesY = 0;
+    samplePasses = 0;
+}
+
+// Задать количество образцов на пиксель края и размер растра
+void AdaptiveSampler::setSampleCount(int newSampleCount, int newXRes, int newYRes){
+    sampleCount = std::max(1, std::min(newSampleCount, MAX_SAMPLES));
+    xRes = newXRes;
+    yRes = newYRes;
+
+    // Буферы выделяются, только когда сглаживание включено
+    std::size_t pixels = isEnabled() ? (std::size_t)xRes * yRes : 0;
+    meshIds.assign(pixels, 0);
+    depths.assign(pixels, 0);
+    edgeMask.assign(pixels, 0);
+    sampleImage.colors.assign(pixels, 0);
+    sampleImage.width = xRes;
+    tilesX = (xRes + EDGE_TILE_SIZE - 1) / EDGE_TILE_SIZE;
+    tilesY = (yRes + EDGE_TILE_SIZE - 1) / EDGE_TILE_SIZE;
+    tileSums.assign(isEnabled() ? (std::size_t)(tilesX + 1) * (tilesY + 1) : 0, 0);
+    rowEdgeStart.assign(isEnabled() ? yRes + 1 : 0, 0);
+    edgePixels.clear();
+    sums.clear();
+
+    // Первый образец - центр пикселя (обычный проход). Остальные - по одному в ячейке сетки grid x grid со случайным сдвигом внутри ячейки
+    offsets.assign(sampleCount * 2, 0);
+    int extraSamples = sampleCount - 1;
+    int grid = (int)std::ceil(std::sqrt((double)extraSamples));
+    std::mt19937 generator(361);
+    std::uniform_real_distribution<double> jitter(0.0, 1.0);
+    for (int i = 0; i < extraSamples; i++){
+        offsets[(i + 1) * 2] = ((i % grid) + jitter(generator)) / grid - 0.5;
+        offsets[(i + 1) * 2 + 1] = ((i / grid) + jitter(generator)) / grid - 0.5;
+    }
+}
+
+// Количество образцов на пиксель края
+int AdaptiveSampler::getSampleCount(){
+    return sampleCount;
+}
+
+// Начать кадр
+void AdaptiveSampler::beginFrame(const ScreenRect& scissor){
+    samplePasses = 0;
+    edgePixels.clear();
+    if (!isEnabled() || scissor.isEmpty())
+        return;
+
+    int rowMin = std::max(0, yRes - scissor.yMax);
+    int rowMax = std::min(yRes - 1, yRes - scissor.yMin);
+    for (int row = rowMin; row <= rowMax; row++)
+        std::fill(meshIds.begin() + row * xRes + scissor.xMin, meshIds.begin() + row * xRes + scissor.xMax + 1, 0);
+}
+
+// Найти края в области перерисовки
+// Каждая пара соседей по горизонтали и вертикали сравнивается один раз; при разнице отмечаются оба пикселя
+ScreenRect AdaptiveSampler::findEdges(Drawable* image, const ScreenRect& scissor){
+    ScreenRect edgeRect;
+    if (!isEnabled() || scissor.isEmpty())
+        return edgeRect;
+
+    std::fill(edgeMask.begin(), edgeMask.end(), 0);
+    std::fill(tileSums.begin(), tileSums.end(), 0);
+
+    int rowMin = std::max(0, yRes - scissor.yMax);
+    int rowMax = std::min(yRes - 1, yRes - scissor.yMin);
+
+    // Цвета области с полем в 1 пиксель: соседние пиксели вне области тоже сравниваются
+    int xFirst = std::max(0, scissor.xMin - 1), xLast = std::min(xRes - 1, scissor.xMax + 1);
+    int rowFirst = std::max(0, rowMin - 1), rowLast = std::min(yRes - 1, rowMax + 1);
+    int width = xLast - xFirst + 1;
+    vector<unsigned int> colors((std::size_t)width * (rowLast - rowFirst + 1));
+    for (int row = rowFirst; row <= rowLast; row++){
+        for (int x = xFirst; x <= xLast; x++)
+            colors[(row - rowFirst) * width + (x - xFirst)] = image->getPixel(x, row);
+    }
+
+    auto isColorEdge = [](unsigned int a, unsigned int b){
+        for (int shift = 0; shift <= 16; shift += 8){
+            if (std::abs( (int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff) ) > COLOR_EDGE_THRESHOLD)
+                return true;
+        }
+        return false;
+    };
+
+    // Складка: вторая разность глубины вдоль линии трех пикселей одной сетки
+    auto isDepthCrease = [this](unsigned int before, unsigned int center, unsigned int after){
+        if (meshIds[center] == 0 || meshIds[before] != meshIds[center] || meshIds[after] != meshIds[center])
+            return false;
+        return std::fabs( depths[before] + depths[after] - 2 * depths[center] ) > DEPTH_CREASE_RATIO * depths[center];
+    };
+
+    for (int row = rowFirst; row <= rowLast; row++){
+        for (int x = xFirst; x <= xLast; x++){
+            unsigned int pixel = row * xRes + x;
+            unsigned int color = colors[(row - rowFirst) * width + (x - xFirst)];
+
+            if (x < xLast){
+                if (meshIds[pixel] != meshIds[pixel + 1] || isColorEdge(color, colors[(row - rowFirst) * width + (x + 1 - xFirst)])){
+                    markEdge(x, row, rowMin, rowMax, scissor);
+                    markEdge(x + 1, row, rowMin, rowMax, scissor);
+                }
+                if (x > xFirst && isDepthCrease(pixel - 1, pixel, pixel + 1))
+                    markEdge(x, row, rowMin, rowMax, scissor);
+            }
+
+            if (row < rowLast){
+                if (meshIds[pixel] != meshIds[pixel + xRes] || isColorEdge(color, colors[(row + 1 - rowFirst) * width + (x - xFirst)])){
+                    markEdge(x, row, rowMin, rowMax, scissor);
+                    markEdge(x, row + 1, rowMin, rowMax, scissor);
+                }
+                if (row > rowFirst && isDepthCrease(pixel - xRes, pixel, pixel + xRes))
+                    markEdge(x, row, rowMin, rowMax, scissor);
+            }
+        }
+    }
+
+    // Пиксели краев по строкам и столбцам
+    std::sort(edgePixels.begin(), edgePixels.end());
+    std::fill(rowEdgeStart.begin(), rowEdgeStart.end(), 0);
+    for (auto pixel : edgePixels)
+        rowEdgeStart[pixel / xRes + 1]++;
+    for (int row = 0; row < yRes; row++)
+        rowEdgeStart[row + 1] += rowEdgeStart[row];
+
+    // Суммы начинаются с образца первого прохода
+    sums.resize(edgePixels.size() * 3);
+    for (unsigned int i = 0; i < edgePixels.size(); i++){
+        int x = edgePixels[i] % xRes;
+        int row = edgePixels[i] / xRes;
+        unsigned int color = colors[(row - rowFirst) * width + (x - xFirst)];
+        sums[i * 3] = (color >> 16) & 0xff;
+        sums[i * 3 + 1] = (color >> 8) & 0xff;
+        sums[i * 3 + 2] = color & 0xff;
+
+        ScreenRect pixelRect;
+        pixelRect.xMin = pixelRect.xMax = x;
+        pixelRect.yMin = pixelRect.yMax = yRes - row;
+        if (i == 0)
+            edgeRect = pixelRect;
+        else
+            edgeRect.add(pixelRect);
+
+        tileSums[(row / EDGE_TILE_SIZE + 1) * (tilesX + 1) + x / EDGE_TILE_SIZE + 1]++;
+    }
+
+    // Количества по блокам -> накопленные суммы: количество в прямоугольнике блоков - по четырем углам
+    for (int tileRow = 1; tileRow <= tilesY; tileRow++){
+        for (int tile = 1; tile <= tilesX; tile++){
+            unsigned int index = tileRow * (tilesX + 1) + tile;
+            tileSums[index] += tileSums[index - 1] + tileSums[index - (tilesX + 1)] - tileSums[index - (tilesX + 1) - 1];
+        }
+    }
+
+    return edgeRect;
+}
+
+// Пиксели краев строки в отрезке столбцов
+void AdaptiveSampler::getRowEdges(int row, int xMin, int xMax, unsigned int& first, unsigned int& last) const {
+    first = last = 0;
+    xMin = std::max(0, xMin);
+    xMax = std::min(xRes - 1, xMax);
+    if (!isEnabled() || row < 0 || row >= yRes || xMin > xMax)
+        return;
+
+    auto rowBegin = edgePixels.begin() + rowEdgeStart[row];
+    auto rowEnd = edgePixels.begin() + rowEdgeStart[row + 1];
+    first = std::lower_bound(rowBegin, rowEnd, (unsigned int)(row * xRes + xMin)) - edgePixels.begin();
+    last = std::upper_bound(edgePixels.begin() + first, rowEnd, (unsigned int)(row * xRes + xMax)) - edgePixels.begin();
+}
+
+// Есть ли пиксели краев в прямоугольнике
+bool AdaptiveSampler::hasEdges(const ScreenRect& rect) const {
+    int xMin = std::max(0, rect.xMin), xMax = std::min(xRes - 1, rect.xMax);
+    int rowMin = std::max(0, yRes - rect.yMax), rowMax = std::min(yRes - 1, yRes - rect.yMin);
+    if (!isEnabled() || xMin > xMax || rowMin > rowMax)
+        return false;
+
+    int tileFirst = xMin / EDGE_TILE_SIZE, tileLast = xMax / EDGE_TILE_SIZE + 1;
+    int tileRowFirst = rowMin / EDGE_TILE_SIZE, tileRowLast = rowMax / EDGE_TILE_SIZE + 1;
+    unsigned int stride = tilesX + 1;
+
+    return tileSums[tileRowLast * stride + tileLast] + tileSums[tileRowFirst * stride + tileFirst]
+         != tileSums[tileRowFirst * stride + tileLast] + tileSums[tileRowLast * stride + tileFirst];
+}
+
+// Смещение экрана для прохода
+void AdaptiveSampler::getSampleOffset(int pass, double& dx, double& dy){
+    dx = offsets[pass * 2];
+    dy = offsets[pass * 2 + 1];
+}
+
+// Начать проход дополнительного образца
+Drawable* AdaptiveSampler::beginSamplePass(unsigned int backgroundColor){
+    for (auto pixel : edgePixels)
+        sampleImage.colors[pixel] = backgroundColor;
+
+    samplePasses++;
+    return &sampleImage;
+}
+
+// Прибавить образцы прохода к суммам пикселей краев
+void AdaptiveSampler::endSamplePass(){
+    for (unsigned int i = 0; i < edgePixels.size(); i++){
+        unsigned int color = sampleImage.colors[ edgePixels[i] ];
+        sums[i * 3] += (color >> 16) & 0xff;
+        sums[i * 3 + 1] += (color >> 8) & 0xff;
+        sums[i * 3 + 2] += color & 0xff;
+    }
+}
+
+// Записать средние цвета пикселей краев
+void AdaptiveSampler::resolve(Drawable* target){
+    unsigned int samples = samplePasses + 1;
+
+    for (unsigned int i = 0; i < edgePixels.size(); i++){
+        int x = edgePixels[i] % xRes;
+        int row = edgePixels[i] / xRes;
+
+        unsigned int red = (sums[i * 3] + samples / 2) / samples;
+        unsigned int green = (sums[i * 3 + 1] + samples / 2) / samples;
+        unsigned int blue = (sums[i * 3 + 2] + samples / 2) / samples;
+
+        target->setPixel(x, row, (target->getPixel(x, row) & 0xff000000) | (red << 16) | (green << 8) | blue);
+    }
+}
+
+// Сглаженные пиксели
+unsigned int AdaptiveSampler::getEdgePixelCount(){
+    return edgePixels.size();
+}
+
+// Проходы дополнительных образцов
+unsigned int AdaptiveSampler::getSamplePassCount(){
+    return samplePasses;
+}
+
+// Отметить пиксель края, если он в области перерисовки
+void AdaptiveSampler::markEdge(int x, int row, int rowMin, int rowMax, const ScreenRect& scissor){
+    if (x < scissor.xMin || x > scissor.xMax || row < rowMin || row > rowMax)
+        return;
+
+    unsigned int pixel = row * xRes + x;
+    if (edgeMask[pixel] == 0){
+        edgeMask[pixel] = 1;
+        edgePixels.push_back(pixel);
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef ADAPTIVESAMPLER_H
+#define ADAPTIVESAMPLER_H
+
+#include <vector>
+#include "drawable.h"
+#include "dirtyregiontracker.h"
+
+using std::vector;
+
+// Сглаживание краев: дополнительные образцы берутся только для пикселей на краях
+// Первый проход кадра рисует один образец на пиксель и отмечает для каждого пикселя сетку и глубину.
+// Края - пиксели, у которых соседняя сетка другая (силуэты), глубина ломается внутри одной сетки (складки)
+// или цвет заметно отличается от соседнего (границы теней, блики, грани при плоской заливке).
+// Для краев рендерер повторяет растеризацию со смещением экрана на долю пикселя (по одному проходу на образец),
+// освещая только отмеченные пиксели, и усредняет образцы. Смещения - дрожащие точки равномерной сетки внутри пикселя,
+// одинаковые во всех кадрах: неподвижные края не мерцают.
+// Координаты пикселей - координаты поверхности рисования (строка 0 сверху)
+class AdaptiveSampler
+{
+public:
+    // Конструктор
+    AdaptiveSampler();
+
+    // Задать количество образцов на пиксель края и размер растра. 1 = сглаживание выключено
+    void setSampleCount(int newSampleCount, int newXRes, int newYRes);
+
+    // Количество образцов на пиксель края (1 = выключено)
+    int getSampleCount();
+
+    // Сглаживание включено
+    bool isEnabled() const { return sampleCount > 1; }
+
+    // Начать кадр: забыть сетки пикселей области перерисовки
+    void beginFrame(const ScreenRect& scissor);
+
+    // Отметить пиксель первого прохода: номер сетки (0 - фон) и глубина
+    void markCoverage(int x, int row, unsigned int meshId, double depth){
+        unsigned int pixel = row * xRes + x;
+        meshIds[pixel] = meshId;
+        depths[pixel] = (float)depth;
+    }
+
+    // Найти края в области перерисовки по результату первого прохода
+    // Возвращает: прямоугольник краев в координатах рендерера (пустой, если краев нет)
+    ScreenRect findEdges(Drawable* image, const ScreenRect& scissor);
+
+    // Нужен ли пикселю дополнительный образец
+    bool isEdge(int x, int row) const { return edgeMask[row * xRes + x] != 0; }
+
+    // Пиксели краев строки row с x в [xMin, xMax]: номера [first, last) в порядке возрастания x (см. getEdgeX)
+    // Проходы образцов обходят только их, а не всю строку многоугольника
+    void getRowEdges(int row, int xMin, int xMax, unsigned int& first, unsigned int& last) const;
+
+    // Столбец пикселя края с номером edge
+    int getEdgeX(unsigned int edge) const { return edgePixels[edge] % xRes; }
+
+    // Есть ли пиксели краев в прямоугольнике (координаты рендерера, как у области перерисовки)
+    // Проверяется по блокам EDGE_TILE_SIZE x EDGE_TILE_SIZE за O(1): грани, не накрывающие краев, не освещаются в проходах образцов
+    bool hasEdges(const ScreenRect& rect) const;
+
+    // Смещение экрана для прохода pass (1 .. sampleCount - 1), в пикселях
+    void getSampleOffset(int pass, double& dx, double& dy);
+
+    // Начать проход дополнительного образца: пиксели краев закрашиваются цветом фона
+    // Возвращает: поверхность рисования прохода
+    Drawable* beginSamplePass(unsigned int backgroundColor);
+
+    // Прибавить образцы прохода к суммам пикселей краев
+    void endSamplePass();
+
+    // Записать средние цвета пикселей краев
+    void resolve(Drawable* target);
+
+    // Счетчики последнего кадра:
+    unsigned int getEdgePixelCount();       // Сглаженные пиксели
+    unsigned int getSamplePassCount();      // Проходы дополнительных образцов
+
+    // Пороги краев:
+    static constexpr int COLOR_EDGE_THRESHOLD = 24;         // Разница канала цвета соседей, 0..255
+    static constexpr double DEPTH_CREASE_RATIO = 0.002;     // Вторая разность глубины относительно глубины
+    static constexpr int MAX_SAMPLES = 16;
+    static constexpr int EDGE_TILE_SIZE = 8;
+
+private:
+    // Поверхность рисования дополнительного образца: хранит цвета в памяти
+    class SampleImage : public Drawable {
+    public:
+        vector<unsigned int> colors;
+        int width = 0;
+
+        void setPixel(int x, int y, unsigned int color) override { colors[y * width + x] = color; }
+        unsigned int getPixel(int x, int y) override { return colors[y * width + x]; }
+        void updateScreen() override {}
+    };
+
+    int sampleCount;
+    int xRes, yRes;
+
+    vector<unsigned int> meshIds;       // Сетка пикселя первого прохода (номер + 1; 0 - фон)
+    vector<float> depths;               // Глубина пикселя первого прохода
+    vector<unsigned char> edgeMask;     // 1 - пиксель края
+    vector<unsigned int> edgePixels;    // Номера пикселей краев (по возрастанию)
+    vector<unsigned int> rowEdgeStart;  // Номер первого пикселя края каждой строки в edgePixels (yRes + 1)
+    vector<unsigned int> sums;          // Суммы каналов образцов пикселей краев (по 3 на пиксель)
+    vector<unsigned int> tileSums;      // Накопленные суммы количества пикселей краев по блокам ((tilesX + 1) x (tilesY + 1))
+    int tilesX, tilesY;
+    vector<double> offsets;             // Смещения образцов (по 2 на проход)
+    SampleImage sampleImage;
+    unsigned int samplePasses;
+
+    // Отметить пиксель края, если он в области перерисовки
+    void markEdge(int x, int row, int rowMin, int rowMax, const ScreenRect& scissor);
+};
+
+#endif // ADAPTIVESAMPLER_H
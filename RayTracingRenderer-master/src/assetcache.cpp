@@ -0,0 +1,279 @@
+#include "assetcache.h"
+
+#include <iostream>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+
+using std::cout;
+
+// Получить кэш процесса
+AssetCache& AssetCache::getInstance(){
+    static AssetCache theCache;
+    return theCache;
+}
+
+// Конструктор
+AssetCache::AssetCache(){
+    memoryLimit = 0;
+    memoryUsed = 0;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    loadCount = 0;
+    watchFiles = false;
+    watcher = nullptr;
+}
+
+// Деструктор
+// Наблюдатель не удаляется: статический кэш уничтожается после завершения приложения Qt
+AssetCache::~AssetCache(){
+    // Ничего не делает
+}
+
+// Получить сетку файла
+// Файл читается без захвата cacheMutex: остальные файлы в это время берутся из кэша и читаются параллельно.
+// Поток, первым запросивший файл, оставляет в loading обещание результата; остальные запросы того же файла ждут его
+std::shared_ptr<const MeshAsset> AssetCache::getMesh(const string& filename, MeshLoader loadMesh){
+    std::unique_lock<std::mutex> lock(cacheMutex);
+
+    // Пока файлы наблюдаются, действительная запись находится без обращения к диску:
+    if (watchFiles){
+        auto alias = aliases.find(filename);
+        if (alias != aliases.end()){
+            auto found = entries.find(alias->second);
+            if (found != entries.end()){
+                lruOrder.splice(lruOrder.begin(), lruOrder, found->second.lruPosition);
+                hits++;
+                return found->second.asset;
+            }
+        }
+    }
+
+    lock.unlock();
+
+    QFileInfo info(QString::fromStdString(filename));
+    if (!info.exists())
+        return nullptr;
+
+    string key = info.canonicalFilePath().toStdString();
+    long long modifiedTime = info.lastModified().toMSecsSinceEpoch();
+    long long fileSize = info.size();
+
+    lock.lock();
+
+    aliases[filename] = key;
+
+    auto found = entries.find(key);
+    if (found != entries.end()){
+        if (found->second.modifiedTime == modifiedTime && found->second.fileSize == fileSize){
+            lruOrder.splice(lruOrder.begin(), lruOrder, found->second.lruPosition);
+            hits++;
+            return found->second.asset;
+        }
+
+        // Файл изменился: запись устарела
+        removeEntry(found);
+    }
+
+    // Файл уже читает другой поток: ждем его результат
+    auto pending = loading.find(key);
+    if (pending != loading.end()){
+        std::shared_future< std::shared_ptr<const MeshAsset> > result = pending->second;
+        hits++;
+        lock.unlock();
+        return result.get();
+    }
+
+    misses++;
+
+    std::promise< std::shared_ptr<const MeshAsset> > loadPromise;
+    loading[key] = loadPromise.get_future().share();
+    lock.unlock();
+
+    std::shared_ptr<MeshAsset> loaded;
+    try {
+        loaded = loadMesh(filename);
+    }
+    catch (...){
+        // Ожидающие потоки получают то же исключение
+        lock.lock();
+        loading.erase(key);
+        lock.unlock();
+        loadPromise.set_exception(std::current_exception());
+        throw;
+    }
+
+    lock.lock();
+    loading.erase(key);
+
+    if (loaded != nullptr){
+        loaded->version = ++loadCount;
+
+        Entry newEntry;
+        newEntry.asset = loaded;
+        newEntry.modifiedTime = modifiedTime;
+        newEntry.fileSize = fileSize;
+        newEntry.bytes = estimateBytes(*loaded);
+
+        lruOrder.push_front(key);
+        newEntry.lruPosition = lruOrder.begin();
+
+        entries[key] = newEntry;
+        memoryUsed += newEntry.bytes;
+
+        watchPath(key, true);
+
+        evictToLimit();
+    }
+
+    lock.unlock();
+
+    loadPromise.set_value(loaded);
+    return loaded;
+}
+
+// Удалить запись файла
+void AssetCache::invalidate(const string& filename){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    auto found = entries.find(filename);
+    if (found == entries.end()){
+        auto alias = aliases.find(filename);
+        if (alias == aliases.end())
+            return;
+        found = entries.find(alias->second);
+        if (found == entries.end())
+            return;
+    }
+
+    removeEntry(found);
+}
+
+// Удалить все записи
+void AssetCache::clear(){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    while (!entries.empty())
+        removeEntry(entries.begin());
+    aliases.clear();
+}
+
+// Ограничить приблизительный объем памяти записей
+void AssetCache::setMemoryLimit(std::size_t newMemoryLimit){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    memoryLimit = newMemoryLimit;
+    evictToLimit();
+}
+
+// Включить удаление записей при изменении файлов
+void AssetCache::setWatchFiles(bool newWatchFiles){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    watchFiles = newWatchFiles;
+
+    if (watchFiles && watcher == nullptr){
+        watcher = new QFileSystemWatcher();
+        QObject::connect(watcher, &QFileSystemWatcher::fileChanged, [this](const QString& path){
+            invalidate(path.toStdString());
+        });
+
+        for (auto &currentEntry : entries)
+            watcher->addPath(QString::fromStdString(currentEntry.first));
+    }
+    else if (!watchFiles && watcher != nullptr){
+        delete watcher;
+        watcher = nullptr;
+    }
+}
+
+// Вывести статистику кэша
+void AssetCache::debug(){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    cout << "Asset cache:\t" << entries.size() << " meshes\t" << memoryUsed << " bytes";
+    if (memoryLimit > 0)
+        cout << " (limit " << memoryLimit << ")";
+    cout << "\thits: " << hits << "\tmisses: " << misses << "\tevictions: " << evictions << "\n";
+}
+
+// Попадания в кэш
+std::size_t AssetCache::getHits(){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return hits;
+}
+
+// Промахи кэша (чтения файлов)
+std::size_t AssetCache::getMisses(){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return misses;
+}
+
+// Записи, вытесненные ограничением памяти
+std::size_t AssetCache::getEvictions(){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return evictions;
+}
+
+// Приблизительный объем памяти записей
+std::size_t AssetCache::getMemoryUsed(){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return memoryUsed;
+}
+
+// Удалить запись
+void AssetCache::removeEntry(std::map<string, Entry>::iterator theEntry){
+    watchPath(theEntry->first, false);
+
+    memoryUsed -= theEntry->second.bytes;
+    lruOrder.erase(theEntry->second.lruPosition);
+    entries.erase(theEntry);
+}
+
+// Начать или прекратить наблюдение за файлом
+// getMesh и вытеснение выполняются в любом потоке, а QFileSystemWatcher можно использовать только в его потоке:
+// вызов ставится в очередь событий наблюдателя (и отбрасывается, если наблюдатель удален раньше)
+void AssetCache::watchPath(const string& path, bool isWatched){
+    if (watcher == nullptr)
+        return;
+
+    QFileSystemWatcher* theWatcher = watcher;
+    QString watchedPath = QString::fromStdString(path);
+    QMetaObject::invokeMethod(theWatcher, [theWatcher, watchedPath, isWatched](){
+        if (isWatched)
+            theWatcher->addPath(watchedPath);
+        else
+            theWatcher->removePath(watchedPath);
+    }, Qt::QueuedConnection);
+}
+
+// Вытеснить давно не использованные записи до соблюдения ограничения
+// Последняя использованная запись не вытесняется, даже если одна превышает ограничение
+void AssetCache::evictToLimit(){
+    if (memoryLimit == 0)
+        return;
+
+    while (memoryUsed > memoryLimit && lruOrder.size() > 1){
+        removeEntry( entries.find(lruOrder.back()) );
+        evictions++;
+    }
+}
+
+// Приблизительный объем памяти сетки
+std::size_t AssetCache::estimateBytes(const MeshAsset& theAsset){
+    std::size_t result = sizeof(MeshAsset);
+
+    for (const auto &currentFace : theAsset.faces)
+        result += sizeof(Polygon) + currentFace.getVertexCount() * sizeof(Vertex);
+
+    for (const auto &currentLevel : theAsset.levels){
+        for (const auto &currentFace : currentLevel)
+            result += sizeof(Polygon) + currentFace.getVertexCount() * sizeof(Vertex);
+    }
+
+    for (auto &currentBvh : theAsset.bvhs)
+        result += currentBvh.getMemoryUsed();
+
+    return result;
+}
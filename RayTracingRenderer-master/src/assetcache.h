@@ -0,0 +1,113 @@
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "polygon.h"
+#include "meshbvh.h"
+
+using std::string;
+using std::vector;
+
+class QFileSystemWatcher;
+
+// Неизменяемые данные сетки, прочитанные из файла: грани и уровни детализации в пространстве объекта
+struct MeshAsset {
+    vector<Polygon> faces;
+    vector< vector<Polygon> > levels;   // Упрощенные уровни, от более детального к более грубому
+    vector<MeshBvh> bvhs;               // Иерархии граней: [0] - faces, [i] - levels[i - 1]
+    unsigned long long version = 0;     // Номер чтения файла в процессе: у перечитанного после изменения файла он другой
+};
+
+// Кэш сеток, общий для всего процесса
+// Ключ - канонический путь файла; запись действительна, пока не изменились время модификации и размер файла.
+// Пользователи получают shared_ptr на неизменяемые данные: вытеснение или устаревание записи не влияет на уже выданные ссылки.
+// Если включено наблюдение за файлами, изменение файла удаляет запись, и повторные обращения не проверяют файл на диске.
+// Чтение файла не блокирует кэш: одновременные запросы одного файла читают его один раз
+// Размер кэша можно ограничить: при превышении вытесняются записи, которые дольше всего не использовались (LRU)
+class AssetCache
+{
+public:
+    // Получить кэш процесса
+    static AssetCache& getInstance();
+
+    // Функция чтения сетки из файла. Возвращает nullptr, если файл прочитать не удалось
+    typedef std::function< std::shared_ptr<MeshAsset>(const string& filename) > MeshLoader;
+
+    // Получить сетку файла: из кэша, если файл не изменился, иначе прочитанную функцией loadMesh
+    // Возвращает: nullptr, если файл не существует или не прочитан
+    std::shared_ptr<const MeshAsset> getMesh(const string& filename, MeshLoader loadMesh);
+
+    // Удалить запись файла
+    void invalidate(const string& filename);
+
+    // Удалить все записи
+    void clear();
+
+    // Ограничить приблизительный объем памяти записей. 0 = без ограничения
+    void setMemoryLimit(std::size_t newMemoryLimit);
+
+    // Включить удаление записей при изменении файлов (QFileSystemWatcher; требует цикла событий Qt)
+    // Пока наблюдение включено, повторные обращения не проверяют время модификации файла
+    void setWatchFiles(bool newWatchFiles);
+
+    // Вывести статистику кэша
+    void debug();
+
+    // Счетчики:
+    std::size_t getHits();
+    std::size_t getMisses();
+    std::size_t getEvictions();
+    std::size_t getMemoryUsed();
+
+private:
+    // Запись кэша
+    struct Entry {
+        std::shared_ptr<const MeshAsset> asset;
+        long long modifiedTime;             // Время модификации файла, мс
+        long long fileSize;
+        std::size_t bytes;                  // Приблизительный объем данных
+        std::list<string>::iterator lruPosition;
+    };
+
+    std::map<string, Entry> entries;        // По каноническому пути
+    std::map<string, string> aliases;       // Запрошенное имя файла -> канонический путь (для обращений без проверки файла)
+    std::list<string> lruOrder;             // Начало - последняя использованная запись
+    std::map< string, std::shared_future< std::shared_ptr<const MeshAsset> > > loading;   // Файлы, читаемые сейчас (по каноническому пути)
+    std::mutex cacheMutex;
+
+    std::size_t memoryLimit;
+    std::size_t memoryUsed;
+    std::size_t hits, misses, evictions;
+    unsigned long long loadCount;           // Прочитанные файлы: источник версий MeshAsset
+
+    bool watchFiles;
+    QFileSystemWatcher* watcher;
+
+    // Конструктор: кэш создается только через getInstance
+    AssetCache();
+    ~AssetCache();
+    AssetCache(const AssetCache&);
+    AssetCache& operator=(const AssetCache&);
+
+    // Удалить запись. Предварительное условие: cacheMutex захвачен
+    void removeEntry(std::map<string, Entry>::iterator theEntry);
+
+    // Начать или прекратить наблюдение за файлом в потоке наблюдателя. Предварительное условие: cacheMutex захвачен
+    void watchPath(const string& path, bool isWatched);
+
+    // Вытеснить давно не использованные записи до соблюдения ограничения. Предварительное условие: cacheMutex захвачен
+    void evictToLimit();
+
+    // Приблизительный объем памяти сетки
+    static std::size_t estimateBytes(const MeshAsset& theAsset);
+};
+
+#endif // ASSETCACHE_H
@@ -0,0 +1,81 @@
+#include "boundingbox.h"
+
+#include <cmath>
+
+// Подготовить луч
+SlabRay::SlabRay(const Vertex& rayOrigin, const NormalVector& direction){
+    origin[0] = rayOrigin.x;
+    origin[1] = rayOrigin.y;
+    origin[2] = rayOrigin.z;
+
+    // Деление на ноль дает бесконечность нужного знака: луч, параллельный слою, отбрасывается, только если начало вне слоя
+    inverseDirection[0] = 1.0 / direction.xn;
+    inverseDirection[1] = 1.0 / direction.yn;
+    inverseDirection[2] = 1.0 / direction.zn;
+}
+
+// Сбросить в пустой прямоугольник
+void BoundingBox::reset(){
+    *this = BoundingBox();
+}
+
+// Расширить прямоугольник так, чтобы он содержал все вершины многоугольника
+void BoundingBox::add(Polygon& thePolygon){
+    for (int i = 0; i < thePolygon.getVertexCount(); i++)
+        add(thePolygon.vertices[i]);
+}
+
+// Раздвинуть плоские стороны прямоугольника
+// Плоский прямоугольник (например, у сетки из одной плоскости) иначе пропускал бы лучи, идущие вдоль его плоскости
+void BoundingBox::inflateFlatSides(double swell){
+    if (isEmpty())
+        return;
+
+    for (int axis = 0; axis < 3; axis++){
+        if (min[axis] == max[axis]){
+            min[axis] -= swell;
+            max[axis] += swell;
+        }
+    }
+}
+
+// Раздвинуть все стороны прямоугольника
+void BoundingBox::inflate(double margin){
+    if (isEmpty())
+        return;
+
+    for (int axis = 0; axis < 3; axis++){
+        min[axis] -= margin;
+        max[axis] += margin;
+    }
+}
+
+// Площадь поверхности
+double BoundingBox::getSurfaceArea() const {
+    if (isEmpty())
+        return 0;
+
+    double dx = max[0] - min[0];
+    double dy = max[1] - min[1];
+    double dz = max[2] - min[2];
+    return 2 * (dx * dy + dy * dz + dz * dx);
+}
+
+// Длина диагонали
+double BoundingBox::getDiagonal() const {
+    if (isEmpty())
+        return 0;
+
+    return std::sqrt( (max[0] - min[0]) * (max[0] - min[0]) + (max[1] - min[1]) * (max[1] - min[1]) + (max[2] - min[2]) * (max[2] - min[2]) );
+}
+
+// Получить угол прямоугольника
+Vertex BoundingBox::getCorner(int cornerIndex) const {
+    return Vertex( (cornerIndex & 1) ? max[0] : min[0], (cornerIndex & 2) ? max[1] : min[1], (cornerIndex & 4) ? max[2] : min[2] );
+}
+
+// Ограничивающая сфера, описанная вокруг прямоугольника
+void BoundingBox::getBoundingSphere(Vertex& center, double& radius) const {
+    center = Vertex( (min[0] + max[0]) / 2.0, (min[1] + max[1]) / 2.0, (min[2] + max[2]) / 2.0 );
+    radius = std::sqrt( (max[0] - center.x) * (max[0] - center.x) + (max[1] - center.y) * (max[1] - center.y) + (max[2] - center.z) * (max[2] - center.z) );
+}
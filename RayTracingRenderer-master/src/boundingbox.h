@@ -0,0 +1,96 @@
+#ifndef BOUNDINGBOX_H
+#define BOUNDINGBOX_H
+
+#include <limits>
+#include "vertex.h"
+#include "normalvector.h"
+#include "polygon.h"
+
+// Луч, подготовленный для проверки по слоям ограничивающих прямоугольников
+// Обратные компоненты направления вычисляются один раз на луч, проверка прямоугольника - умножения и сравнения
+struct SlabRay {
+    double origin[3];
+    double inverseDirection[3];     // 1 / направление; для нулевой компоненты - бесконечность
+
+    // Расстояния вдоль луча измеряются в длинах direction: для нормализованного направления - в единицах пространства.
+    // Аффинное преобразование начала и направления луча сохраняет эти расстояния
+    SlabRay(const Vertex& rayOrigin, const NormalVector& direction);
+};
+
+// Ограничивающий прямоугольник, выровненный по осям
+struct BoundingBox {
+    double min[3] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+    double max[3] = { -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+
+    bool isEmpty() const { return max[0] < min[0]; }
+
+    // Сбросить в пустой прямоугольник
+    void reset();
+
+    // Расширить прямоугольник так, чтобы он содержал точку
+    void add(const Vertex& point){
+        if (point.x < min[0]) min[0] = point.x;
+        if (point.x > max[0]) max[0] = point.x;
+        if (point.y < min[1]) min[1] = point.y;
+        if (point.y > max[1]) max[1] = point.y;
+        if (point.z < min[2]) min[2] = point.z;
+        if (point.z > max[2]) max[2] = point.z;
+    }
+
+    // Расширить прямоугольник так, чтобы он содержал другой
+    void add(const BoundingBox& other){
+        for (int axis = 0; axis < 3; axis++){
+            if (other.min[axis] < min[axis]) min[axis] = other.min[axis];
+            if (other.max[axis] > max[axis]) max[axis] = other.max[axis];
+        }
+    }
+
+    // Расширить прямоугольник так, чтобы он содержал все вершины многоугольника
+    void add(Polygon& thePolygon);
+
+    // Раздвинуть все стороны прямоугольника на margin
+    void inflate(double margin);
+
+    // Площадь поверхности (0 для пустого прямоугольника)
+    double getSurfaceArea() const;
+
+    // Длина диагонали (0 для пустого прямоугольника)
+    double getDiagonal() const;
+
+    // Раздвинуть плоские стороны прямоугольника на swell в обе стороны
+    void inflateFlatSides(double swell);
+
+    // Получить угол прямоугольника: биты номера выбирают max (1) или min (0) по x, y, z
+    Vertex getCorner(int cornerIndex) const;
+
+    // Ограничивающая сфера, описанная вокруг прямоугольника
+    void getBoundingSphere(Vertex& center, double& radius) const;
+
+    // Проверка слоев: пересекает ли луч прямоугольник на отрезке [0, maxDistance]
+    // Начало луча внутри прямоугольника считается пересечением. NaN (начало на плоскости при нулевой компоненте) не отбрасывает луч
+    bool intersectsRay(const SlabRay& theRay, double maxDistance) const {
+        double nearDistance = 0;
+        double farDistance = maxDistance;
+
+        for (int axis = 0; axis < 3; axis++){
+            double t1 = (min[axis] - theRay.origin[axis]) * theRay.inverseDirection[axis];
+            double t2 = (max[axis] - theRay.origin[axis]) * theRay.inverseDirection[axis];
+            if (t1 > t2){
+                double swap = t1;
+                t1 = t2;
+                t2 = swap;
+            }
+
+            if (t1 > nearDistance)
+                nearDistance = t1;
+            if (t2 < farDistance)
+                farDistance = t2;
+            if (nearDistance > farDistance)
+                return false;
+        }
+
+        return true;
+    }
+};
+
+#endif // BOUNDINGBOX_H
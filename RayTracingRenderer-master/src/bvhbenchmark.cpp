@@ -0,0 +1,246 @@
+#define _USE_MATH_DEFINES       // Allow use of M_PI (3.14159265358979323846); before all includes, since headers may include <cmath> first
+#include "bvhbenchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "fileinterpreter.h"
+#include "objloader.h"
+
+using std::chrono::high_resolution_clock;
+using std::chrono::duration;
+using std::cout;
+
+// Конструктор
+BvhBenchmark::BvhBenchmark(){
+    threadCount = 0;
+    rayCount = DEFAULT_RAY_COUNT;
+}
+
+// Добавить сетки сцены
+void BvhBenchmark::addSceneMeshes(string sceneFile){
+    FileInterpreter theInterpreter;
+    theInterpreter.setSceneFilename(sceneFile);
+
+    Scene theScene = theInterpreter.buildSceneFromFile(0, 0, 0, 1, -4.05);
+    for (unsigned int i = 0; i < theScene.theMeshes.size(); i++){
+        if (theScene.theMeshes[i].faces.empty())
+            continue;
+
+        meshes.emplace_back();
+        meshes.back().name = sceneFile + " mesh " + std::to_string(i);
+        meshes.back().faces = theScene.theMeshes[i].faces;
+    }
+}
+
+// Добавить сетку файла obj
+void BvhBenchmark::addObjFile(string filename){
+    ObjLoader theLoader;
+    vector<Polygon> faces = theLoader.load(filename);
+    if (faces.empty()){
+        cout << "Could not read " << filename << "\n";
+        return;
+    }
+
+    meshes.emplace_back();
+    meshes.back().name = filename;
+    meshes.back().faces.swap(faces);
+}
+
+// Добавить сгенерированные сетки
+void BvhBenchmark::addGeneratedMeshes(){
+    // Сфера: равномерная по углам сетка, треугольники сгущаются у полюсов
+    meshes.emplace_back();
+    meshes.back().name = "generated sphere";
+    vector<Polygon>& sphereFaces = meshes.back().faces;
+
+    unsigned int rings = SPHERE_SEGMENTS / 2;
+    auto spherePoint = [rings](unsigned int segment, unsigned int ring){
+        double theta = M_PI * ring / rings;
+        double phi = 2 * M_PI * segment / SPHERE_SEGMENTS;
+        return Vertex(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+    };
+
+    sphereFaces.reserve(2 * SPHERE_SEGMENTS * rings);
+    for (unsigned int ring = 0; ring < rings; ring++){
+        for (unsigned int segment = 0; segment < SPHERE_SEGMENTS; segment++){
+            Vertex p00 = spherePoint(segment, ring), p10 = spherePoint(segment + 1, ring);
+            Vertex p01 = spherePoint(segment, ring + 1), p11 = spherePoint(segment + 1, ring + 1);
+            sphereFaces.emplace_back(p00, p01, p11);
+            sphereFaces.emplace_back(p00, p11, p10);
+        }
+    }
+
+    // Облако случайных треугольников разного размера в кубе: худший случай для деления по медиане
+    meshes.emplace_back();
+    meshes.back().name = "generated random triangles";
+    vector<Polygon>& randomFaces = meshes.back().faces;
+
+    std::mt19937 generator(361);
+    std::uniform_real_distribution<double> position(-1.0, 1.0);
+    std::exponential_distribution<double> size(40.0);
+
+    randomFaces.reserve(RANDOM_TRIANGLES);
+    for (unsigned int i = 0; i < RANDOM_TRIANGLES; i++){
+        Vertex center(position(generator), position(generator), position(generator));
+        double scale = size(generator);
+        Vertex p0(center.x + scale * position(generator), center.y + scale * position(generator), center.z + scale * position(generator));
+        Vertex p1(center.x + scale * position(generator), center.y + scale * position(generator), center.z + scale * position(generator));
+        Vertex p2(center.x + scale * position(generator), center.y + scale * position(generator), center.z + scale * position(generator));
+        randomFaces.emplace_back(p0, p1, p2);
+    }
+}
+
+// Ограничить количество потоков параллельного построения
+void BvhBenchmark::setThreadCount(unsigned int newThreadCount){
+    threadCount = newThreadCount;
+}
+
+// Задать количество лучей на сетку
+void BvhBenchmark::setRayCount(unsigned int newRayCount){
+    rayCount = newRayCount;
+}
+
+// Выполнить измерения и вывести таблицу
+void BvhBenchmark::run(){
+    unsigned int threads = (threadCount > 0) ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+    cout << "BVH benchmark: " << meshes.size() << " meshes, " << rayCount << " rays each, " << threads << " build threads\n";
+    cout << std::fixed << std::setprecision(2);
+
+    for (auto &currentMesh : meshes)
+        runMesh(currentMesh);
+}
+
+// Измерить одну сетку
+void BvhBenchmark::runMesh(BenchmarkMesh& theMesh){
+    MeshBvh medianBvh, sahBvh;
+
+    double medianMilliseconds = timeBuild(medianBvh, theMesh.faces, medianSplit, 1);
+    double sahMilliseconds = timeBuild(sahBvh, theMesh.faces, sahSplit, 1);
+    double parallelMilliseconds = timeBuild(sahBvh, theMesh.faces, sahSplit, threadCount);
+
+    // Лучи: из точек сферы, описанной вокруг сетки с запасом, к случайным точкам ее прямоугольника
+    BoundingBox bounds;
+    for (auto &currentFace : theMesh.faces)
+        bounds.add(currentFace);
+
+    Vertex center;
+    double radius;
+    bounds.getBoundingSphere(center, radius);
+    radius = 2 * radius + 1e-9;
+
+    std::mt19937 generator(1);
+    std::normal_distribution<double> gaussian;
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    vector<double> rays(rayCount * 6);
+    for (unsigned int i = 0; i < rayCount; i++){
+        double* ray = &rays[i * 6];
+
+        double sphereDirection[3] = { gaussian(generator), gaussian(generator), gaussian(generator) };
+        double sphereLength = std::sqrt(sphereDirection[0] * sphereDirection[0] + sphereDirection[1] * sphereDirection[1] + sphereDirection[2] * sphereDirection[2]) + 1e-12;
+        ray[0] = center.x + radius * sphereDirection[0] / sphereLength;
+        ray[1] = center.y + radius * sphereDirection[1] / sphereLength;
+        ray[2] = center.z + radius * sphereDirection[2] / sphereLength;
+
+        double length = 0;
+        for (int axis = 0; axis < 3; axis++){
+            ray[3 + axis] = bounds.min[axis] + unit(generator) * (bounds.max[axis] - bounds.min[axis]) - ray[axis];
+            length += ray[3 + axis] * ray[3 + axis];
+        }
+        length = std::sqrt(length);
+        for (int axis = 0; axis < 3; axis++)
+            ray[3 + axis] /= length;
+    }
+
+    TraceResult medianResult = traceRays(medianBvh, theMesh.faces, rays);
+    TraceResult sahResult = traceRays(sahBvh, theMesh.faces, rays);
+
+    cout << "\n" << theMesh.name << ": " << theMesh.faces.size() << " faces\n";
+    cout << "  median:\tbuild " << medianMilliseconds << "ms\tnodes " << medianBvh.getNodeCount() << "\tdepth " << medianBvh.getDepth()
+         << "\tSAH cost " << medianBvh.getSahCost() << "\trays " << medianResult.milliseconds << "ms\tbox tests/ray " << (double)medianResult.boxTests / std::max(1u, rayCount) << "\tface tests/ray " << (double)medianResult.faceTests / std::max(1u, rayCount) << "\n";
+    cout << "  SAH:\t\tbuild " << sahMilliseconds << "ms (parallel " << parallelMilliseconds << "ms)\tnodes " << sahBvh.getNodeCount() << "\tdepth " << sahBvh.getDepth()
+         << "\tSAH cost " << sahBvh.getSahCost() << "\trays " << sahResult.milliseconds << "ms\tbox tests/ray " << (double)sahResult.boxTests / std::max(1u, rayCount) << "\tface tests/ray " << (double)sahResult.faceTests / std::max(1u, rayCount) << "\n";
+
+    if (medianResult.hits != sahResult.hits || std::fabs(medianResult.hitDistanceSum - sahResult.hitDistanceSum) > 1e-6 * (1 + medianResult.hitDistanceSum))
+        cout << "  Warning: hierarchies disagree (" << medianResult.hits << " vs " << sahResult.hits << " hits)\n";
+}
+
+// Построить иерархию и вернуть время построения
+double BvhBenchmark::timeBuild(MeshBvh& theBvh, vector<Polygon>& faces, BvhSplitMethod method, unsigned int maxThreads){
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    theBvh.build(faces, method, maxThreads);
+    return duration<double, std::milli>( high_resolution_clock::now() - t1 ).count();
+}
+
+// Трассировать лучи до ближайшего пересечения
+BvhBenchmark::TraceResult BvhBenchmark::traceRays(const MeshBvh& theBvh, vector<Polygon>& faces, const vector<double>& rays){
+    TraceResult result;
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+
+    for (std::size_t i = 0; i + 6 <= rays.size(); i += 6){
+        const double* origin = &rays[i];
+        const double* direction = &rays[i + 3];
+
+        SlabRay theRay( Vertex(origin[0], origin[1], origin[2]), NormalVector(direction[0], direction[1], direction[2]) );
+        double hitDistance = std::numeric_limits<double>::max();
+
+        theBvh.traverse(theRay, hitDistance, [&](unsigned int face){
+            result.faceTests++;
+            double distance;
+            if (intersectFace(faces[face], origin, direction, hitDistance, distance))
+                hitDistance = distance;
+            return false;
+        }, result.boxTests);
+
+        if (hitDistance < std::numeric_limits<double>::max()){
+            result.hits++;
+            result.hitDistanceSum += hitDistance;
+        }
+    }
+
+    result.milliseconds = duration<double, std::milli>( high_resolution_clock::now() - t1 ).count();
+    return result;
+}
+
+// Пересечение луча с гранью: тест Моллера - Трумбора для каждого треугольника веера
+bool BvhBenchmark::intersectFace(Polygon& theFace, const double* origin, const double* direction, double maxDistance, double& distance){
+    bool isHit = false;
+    const Vertex& p0 = theFace.vertices[0];
+
+    for (int i = 1; i + 1 < theFace.getVertexCount(); i++){
+        const Vertex& p1 = theFace.vertices[i];
+        const Vertex& p2 = theFace.vertices[i + 1];
+
+        double edge1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+        double edge2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+        double p[3] = { direction[1] * edge2[2] - direction[2] * edge2[1], direction[2] * edge2[0] - direction[0] * edge2[2], direction[0] * edge2[1] - direction[1] * edge2[0] };
+
+        double determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+        if (std::fabs(determinant) < 1e-15)
+            continue;
+        double inverseDeterminant = 1.0 / determinant;
+
+        double s[3] = { origin[0] - p0.x, origin[1] - p0.y, origin[2] - p0.z };
+        double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverseDeterminant;
+        if (u < 0 || u > 1)
+            continue;
+
+        double q[3] = { s[1] * edge1[2] - s[2] * edge1[1], s[2] * edge1[0] - s[0] * edge1[2], s[0] * edge1[1] - s[1] * edge1[0] };
+        double v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverseDeterminant;
+        if (v < 0 || u + v > 1)
+            continue;
+
+        double t = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) * inverseDeterminant;
+        if (t > 0 && t < maxDistance){
+            maxDistance = t;
+            distance = t;
+            isHit = true;
+        }
+    }
+
+    return isHit;
+}
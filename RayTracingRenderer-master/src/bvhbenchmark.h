@@ -0,0 +1,78 @@
+#ifndef BVHBENCHMARK_H
+#define BVHBENCHMARK_H
+
+#include <string>
+#include <vector>
+#include "polygon.h"
+#include "meshbvh.h"
+
+using std::string;
+using std::vector;
+
+// Сравнение способов построения MeshBvh (деление по медиане и binned SAH) без интерфейса
+// Для каждой сетки измеряются время построения в одном и во всех потоках, количество узлов, глубина, оценка стоимости SAH,
+// а затем время трассировки одного и того же набора случайных лучей (ближайшее пересечение) через обе иерархии.
+// Сетки: грани сцены .simp, файлы obj и сгенерированные нагрузочные сетки
+class BvhBenchmark
+{
+public:
+    // Конструктор
+    BvhBenchmark();
+
+    // Добавить сетки сцены (в мировом пространстве, положение маятника по умолчанию)
+    void addSceneMeshes(string sceneFile);
+
+    // Добавить сетку файла obj
+    void addObjFile(string filename);
+
+    // Добавить сгенерированные сетки: мелко разбитую сферу и облако случайных треугольников
+    void addGeneratedMeshes();
+
+    // Ограничить количество потоков параллельного построения. 0 = по количеству ядер
+    void setThreadCount(unsigned int newThreadCount);
+
+    // Задать количество лучей на сетку
+    void setRayCount(unsigned int newRayCount);
+
+    // Выполнить измерения и вывести таблицу
+    void run();
+
+    static const unsigned int DEFAULT_RAY_COUNT = 100000;
+    static const unsigned int SPHERE_SEGMENTS = 360;        // Сфера: 2 * 360 * 180 треугольников
+    static const unsigned int RANDOM_TRIANGLES = 200000;    // Облако случайных треугольников
+
+private:
+    // Сетка для измерений
+    struct BenchmarkMesh {
+        string name;
+        vector<Polygon> faces;
+    };
+
+    // Результат трассировки набора лучей
+    struct TraceResult {
+        double milliseconds = 0;
+        unsigned long long boxTests = 0;    // Проверки прямоугольников узлов
+        unsigned long long faceTests = 0;   // Проверки граней
+        unsigned int hits = 0;              // Лучи, попавшие в сетку
+        double hitDistanceSum = 0;          // Для сверки двух иерархий
+    };
+
+    vector<BenchmarkMesh> meshes;
+    unsigned int threadCount;
+    unsigned int rayCount;
+
+    // Измерить одну сетку
+    void runMesh(BenchmarkMesh& theMesh);
+
+    // Построить иерархию и вернуть время построения, мс
+    static double timeBuild(MeshBvh& theBvh, vector<Polygon>& faces, BvhSplitMethod method, unsigned int maxThreads);
+
+    // Трассировать лучи (начало, направление по 6 чисел на луч) до ближайшего пересечения
+    static TraceResult traceRays(const MeshBvh& theBvh, vector<Polygon>& faces, const vector<double>& rays);
+
+    // Пересечение луча с гранью (веер треугольников от первой вершины)
+    // Возвращает: true и расстояние вдоль луча, если пересечение ближе maxDistance
+    static bool intersectFace(Polygon& theFace, const double* origin, const double* direction, double maxDistance, double& distance);
+};
+
+#endif // BVHBENCHMARK_H
@@ -1,5 +1,6 @@
 #include "client.h"
 #include "renderer.h"
+#include "sequencerenderer.h"
 
 #include <cstdlib>              // Used for the rand() function
 #include <ctime>                // Used to seed the rand() function
@@ -36,9 +37,12 @@ Client::Client(){
 }
 
 // Конструктор
-Client::Client(Drawable *drawable){
+Client::Client(Drawable *drawable, int xRes, int yRes){
 
     this->drawable = drawable;
+    this->xRes = xRes;
+    this->yRes = yRes;
+    targetFrameTime = 0;
 
     clientRenderer = new Renderer(this->drawable, xRes, yRes, PANEL_BORDER_WIDTH);
 
@@ -50,6 +54,51 @@ Client::Client(Drawable *drawable){
     filename = "";
 }
 
+// Выбрать растеризатор заполненных треугольников
+void Client::setRasterizer(RasterizerType newRasterizer){
+    clientRenderer->setRasterizer(newRasterizer);
+}
+
+// Выбрать модель зеркального отражения
+void Client::setSpecularModel(SpecularModel newModel){
+    clientRenderer->setSpecularModel(newModel);
+}
+
+// Перерисовывать только изменившиеся области
+void Client::setDirtyRegionsEnabled(bool isEnabled){
+    clientRenderer->setDirtyRegionsEnabled(isEnabled);
+}
+
+// Запекать тени неподвижных сеток
+void Client::setBakedLightingEnabled(bool isEnabled){
+    clientRenderer->setBakedLightingEnabled(isEnabled);
+}
+
+// Сглаживать края дополнительными образцами
+void Client::setAntiAliasingSamples(int samplesPerPixel){
+    clientRenderer->setAntiAliasingSamples(samplesPerPixel);
+}
+
+// Масштабировать внутреннее разрешение страниц
+void Client::setRenderScale(double scale){
+    clientRenderer->setRenderScale(scale);
+}
+
+// Выбрать фильтр увеличения страниц
+void Client::setUpscaleFilter(UpscaleFilter newFilter){
+    clientRenderer->setUpscaleFilter(newFilter);
+}
+
+// Подбирать масштаб разрешения под время страницы
+void Client::setTargetFrameTime(double targetMilliseconds){
+    targetFrameTime = targetMilliseconds;
+}
+
+// Выбрать файл описания сцены
+void Client::setSceneFile(string newSceneFile){
+    clientFileInterpreter.setSceneFilename(newSceneFile);
+}
+
 // Отобразить следующую сцену
 void Client::nextPage(double latitude, double xCam, double yCam, double zCam)
 {
@@ -63,6 +112,8 @@ void Client::nextPage(double latitude, double xCam, double yCam, double zCam)
 
         t1 = high_resolution_clock::now();
 
+        // Счетчики памяти кадра включают чтение сцены и ее копирование
+        MemoryStatistics::beginFrame();
         theScene = clientFileInterpreter.buildSceneFromFile(0, 0, 0, 1, -4.05);
         clientRenderer->drawRectangle(0, 2, 0.01, 0, 0xff808080);
 
@@ -71,10 +122,18 @@ void Client::nextPage(double latitude, double xCam, double yCam, double zCam)
         cout << "File read in:\t" << duration << "ms\n";
 
         t1 = high_resolution_clock::now();
-        clientRenderer->renderScene(theScene);
+        {
+            // Копия сцены, передаваемая по значению, учитывается как память сцены
+            MEMORY_SCOPE(sceneMemory);
+            clientRenderer->renderScene(theScene);
+        }
         t2 = high_resolution_clock::now();
         duration = duration_cast<microseconds>( t2 - t1 ).count();
-        cout << "Mesh drawn in:\t" << duration << "ms\n\n";
+        cout << "Mesh drawn in:\t" << duration << "ms\n";
+        clientRenderer->getFrameStatistics().debug();
+        MemoryStatistics::debug();
+        AssetCache::getInstance().debug();
+        cout << "\n";
         pageNumber++;
     }
     else
@@ -88,8 +147,29 @@ void Client::nextPage(double latitude, double xCam, double yCam, double zCam)
         animation(latitude);
         Scene cmdLineScene;
         std::string no = std::to_string(pageNumber);
+        MemoryStatistics::beginFrame();
         cmdLineScene = clientFileInterpreter.buildSceneFromFile(x, y, xCam, yCam, zCam);
-        clientRenderer->renderScene(cmdLineScene);
+
+        high_resolution_clock::time_point t1 = high_resolution_clock::now();
+        {
+            MEMORY_SCOPE(sceneMemory);
+            clientRenderer->renderScene(cmdLineScene);
+        }
+        auto duration = duration_cast<microseconds>( high_resolution_clock::now() - t1 ).count();
+        cout << "Mesh drawn in:\t" << duration << "ms\n";
+        clientRenderer->getFrameStatistics().debug();
+
+        // Время отрисовки пропорционально количеству пикселей, то есть квадрату масштаба.
+        // Учитываются только страницы, перерисованные целиком; масштаб меняется, только если время отличается от заданного
+        // больше чем на 10%: смена масштаба перерисовывает следующую страницу целиком
+        RenderStatistics& pageStatistics = clientRenderer->getFrameStatistics();
+        if (targetFrameTime > 0 && duration > 0 && pageStatistics.redrawnPixels == pageStatistics.screenPixels){
+            double frameTime = duration / 1000.0;
+            if (std::fabs(frameTime - targetFrameTime) > 0.1 * targetFrameTime)
+                clientRenderer->setRenderScale(clientRenderer->getRenderScale() * std::sqrt(targetFrameTime / frameTime));
+        }
+        MemoryStatistics::debug();
+        AssetCache::getInstance().debug();
         drawable->updateScreen();
         pageNumber++;
 
@@ -99,15 +179,6 @@ void Client::nextPage(double latitude, double xCam, double yCam, double zCam)
 double Client::animation(double latitude)
 {
     t++;
-    double a = 0.9;
-    if (latitude == 90 || latitude == 180)
-        latitude = 89.9999;
-    // double omega1 = (15*PI/180)*sin((latitude*3.14)/180);
-    double omega1 = 0.075;
-    //double omega1 = 0.0000727;
-
-    double omega2 = 1;
-    x = a * cos(omega2*t) * sin(omega1* t);
-    y = a * cos(omega2*t) * cos(omega1* t);
-
+    SequenceRenderer::getPendulumPosition(latitude, t, x, y);
+    return x;
 }
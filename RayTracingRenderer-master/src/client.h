@@ -15,8 +15,8 @@ public:
     // Default constructor
     Client();
 
-    // Constructor
-    Client(Drawable *drawable);
+    // Constructor: the drawable is xRes x yRes pixels
+    Client(Drawable *drawable, int xRes, int yRes);
 
     // Command Line Constructor:
     Client(Drawable *drawable, string filename);
@@ -26,6 +26,33 @@ public:
 
     double animation(double latitude);
 
+    // Select the rasterizer used for filled triangles
+    void setRasterizer(RasterizerType newRasterizer);
+
+    // Select how the specular term is evaluated
+    void setSpecularModel(SpecularModel newModel);
+
+    // Redraw only the screen regions that changed since the previous page
+    void setDirtyRegionsEnabled(bool isEnabled);
+
+    // Bake the shadows that static meshes cast from the lights instead of tracing them every page
+    void setBakedLightingEnabled(bool isEnabled);
+
+    // Take samplesPerPixel samples on edge pixels only (1 = no anti-aliasing)
+    void setAntiAliasingSamples(int samplesPerPixel);
+
+    // Render pages at scale x the window resolution and upscale them (1 = native resolution)
+    void setRenderScale(double scale);
+
+    // Select the filter used to upscale pages rendered below the window resolution
+    void setUpscaleFilter(UpscaleFilter newFilter);
+
+    // Adjust the render scale after every page so that pages take about targetMilliseconds (0 = keep the scale fixed)
+    void setTargetFrameTime(double targetMilliseconds);
+
+    // Select the .simp scene description file to render
+    void setSceneFile(string newSceneFile);
+
 private:
     // Client variables and parameters:
     // ********************************
@@ -35,8 +62,10 @@ private:
     FileInterpreter clientFileInterpreter;  // The file interpreter
 
     // Render window x, y resolution (in px):
-    const int xRes = 1000; // Must be the same as the values in renderarea361.cpp
-    const int yRes = 1000;
+    int xRes;
+    int yRes;
+
+    double targetFrameTime;     // Page time the render scale is adjusted to (ms), 0 = fixed scale
 
     const int PANEL_BORDER_WIDTH = 1;  // The width of the panel borders. Must be > 0 ????????????????
 
@@ -0,0 +1,361 @@
+#include "dirtyregiontracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "normalvector.h"
+#include "renderutilities.h"
+
+// Поля на границах экранных прямоугольников: покрывают округление растеризатора
+static const int RECT_MARGIN = 2;
+
+// Расширить прямоугольник так, чтобы он содержал other
+void ScreenRect::add(const ScreenRect& other){
+    if (other.isEmpty())
+        return;
+
+    if (isEmpty()){
+        *this = other;
+        return;
+    }
+
+    xMin = std::min(xMin, other.xMin);
+    yMin = std::min(yMin, other.yMin);
+    xMax = std::max(xMax, other.xMax);
+    yMax = std::max(yMax, other.yMax);
+}
+
+// Обрезать прямоугольник по другому
+void ScreenRect::clip(const ScreenRect& other){
+    xMin = std::max(xMin, other.xMin);
+    yMin = std::max(yMin, other.yMin);
+    xMax = std::min(xMax, other.xMax);
+    yMax = std::min(yMax, other.yMax);
+}
+
+// Количество пикселей
+long long ScreenRect::getArea() const {
+    if (isEmpty())
+        return 0;
+    return (long long)(xMax - xMin + 1) * (yMax - yMin + 1);
+}
+
+// Конструктор
+DirtyRegionTracker::DirtyRegionTracker(){
+    isTrackerEnabled = true;
+    hasPreviousFrame = false;
+    previousSceneSignature = 0;
+}
+
+// Включить / выключить отслеживание
+void DirtyRegionTracker::setEnabled(bool newIsEnabled){
+    isTrackerEnabled = newIsEnabled;
+    hasPreviousFrame = false;
+}
+
+bool DirtyRegionTracker::isEnabled(){
+    return isTrackerEnabled;
+}
+
+// Забыть предыдущий кадр
+void DirtyRegionTracker::invalidate(){
+    hasPreviousFrame = false;
+}
+
+// Вычислить область перерисовки кадра
+ScreenRect DirtyRegionTracker::update(Scene& theScene, TransformationMatrix* cameraToPerspective, TransformationMatrix* perspectiveToScreen, int xRes, int yRes){
+
+    // Экран в координатах рендерера: строка y выводится в строку yRes - y изображения
+    ScreenRect screen;
+    screen.xMin = 0;
+    screen.yMin = 1;
+    screen.xMax = xRes - 1;
+    screen.yMax = yRes;
+
+    if (!isTrackerEnabled){
+        hasPreviousFrame = false;
+        return screen;
+    }
+
+    unsigned long long sceneSignature = getSceneSignature(theScene, xRes, yRes);
+
+    currentMeshes.resize(theScene.theMeshes.size());
+    for (unsigned int i = 0; i < theScene.theMeshes.size(); i++)
+        measureMesh(theScene.theMeshes[i], i, theScene, cameraToPerspective, perspectiveToScreen, screen, currentMeshes[i]);
+
+    ScreenRect region;
+
+    if (!hasPreviousFrame || sceneSignature != previousSceneSignature || previousMeshes.size() != currentMeshes.size()){
+        region = screen;
+    }
+    else {
+        bool hasChanges = false;
+
+        for (unsigned int i = 0; i < currentMeshes.size(); i++){
+            if (currentMeshes[i].signature == previousMeshes[i].signature)
+                continue;
+
+            hasChanges = true;
+
+            // Сетка исчезает со старого места и появляется на новом:
+            region.add(previousMeshes[i].rect);
+            region.add(currentMeshes[i].rect);
+
+            // Тени старого и нового положения:
+            if (!theScene.noRayShadows){
+                addShadowRegion(previousMeshes[i].center, previousMeshes[i].radius, i, theScene, cameraToPerspective, perspectiveToScreen, screen, region);
+                addShadowRegion(currentMeshes[i].center, currentMeshes[i].radius, i, theScene, cameraToPerspective, perspectiveToScreen, screen, region);
+            }
+        }
+
+        // Отраженный луч может попасть в изменившуюся сетку из любой точки отражающей поверхности:
+        if (hasChanges && theScene.numRayBounces > 0){
+            for (auto &currentMesh : currentMeshes){
+                if (currentMesh.isReflective)
+                    region.add(currentMesh.rect);
+            }
+        }
+    }
+
+    region.clip(screen);
+
+    previousMeshes = currentMeshes;
+    previousSceneSignature = sceneSignature;
+    hasPreviousFrame = true;
+
+    return region;
+}
+
+// Экранный прямоугольник сетки текущего кадра
+const ScreenRect& DirtyRegionTracker::getMeshRect(unsigned int meshIndex){
+    return currentMeshes[meshIndex].rect;
+}
+
+// Подпись настроек сцены, влияющих на все пиксели
+unsigned long long DirtyRegionTracker::getSceneSignature(Scene& theScene, int xRes, int yRes){
+    unsigned long long signature = HASH_SEED;
+
+    hashValue(signature, (unsigned long long)xRes);
+    hashValue(signature, (unsigned long long)yRes);
+
+    for (auto &currentLight : theScene.theLights){
+        hashValue(signature, currentLight.position.x);
+        hashValue(signature, currentLight.position.y);
+        hashValue(signature, currentLight.position.z);
+        hashValue(signature, currentLight.redIntensity);
+        hashValue(signature, currentLight.greenIntensity);
+        hashValue(signature, currentLight.blueIntensity);
+        hashValue(signature, currentLight.attenuationA);
+        hashValue(signature, currentLight.attenuationB);
+    }
+
+    double settings[] = {
+        theScene.ambientRedIntensity, theScene.ambientGreenIntensity, theScene.ambientBlueIntensity,
+        theScene.xLow, theScene.xHigh, theScene.yLow, theScene.yHigh, theScene.camHither, theScene.camYon,
+        theScene.fogHither, theScene.fogYon, theScene.fogRedIntensity, theScene.fogGreenIntensity, theScene.fogBlueIntensity,
+        theScene.lodPixelsPerFace, theScene.lodHysteresis, theScene.minLightContribution
+    };
+    for (double currentSetting : settings)
+        hashValue(signature, currentSetting);
+
+    hashValue(signature, (unsigned long long)theScene.fogColor);
+    hashValue(signature, (unsigned long long)theScene.isDepthFogged);
+    hashValue(signature, (unsigned long long)theScene.environmentColor);
+    hashValue(signature, (unsigned long long)theScene.numRayBounces);
+    hashValue(signature, (unsigned long long)theScene.noRayShadows);
+    hashValue(signature, (unsigned long long)theScene.rayLodLevel);
+
+    return signature;
+}
+
+// Подпись, ограничивающий прямоугольник и экранный прямоугольник сетки
+// Вершины не обходятся: подпись - версия граней и накопленное преобразование сетки, а прямоугольник сетки
+// (всех уровней детализации) пересчитывается при каждом ее преобразовании. Грани просматриваются, только когда изменилась версия
+void DirtyRegionTracker::measureMesh(Mesh& theMesh, unsigned int meshIndex, Scene& theScene, TransformationMatrix* cameraToPerspective, TransformationMatrix* perspectiveToScreen, const ScreenRect& screen, MeshState& result){
+    result.signature = HASH_SEED;
+    result.rect = ScreenRect();
+
+    hashValue(result.signature, (unsigned long long)theMesh.isWireframe);
+    hashValue(result.signature, theMesh.geometryVersion);
+    for (int row = 0; row < 4; row++){
+        for (int col = 0; col < 4; col++)
+            hashValue(result.signature, theMesh.meshTransform.arrayVal(row, col));
+    }
+
+    // Отражающие грани меняются только вместе с версией:
+    result.geometryVersion = theMesh.geometryVersion;
+    if (hasPreviousFrame && theMesh.geometryVersion != 0 && meshIndex < previousMeshes.size() && previousMeshes[meshIndex].geometryVersion == theMesh.geometryVersion)
+        result.isReflective = previousMeshes[meshIndex].isReflective;
+    else {
+        result.isReflective = false;
+        for (int level = 0; level < theMesh.getLodCount() && !result.isReflective; level++){
+            for (auto &currentFace : theMesh.getLodFaces(level)){
+                if (currentFace.getReflectivity() > 0){
+                    result.isReflective = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!theMesh.hasBounds() && !theMesh.faces.empty())
+        theMesh.generateBoundingBox();
+    if (!theMesh.hasBounds())
+        return;
+
+    result.boxMin = Vertex(theMesh.boundingBox.min[0], theMesh.boundingBox.min[1], theMesh.boundingBox.min[2]);
+    result.boxMax = Vertex(theMesh.boundingBox.max[0], theMesh.boundingBox.max[1], theMesh.boundingBox.max[2]);
+    theMesh.getBoundingSphere(result.center, result.radius);
+
+    result.rect = projectBox(result.boxMin, result.boxMax, theScene.camHither, cameraToPerspective, perspectiveToScreen, screen);
+}
+
+// Экранный прямоугольник ограничивающего прямоугольника в пространстве камеры
+ScreenRect DirtyRegionTracker::projectBox(const Vertex& boxMin, const Vertex& boxMax, double hither, TransformationMatrix* cameraToPerspective, TransformationMatrix* perspectiveToScreen, const ScreenRect& screen){
+
+    // Целиком за ближней плоскостью: ничего не рисуется
+    if (boxMax.z < hither)
+        return ScreenRect();
+
+    // Пересекает ближнюю плоскость: проекция не ограничена
+    if (boxMin.z <= hither)
+        return screen;
+
+    double xMin = 0, xMax = 0, yMin = 0, yMax = 0;
+    for (int corner = 0; corner < 8; corner++){
+        Vertex cornerVertex( (corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y, (corner & 4) ? boxMax.z : boxMin.z );
+        cornerVertex.transform(cameraToPerspective);
+        cornerVertex.transform(perspectiveToScreen);
+
+        if (corner == 0 || cornerVertex.x < xMin)
+            xMin = cornerVertex.x;
+        if (corner == 0 || cornerVertex.x > xMax)
+            xMax = cornerVertex.x;
+        if (corner == 0 || cornerVertex.y < yMin)
+            yMin = cornerVertex.y;
+        if (corner == 0 || cornerVertex.y > yMax)
+            yMax = cornerVertex.y;
+    }
+
+    // Прямоугольник далеко за экраном: обрезаем до приведения к int
+    ScreenRect result;
+    result.xMin = (int)std::floor( std::max(xMin, (double)screen.xMin - RECT_MARGIN) ) - RECT_MARGIN;
+    result.yMin = (int)std::floor( std::max(yMin, (double)screen.yMin - RECT_MARGIN) ) - RECT_MARGIN;
+    result.xMax = (int)std::ceil( std::min(xMax, (double)screen.xMax + RECT_MARGIN) ) + RECT_MARGIN;
+    result.yMax = (int)std::ceil( std::min(yMax, (double)screen.yMax + RECT_MARGIN) ) + RECT_MARGIN;
+    result.clip(screen);
+
+    return result;
+}
+
+// Добавить к области грани сцены, на которые может упасть тень сферы (center, radius) от какого-либо источника света
+// Тень сферы от точечного источника лежит в конусе с вершиной в источнике, касающемся сферы. Часть конуса от сферы
+// до самой дальней точки получателя содержится в прямоугольнике, охватывающем два его поперечных сечения (шара).
+// Грани, ограничивающие прямоугольники которых пересекают этот прямоугольник, перерисовываются.
+// Гуро освещает грань по вершинам, поэтому тень в одной точке меняет всю грань; у граней Фонга перерисовывается только
+// часть внутри прямоугольника тени. Плоская заливка теневых лучей не испускает
+void DirtyRegionTracker::addShadowRegion(const Vertex& center, double radius, unsigned int occluderIndex, Scene& theScene, TransformationMatrix* cameraToPerspective, TransformationMatrix* perspectiveToScreen, const ScreenRect& screen, ScreenRect& region){
+
+    for (auto &currentLight : theScene.theLights){
+        Vertex lightPosition = currentLight.position;
+        NormalVector toCenter(center.x - lightPosition.x, center.y - lightPosition.y, center.z - lightPosition.z);
+        double centerDistance = toCenter.length();
+
+        for (unsigned int meshIndex = 0; meshIndex < theScene.theMeshes.size(); meshIndex++){
+            if (meshIndex == occluderIndex)
+                continue;
+
+            // Каркасные сетки освещаются только окружающим светом
+            MeshState& receiver = currentMeshes[meshIndex];
+            if (theScene.theMeshes[meshIndex].isWireframe || receiver.rect.isEmpty() || (region.contains(receiver.rect.xMin, receiver.rect.yMin) && region.contains(receiver.rect.xMax, receiver.rect.yMax)))
+                continue;
+
+            // Источник внутри сферы: тень может упасть куда угодно
+            if (centerDistance <= radius){
+                region.add(receiver.rect);
+                continue;
+            }
+
+            double tanHalfAngle = radius / std::sqrt(centerDistance * centerDistance - radius * radius);
+            double axis[3] = { toCenter.xn / centerDistance, toCenter.yn / centerDistance, toCenter.zn / centerDistance };
+            double lightCoordinates[3] = { lightPosition.x, lightPosition.y, lightPosition.z };
+            double nearDistance = centerDistance - radius;
+
+            // Прямоугольник тени до расстояния farDistance от источника
+            auto getShadowBox = [&](double farDistance, double* shadowMin, double* shadowMax){
+                double nearRadius = nearDistance * tanHalfAngle;
+                double farRadius = farDistance * tanHalfAngle;
+                for (int i = 0; i < 3; i++){
+                    double nearCenter = lightCoordinates[i] + axis[i] * nearDistance;
+                    double farCenter = lightCoordinates[i] + axis[i] * farDistance;
+                    shadowMin[i] = std::min(nearCenter - nearRadius, farCenter - farRadius);
+                    shadowMax[i] = std::max(nearCenter + nearRadius, farCenter + farRadius);
+                }
+            };
+
+            // Расстояние от источника до самого дальнего угла прямоугольника
+            auto getFarDistance = [&](const double* boxMin, const double* boxMax){
+                double sum = 0;
+                for (int i = 0; i < 3; i++){
+                    double farthest = std::max(std::fabs(boxMin[i] - lightCoordinates[i]), std::fabs(boxMax[i] - lightCoordinates[i]));
+                    sum += farthest * farthest;
+                }
+                return std::sqrt(sum);
+            };
+
+            auto overlaps = [](const double* aMin, const double* aMax, const double* bMin, const double* bMax){
+                return aMin[0] <= bMax[0] && bMin[0] <= aMax[0] && aMin[1] <= bMax[1] && bMin[1] <= aMax[1] && aMin[2] <= bMax[2] && bMin[2] <= aMax[2];
+            };
+
+            // Сначала вся сетка-получатель:
+            double meshMin[3] = { receiver.boxMin.x, receiver.boxMin.y, receiver.boxMin.z };
+            double meshMax[3] = { receiver.boxMax.x, receiver.boxMax.y, receiver.boxMax.z };
+            double meshFarDistance = getFarDistance(meshMin, meshMax);
+            if (meshFarDistance <= nearDistance)
+                continue;
+
+            double shadowMin[3], shadowMax[3];
+            getShadowBox(meshFarDistance, shadowMin, shadowMax);
+            if (!overlaps(meshMin, meshMax, shadowMin, shadowMax))
+                continue;
+
+            // Затем отдельные грани всех уровней детализации:
+            Mesh& receiverMesh = theScene.theMeshes[meshIndex];
+            for (int level = 0; level < receiverMesh.getLodCount(); level++){
+                for (auto &currentFace : receiverMesh.getLodFaces(level)){
+                    // Теневые лучи испускаются только при освещении Гуро и Фонга
+                    if (currentFace.getVertexCount() == 0 || currentFace.getShadingModel() == flat || currentFace.getShadingModel() == ambientOnly)
+                        continue;
+
+                    double faceMin[3] = { currentFace.vertices[0].x, currentFace.vertices[0].y, currentFace.vertices[0].z };
+                    double faceMax[3] = { faceMin[0], faceMin[1], faceMin[2] };
+                    for (int i = 1; i < currentFace.getVertexCount(); i++){
+                        double coordinates[3] = { currentFace.vertices[i].x, currentFace.vertices[i].y, currentFace.vertices[i].z };
+                        for (int j = 0; j < 3; j++){
+                            faceMin[j] = std::min(faceMin[j], coordinates[j]);
+                            faceMax[j] = std::max(faceMax[j], coordinates[j]);
+                        }
+                    }
+
+                    double faceFarDistance = getFarDistance(faceMin, faceMax);
+                    if (faceFarDistance <= nearDistance)
+                        continue;
+
+                    getShadowBox(faceFarDistance, shadowMin, shadowMax);
+                    if (!overlaps(faceMin, faceMax, shadowMin, shadowMax))
+                        continue;
+
+                    // Фонг освещает каждый пиксель отдельно: достаточно части грани внутри прямоугольника тени
+                    if (currentFace.getShadingModel() == phong){
+                        for (int i = 0; i < 3; i++){
+                            faceMin[i] = std::max(faceMin[i], shadowMin[i]);
+                            faceMax[i] = std::min(faceMax[i], shadowMax[i]);
+                        }
+                    }
+
+                    region.add( projectBox(Vertex(faceMin[0], faceMin[1], faceMin[2]), Vertex(faceMax[0], faceMax[1], faceMax[2]), theScene.camHither, cameraToPerspective, perspectiveToScreen, screen) );
+                }
+            }
+        }
+    }
+}
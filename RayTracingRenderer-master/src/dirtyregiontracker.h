@@ -0,0 +1,96 @@
+#ifndef DIRTYREGIONTRACKER_H
+#define DIRTYREGIONTRACKER_H
+
+#include <vector>
+#include "scene.h"
+#include "transformationmatrix.h"
+#include "vertex.h"
+
+using std::vector;
+
+// Прямоугольник растра в экранных координатах рендерера (y вверх), границы включительно
+struct ScreenRect {
+    int xMin = 0;
+    int yMin = 0;
+    int xMax = -1;
+    int yMax = -1;
+
+    bool isEmpty() const { return xMax < xMin || yMax < yMin; }
+
+    bool contains(int x, int y) const { return x >= xMin && x <= xMax && y >= yMin && y <= yMax; }
+
+    bool intersects(const ScreenRect& other) const {
+        return !isEmpty() && !other.isEmpty() && xMin <= other.xMax && other.xMin <= xMax && yMin <= other.yMax && other.yMin <= yMax;
+    }
+
+    // Расширить прямоугольник так, чтобы он содержал other
+    void add(const ScreenRect& other);
+
+    // Обрезать прямоугольник по другому
+    void clip(const ScreenRect& other);
+
+    // Количество пикселей
+    long long getArea() const;
+};
+
+// Отслеживание областей экрана, изменившихся с прошлого кадра
+// Для каждой сетки запоминается подпись (хэш версии граней и накопленного преобразования сетки) и экранный прямоугольник.
+// Перерисовывается объединение старых и новых прямоугольников изменившихся сеток, а также области, на которые
+// изменившиеся сетки могут влиять через лучи:
+//  - тени: грани других сеток, попадающие в тень ограничивающей сферы сетки (старой или новой) от какого-либо источника света;
+//  - отражения: отражающие сетки целиком, если трассировка отражений включена.
+// Остальные пиксели берутся из предыдущего кадра. Изменение света, камеры, тумана и настроек сцены перерисовывает весь кадр.
+class DirtyRegionTracker
+{
+public:
+    // Конструктор
+    DirtyRegionTracker();
+
+    // Включить / выключить отслеживание. Выключенный трекер всегда возвращает весь экран
+    void setEnabled(bool newIsEnabled);
+    bool isEnabled();
+
+    // Забыть предыдущий кадр: следующий кадр перерисовывается целиком
+    void invalidate();
+
+    // Вычислить область перерисовки кадра и запомнить состояние сцены для следующего
+    // Предварительное условие: сетки и источники света сцены находятся в пространстве камеры
+    // Возвращает: прямоугольник перерисовки (пустой, если ничего не изменилось)
+    ScreenRect update(Scene& theScene, TransformationMatrix* cameraToPerspective, TransformationMatrix* perspectiveToScreen, int xRes, int yRes);
+
+    // Экранный прямоугольник сетки текущего кадра (после update)
+    const ScreenRect& getMeshRect(unsigned int meshIndex);
+
+private:
+    // Состояние сетки в кадре
+    struct MeshState {
+        unsigned long long signature = 0;
+        unsigned long long geometryVersion = 0;     // Mesh::geometryVersion
+        ScreenRect rect;                // Экранный прямоугольник всех уровней детализации
+        Vertex boxMin, boxMax;          // Ограничивающий прямоугольник в пространстве камеры
+        Vertex center;                  // Ограничивающая сфера в пространстве камеры
+        double radius = 0;
+        bool isReflective = false;      // Есть грани с reflectivity > 0
+    };
+
+    bool isTrackerEnabled;
+    bool hasPreviousFrame;
+    unsigned long long previousSceneSignature;
+    vector<MeshState> previousMeshes;
+    vector<MeshState> currentMeshes;
+
+    // Подпись настроек сцены, влияющих на все пиксели (свет, туман, окно камеры, трассировка)
+    static unsigned long long getSceneSignature(Scene& theScene, int xRes, int yRes);
+
+    // Подпись, ограничивающий прямоугольник и экранный прямоугольник сетки
+    // Предварительное условие: previousMeshes - состояние предыдущего кадра (если hasPreviousFrame)
+    void measureMesh(Mesh& theMesh, unsigned int meshIndex, Scene& theScene, TransformationMatrix* cameraToPerspective, TransformationMatrix* perspectiveToScreen, const ScreenRect& screen, MeshState& result);
+
+    // Экранный прямоугольник ограничивающего прямоугольника в пространстве камеры (весь экран, если он пересекает ближнюю плоскость)
+    static ScreenRect projectBox(const Vertex& boxMin, const Vertex& boxMax, double hither, TransformationMatrix* cameraToPerspective, TransformationMatrix* perspectiveToScreen, const ScreenRect& screen);
+
+    // Добавить к области грани сцены, на которые может упасть тень сферы (center, radius) от какого-либо источника света
+    void addShadowRegion(const Vertex& center, double radius, unsigned int occluderIndex, Scene& theScene, TransformationMatrix* cameraToPerspective, TransformationMatrix* perspectiveToScreen, const ScreenRect& screen, ScreenRect& region);
+};
+
+#endif // DIRTYREGIONTRACKER_H
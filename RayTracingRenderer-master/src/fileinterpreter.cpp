@@ -1,8 +1,5 @@
 #include "fileinterpreter.h"
-#include <fstream>
 #include <iostream>
-#include <list>
-#include <iterator>
 #include <string>
 #include "mesh.h"
 #include "transformationmatrix.h"
@@ -12,28 +9,48 @@
 #include "normalvector.h"
 #include "light.h"
 #include "polygon.h"
+#include "meshsimplifier.h"
+#include "memorystatistics.h"
+#include "tracer.h"
+#include "simpreader.h"
+#include "objloader.h"
 #include <QDebug>
 
-using std::ifstream;
 using std::cout;
-using std::list;
 using std::stack;
 using std::vector;
 
 // Конструктор по умолчанию
 FileInterpreter::FileInterpreter(){
-    // Ничего не делает
+    currentScene = nullptr;
+    sceneFilename = DEFAULT_SCENE_FILENAME;
 }
 
-// Чтение файла и сборка сетки с учетом имени файла
-// Возвращает: объект сетки, созданный из описаний файлов .simp
+// Чтение файла описания сцены и сборка сцены
+// Возвращает: сцену, созданную из описания в файле .simp; пустую сцену, если файл не удалось открыть
 Scene FileInterpreter::buildSceneFromFile(double x, double z, double xCam, double yCam, double zCam){
+    MEMORY_SCOPE(sceneMemory);
+    TRACE_SCOPE("buildSceneFromFile");
 
     // Сбор получившихся полигонов в сцену и ее возврат
     Scene theScene;
     currentScene = &theScene;
 
-    theScene.theMeshes = getMeshHelper2(x, z, xCam, yCam, zCam, false, false, false, false, 0xffffffff, phong , 0.3, 8, 0.5); // Set the default values to start
+    SimpReader reader;
+    if (!reader.open(sceneFilename)){
+        cout << "Could not open scene file " << sceneFilename << "\n";
+        currentScene = nullptr;
+        return theScene;
+    }
+
+    // Параметры анимации, доступные в файле как $x, $z, $camX, $camY, $camZ:
+    reader.setParameter("x", x);
+    reader.setParameter("z", z);
+    reader.setParameter("camX", xCam);
+    reader.setParameter("camY", yCam);
+    reader.setParameter("camZ", zCam);
+
+    theScene.theMeshes = getMeshesFromSimp(reader);
 
     // Генерируем ограничивающие рамки:
     for (auto &currentMesh : theScene.theMeshes){
@@ -45,667 +62,352 @@ Scene FileInterpreter::buildSceneFromFile(double x, double z, double xCam, doubl
     return theScene;
 }
 
-// интерпретировать прочитанную строку
-// Возвращает: список разделенных и очищенных токенов
-list<string> FileInterpreter::interpretTokenLine(string currentLine){
-
-    // Удаляем пробелы в начале строки
-    unsigned int start = 0;
-    while (start < currentLine.length() && (currentLine[start] == ' ' || currentLine[start] == '\t' || currentLine[start] == '\n' || currentLine[start] == '\r' ))
-        start++;
-    if (start != 0)
-        currentLine = currentLine.substr(start, string::npos);
-
-    // Обработка пустых строк или комментариев:
-    if (currentLine.empty() || currentLine[0] == '#')
-        return list<string>(); // Nothing to insert: Return an empty list
-
-    // Разбиваем строку, затем очищаем каждый токен от ненужных символов форматирования:
-    list<string> tokens = cleanseTokens( split(currentLine) );
+// Чтение файла obj
+// Файл разбирается параллельно загрузчиком ObjLoader
+// Возвращает: вектор <Polygon>, содержащий все грани, описанные объектом
+vector<Polygon> FileInterpreter::getPolysFromObj(string filename){
+    MEMORY_SCOPE(loaderMemory);
+    TRACE_SCOPE("getPolysFromObj");
 
-    return tokens;
+    ObjLoader loader;
+    return loader.load(filename);
 }
 
-// Разделить строку
-// Возвращает: список <string>, содержащий каждый токен как отдельный элемент, в порядке чтения файла
-list<string> FileInterpreter::split(string line){
-    list<string> tokens;
-
-    unsigned int start = 0;
-    while (line[start] == ' ' || line[start] == '\t' || line[start] == '\n' || line[start] == '\r')
-        start++;
-    line = line.substr(start, string::npos);
-
-    if (line.length() == 1 && (line[0] == '{' || line[0] == '}')){
-        tokens.push_back(line);
-        return tokens;
-    }
-
-    start = 0;
-    unsigned int indexIterator = 1;
-    while (indexIterator < line.length() ){
-
-        if (line[indexIterator] == ' '){
-            while ((indexIterator + 1) < line.length() && line[indexIterator + 1] == ' ')
-                indexIterator++;
-
-            string newToken = line.substr(start, indexIterator - start);
-            tokens.push_back(newToken);
-
-            start = indexIterator + 1;
-            indexIterator+= 2;
-        }
+// Построить упрощенные уровни детализации граней файла obj
+// Уровни строятся квадратичным стягиванием ребер и хранятся в пространстве объекта
+// Возвращает: вектор уровней; пустой вектор, если сетка слишком мала для упрощения
+vector< vector<Polygon> > FileInterpreter::getObjLevelsOfDetail(vector<Polygon>& objectSpaceFaces){
+    MEMORY_SCOPE(loaderMemory);
+    TRACE_SCOPE("getObjLevelsOfDetail");
 
-        else if (line[indexIterator] == '/'){
-            string newToken = line.substr(start, (indexIterator - start));
-            tokens.push_back(newToken);
-            tokens.push_back("/");
+    vector< vector<Polygon> > levels;
+    MeshSimplifier simplifier;
 
-            indexIterator++;
+    unsigned int targetFaceCount = (unsigned int)objectSpaceFaces.size() / 2;
+    unsigned int previousFaceCount = (unsigned int)objectSpaceFaces.size();
+    while (levels.size() < MAX_LOD_LEVELS && targetFaceCount >= MIN_LOD_FACES){
 
-            if (line[indexIterator] == '/'){
-                tokens.push_back("/");
-                indexIterator++;
-            }
-            start = indexIterator;
+        vector<Polygon> simplified = simplifier.simplify(levels.empty() ? objectSpaceFaces : levels.back(), targetFaceCount);
 
-        } else
-            indexIterator++;
+        if (simplified.size() >= previousFaceCount) // Сетку больше не удается упростить
+            break;
 
+        previousFaceCount = (unsigned int)simplified.size();
+        levels.emplace_back(simplified);
+        targetFaceCount = previousFaceCount / 2;
     }
 
-    if (start <= line.length() - 1)
-        tokens.push_back(line.substr(start, string::npos));
-
-
-    return tokens;
+    return levels;
 }
 
-// Очистить список токенов любых символов форматирования. Используется после того, как split извлек токены из строки
-// Возвращает: список <string>, содержащий токены, очищенные от символов форматирования
-list<string> FileInterpreter::cleanseTokens(list<string> tokens){
-    list<string>::iterator theIterator = tokens.begin();
-    while (theIterator != tokens.end()){
-        string currentLine = *theIterator;
+// Прочитать файл obj и построить его уровни детализации
+// Возвращает: nullptr, если файл не содержит граней (не открыт или пуст): такой результат не кэшируется
+std::shared_ptr<MeshAsset> FileInterpreter::loadObjAsset(const string& filename){
+    std::shared_ptr<MeshAsset> newAsset = std::make_shared<MeshAsset>();
 
-        unsigned int start = 0;
-        while ( start < currentLine.length() && ( currentLine[start] == ' ' || currentLine[start] == '(' || currentLine[start] == '\t' || currentLine[start] == '\"' ) ){
-            start++;
-        }
+    newAsset->faces = getPolysFromObj(filename);
+    if (newAsset->faces.empty())
+        return nullptr;
 
-        int end = (int)currentLine.length() - 1;
-        while ( end >= 0 && ( currentLine[ end ] == ' ' || currentLine[ end ] == ',' || currentLine[ end ] == ')' || currentLine[ end ] == '\t' || currentLine[ end ] == '\"' || currentLine[ end ] == '\n' || currentLine[ end ] == '\r') ) {
-            end--;
-        }
+    newAsset->levels = getObjLevelsOfDetail(newAsset->faces);
 
-        if ( end < (int)start){
-            list<string>::iterator temp = theIterator;
-            theIterator++;
-            tokens.erase(temp);
-        } else{
-            *theIterator = currentLine.substr(start, end - start + 1);
-            theIterator++;
-        }
-    }
+    // Иерархии граней строятся один раз для файла в пространстве объекта
+    newAsset->bvhs.resize(newAsset->levels.size() + 1);
+    newAsset->bvhs[0].build(newAsset->faces);
+    for (unsigned int i = 0; i < newAsset->levels.size(); i++)
+        newAsset->bvhs[i + 1].build(newAsset->levels[i]);
 
-    return tokens;
+    return newAsset;
 }
 
-// Чтение файла obj
-// Возвращает: вектор <Polygon>, содержащий все грани, описанные объектом
-vector<Polygon> FileInterpreter::getPolysFromObj(string filename){
-
-    vector<Polygon> theFaces;
-    vector<Vertex> theVertices;
-    theVertices.emplace_back( Vertex() );
-
-    vector<NormalVector> theNormals;
-    theNormals.emplace_back( NormalVector() );
-
-    ifstream* input = new ifstream();
-    input->open(filename);
-    if (input->is_open() ){
-        while(!input->eof()){
-            string currentLine;
-            getline(*input, currentLine);
-            list<string>currentLineTokens = interpretTokenLine(currentLine);
-
-            list<string>::iterator theIterator = currentLineTokens.begin();
-            while (theIterator != currentLineTokens.end()){
-
-                if (theIterator->compare("v") == 0){
-                    theIterator++;
-
-                    Vertex v1;
-                    double x = stod(*theIterator++);
-                    double y = stod(*theIterator++);
-                    double z = stod(*theIterator++);
-                    v1.x = x;
-                    v1.y = y;
-                    v1.z = z;
-
-
-                    if (currentLineTokens.size() == 5){
-                        double w = stod(*theIterator++);
-                        v1.setW(w);
-                    }
-
-                    else if (currentLineTokens.size() == 7){
-                        double red = stod(*theIterator++);
-                        double green = stod(*theIterator++);
-                        double blue = stod(*theIterator++);
-                        v1.color = combineColorChannels( red, green, blue );
-                    }
-                    else if (currentLineTokens.size() == 8){
-                        double w = stod(*theIterator++);
-                        v1.setW(w);
-
-                        double red = stod(*theIterator++);
-                        double green = stod(*theIterator++);
-                        double blue = stod(*theIterator++);
-                        v1.color = combineColorChannels( red, green, blue );
-                    }
-
-                    v1.z *= -1;
-
-                    theVertices.emplace_back(v1);
-                }
-
-                else if(theIterator->compare("vn") == 0){
-                    theIterator++;
-
-                    NormalVector newNormal;
-                    newNormal.xn = stod(*theIterator++);
-                    newNormal.yn = stod(*theIterator++);
-                    newNormal.zn = stod(*theIterator++);
-
-                    newNormal.zn *= -1;
-
-                    theNormals.emplace_back(newNormal);
-                }
-
-                else if(theIterator->compare("vt") == 0){
-                    theIterator++;
-
-                }
-
-                else if(theIterator->compare("f") == 0){
-                    theIterator++;
-
-                    Polygon newFace;
-
-                    while (theIterator != currentLineTokens.end() ){
-
-                        Vertex newVertex;
-
-                        int index = stoi( *theIterator++ );
-                        if (index < 1)
-                            newVertex = theVertices[ theVertices.size() + index];
-                        else
-                            newVertex = theVertices[ index ];
-
-                        if (theIterator != currentLineTokens.end() && theIterator->compare("/") == 0){
-                            theIterator++;
-
-                            if (theIterator != currentLineTokens.end() && !theIterator->compare("/") == 0){
-                                theIterator++;
-
-                                if (theIterator != currentLineTokens.end() && theIterator->compare("/") == 0){
-                                    theIterator++;
-                                    NormalVector newNormal;
-                                    index = stoi( *theIterator++ );
-                                    if (index < 1)
-                                        newNormal = theNormals[ theNormals.size() + index];
-                                    else
-                                        newNormal = theNormals[ index ];
-
-                                    newVertex.normal = newNormal;
-                                }
-                            }
-                            else {
-                                theIterator++;
-
-                                NormalVector newNormal;
-                                index = stoi( *theIterator++ );
-                                if (index < 1)
-                                    newNormal = theNormals[ theNormals.size() + index];
-                                else
-                                    newNormal = theNormals[ index ];
-
-                                newVertex.normal = newNormal;
-                            }
-                        }
-
-                        newFace.addVertex(newVertex);
-                    }
+// Подготовить грани, прочитанные из файла obj: преобразование и установка материала
+void FileInterpreter::prepareObjFaces(vector<Polygon>& objFaces, TransformationMatrix* CTM, bool usesSurfaceColor, unsigned int theSurfaceColor, double theSpecCoefficient, double theSpecExponent, ShadingModel theShadingModel, double theReflectivity, bool usesAmbientLighting){
+    for (unsigned int i = 0; i < objFaces.size(); i++){
+        objFaces[i].transform(CTM);
+        // Устанавливаем инструкции цвета поверхности:
+        if (usesSurfaceColor)
+            objFaces[i].setSurfaceColor(theSurfaceColor);
+        objFaces[i].setSpecularCoefficient(theSpecCoefficient);
+        objFaces[i].setSpecularExponent(theSpecExponent);
+        objFaces[i].setShadingModel(theShadingModel);
+        objFaces[i].setReflectivity(theReflectivity);
+        // Установить окружающее освещение:
+        objFaces[i].setAffectedByAmbientLight(usesAmbientLighting);
+        // Рассчитать нормаль грани многоугольника:
+        objFaces[i].faceNormal = objFaces[i].getFaceNormal();
+    }
+}
 
+// Задать файл описания сцены
+void FileInterpreter::setSceneFilename(string newSceneFilename){
+    sceneFilename = newSceneFilename;
+}
 
-                    NormalVector faceNormal = newFace.getFaceNormal();
-                    for (int i = 0; i < newFace.getVertexCount(); i++){
-                        if (newFace.vertices[i].normal.isZero() ) {
-                            newFace.vertices[i].normal = faceNormal; // Set 0,0,0 normals to be the face normal
-                        }
-                    }
+// Прочитать сетки, источники света и настройки сцены из файла .simp за один проход
+// Блок { } сохраняет матрицу преобразования и атрибуты материала; грани, прочитанные внутри блока, образуют одну сетку
+vector<Mesh> FileInterpreter::getMeshesFromSimp(SimpReader& reader){
 
-                    if (newFace.getVertexCount() > 3){
-                        vector<Polygon>* triangulatedFaces = newFace.getTriangulatedFaces();
-                        for (unsigned int i = 0; i < triangulatedFaces->size(); i++){
-                            theFaces.emplace_back(triangulatedFaces->at(i) );
-                        }
-                        delete triangulatedFaces;
+    vector<Mesh> extractedMeshes;                   // Коллекция собранных сеток
+    std::map< string, std::shared_ptr<const MeshAsset> > loadedObjs;    // Файлы obj, уже полученные для этой сцены
 
-                    } else
-                        theFaces.emplace_back(newFace);
+    SimpAttributes currentAttributes;               // Атрибуты текущего блока
+    stack<SimpAttributes> theAttributeStack;        // Атрибуты внешних блоков
+    vector<PendingMesh> pendingMeshes(1);           // Грани текущего и внешних блоков; [0] - верхний уровень файла
 
-                }
-                else
-                    theIterator++;
+    string command;
+    string word;
+    double values[6];
 
-            }
+    while (reader.readWord(command)){
 
+        if (command == "{"){
+            theAttributeStack.push(currentAttributes);
+            pendingMeshes.emplace_back();
         }
-
-    }
-    else
-        cout << "ERROR - File " << filename << " not found!!! Please place it the working directory.\n";
-
-    return theFaces;
-}
-
-// Рекурсивная вспомогательная функция: извлекает многоугольники
-vector<Mesh> FileInterpreter::getMeshHelper2(double sphere_x, double sphere_z, double xCam, double yCam, double zCam, bool currentIsWireframe, bool currentisDepthFogged, bool currentAmbientLighting, bool currentUseSurfaceColor, unsigned int currentSurfaceColor, ShadingModel currentShadingModel, double currentSpecCoef, double currentSpecExponent, double currentReflectivity){
-
-    // Флаги сетки:
-    bool isWireframe = currentIsWireframe;                // Каркас / заполненный
-    bool isDepthFogged = currentisDepthFogged;            // Флаг глубины
-
-    // Флаги полигонов:
-    bool usesAmbientLighting = currentAmbientLighting;  // Флаг внешнего освещения
-    bool usesSurfaceColor = currentUseSurfaceColor;
-    unsigned int theSurfaceColor = currentSurfaceColor;
-
-    ShadingModel theShadingModel = currentShadingModel;
-    double theSpecCoefficient = currentSpecCoef;
-    double theSpecExponent = currentSpecExponent;
-    double theReflectivity = currentReflectivity;
-
-    TransformationMatrix CTM;
-    stack<TransformationMatrix> theCTMStack;
-
-    vector<Polygon> currentFaces;               // Рабочий вектор граней полигона
-    vector<Mesh> extractedMeshes;               // Коллекция собранных сеток
-
-    currentScene->numRayBounces = 0;
-
-    for (int i = 1; i <= 7; i++)
-    {
-        theCTMStack.push(CTM);
-        CTM = TransformationMatrix();
-
-        switch(i)
-        {
-        case 1:
-        {
-            TransformationMatrix currentTransformation;
-            double transX = xCam;
-            double transY = yCam;
-            double transZ = zCam;
-            currentTransformation.addTranslation(transX, transY, transZ);
-            CTM *= currentTransformation;
-
-            currentScene->xLow = -1;
-            currentScene->yLow = -1;
-            currentScene->xHigh = 1;
-            currentScene->yHigh = 1;
-            currentScene->camHither = 1;
-            currentScene->camYon = 200;
-            currentScene->cameraMovement = CTM;
-
-            CTM = theCTMStack.top();
-            theCTMStack.pop();
-            // Применяем текущий CTM к граням из блока
-            for (unsigned int i = 0; i < currentFaces.size(); i++){
-                currentFaces[i].transform(&CTM);
+        else if (command == "}"){
+            if (theAttributeStack.empty()){
+                cout << "Scene file line " << reader.getLineNumber() << ": unmatched '}'\n";
+                continue;
             }
-            // Вставляем обработанные грани в конечный объект сетки:
-            if (currentFaces.size() > 0 ){
-                Mesh newMesh;
-                newMesh.faces = currentFaces;
-                currentFaces.clear();
-                newMesh.isWireframe = isWireframe;
-                extractedMeshes.emplace_back( newMesh );
-                }
+            flushPendingMesh(pendingMeshes.back(), currentAttributes, extractedMeshes);
+            pendingMeshes.pop_back();
 
-            break;
-            }
-
-
-        case 2:
-        {
-            TransformationMatrix currentTransformation;
-            double transX = 0;
-            double transY = 125;
-            double transZ = 2000;
-            currentTransformation.addTranslation(transX, transY, transZ);
-            CTM *= currentTransformation;
-
-            double redIntensity = 2;
-            double greenIntensity = 1.7;
-            double blueIntensity = 1.3;
-            double attenuationA = 0.001;
-            double attenuationB = 0.02;
-            // Создать источник света, преобразовать его с помощью CTM и передать его в средство визуализации
-            Light newLight(redIntensity, greenIntensity, blueIntensity, attenuationA, attenuationB);
-            newLight.position.transform( &CTM );
-            currentScene->theLights.emplace_back(newLight);
-
-            CTM = theCTMStack.top();
-            theCTMStack.pop();
-            // Применяем текущий CTM к граням из блока
-            for (unsigned int i = 0; i < currentFaces.size(); i++){
-                currentFaces[i].transform(&CTM);
-            }
-            // Вставляем обработанные грани в конечный объект сетки:
-            if (currentFaces.size() > 0 ){
-                Mesh newMesh;
-                newMesh.faces = currentFaces;
-                currentFaces.clear();
-                newMesh.isWireframe = isWireframe;
-                extractedMeshes.emplace_back( newMesh );
-                }
-
-            break;
+            currentAttributes = theAttributeStack.top();
+            theAttributeStack.pop();
         }
-
-        case 3:
-        {
-            TransformationMatrix currentTransformation;
-            double transX = 100;
-            double transY = 100;
-            double transZ = -200;
-            currentTransformation.addTranslation(transX, transY, transZ);
-            CTM *= currentTransformation;
-
-            double redIntensity = 2;
-            double greenIntensity = 1.7;
-            double blueIntensity = 1.3;
-            double attenuationA = 0.01;
-            double attenuationB = 0.01;
-            Light newLight(redIntensity, greenIntensity, blueIntensity, attenuationA, attenuationB);
-            newLight.position.transform( &CTM );
-            currentScene->theLights.emplace_back(newLight);
-
-            CTM = theCTMStack.top();
-            theCTMStack.pop();
-            for (unsigned int i = 0; i < currentFaces.size(); i++){
-                currentFaces[i].transform(&CTM);
+        else if (command == "translate"){
+            if (readSimpNumbers(reader, command, values, 3)){
+                TransformationMatrix currentTransformation;
+                currentTransformation.addTranslation(values[0], values[1], values[2]);
+                currentAttributes.CTM *= currentTransformation;
             }
-            if (currentFaces.size() > 0 ){
-                Mesh newMesh;
-                newMesh.faces = currentFaces;
-                currentFaces.clear();
-                newMesh.isWireframe = isWireframe;
-                extractedMeshes.emplace_back( newMesh );
-                }
-
-            break;
         }
-
-
-        case 4:
-        {
-            TransformationMatrix currentTransformation;
-            double transX = -75;
-            double transY = 50;
-            double transZ = -200;
-            currentTransformation.addTranslation(transX, transY, transZ);
-            CTM *= currentTransformation;
-
-            double redIntensity = 1.7;
-            double greenIntensity = 1.5;
-            double blueIntensity = 1.5;
-            double attenuationA = 0.05;
-            double attenuationB = 0.05;
-            Light newLight(redIntensity, greenIntensity, blueIntensity, attenuationA, attenuationB);
-            newLight.position.transform( &CTM );
-            currentScene->theLights.emplace_back(newLight);
-
-            CTM = theCTMStack.top();
-            theCTMStack.pop();
-            for (unsigned int i = 0; i < currentFaces.size(); i++){
-                currentFaces[i].transform(&CTM);
+        else if (command == "scale"){
+            if (readSimpNumbers(reader, command, values, 3)){
+                TransformationMatrix currentTransformation;
+                currentTransformation.addNonUniformScale(values[0], values[1], values[2]);
+                currentAttributes.CTM *= currentTransformation;
             }
-            if (currentFaces.size() > 0 ){
-                Mesh newMesh;
-                newMesh.faces = currentFaces;
-                currentFaces.clear();
-                newMesh.isWireframe = isWireframe;
-                extractedMeshes.emplace_back( newMesh );
-                }
-
-            break;
         }
+        else if (command == "rotate"){
+            if (!reader.readArgumentWord(word)){
+                cout << "Scene file line " << reader.getLineNumber() << ": 'rotate' needs an axis\n";
+                continue;
+            }
 
-
-        case 5:
-        {
-            TransformationMatrix currentTransformation1;
-            double transX = -0.5;
-            double transY = 2;
-            double transZ = 0;
-            currentTransformation1.addTranslation(transX, transY, transZ);
-            CTM *= currentTransformation1;
-
-            TransformationMatrix currentTransformation2;
-            double scaleX = 1.0;
-            double scaleY = 1.0;
-            double scaleZ = 1.0;
-            currentTransformation2.addNonUniformScale(scaleX, scaleY, scaleZ);
-            CTM *= currentTransformation2;
-
-            usesSurfaceColor = true;
-            double red = 0.6;
-            double green = 0.6;
-            double blue = 0.6;
-            theSurfaceColor = combineColorChannels(red, green, blue);
-
-            theSpecCoefficient = 0.5;
-            theSpecExponent = 2.5;
-
-            theReflectivity = 0.5;
-
-            theShadingModel = flat;
-
-            vector<Polygon> objContents = getPolysFromObj("./unitCube.obj");
-            // Обработка полученных полигонов:
-            for (unsigned int i = 0; i < objContents.size(); i++){
-                objContents[i].transform(&CTM);
-                // Устанавливаем инструкции цвета поверхности:
-                if (usesSurfaceColor)
-                    objContents[i].setSurfaceColor(theSurfaceColor);
-                objContents[i].setSpecularCoefficient(theSpecCoefficient);
-                objContents[i].setSpecularExponent(theSpecExponent);
-                objContents[i].setShadingModel(theShadingModel);
-                objContents[i].setReflectivity(theReflectivity);
-                // Установить окружающее освещение:
-                objContents[i].setAffectedByAmbientLight(usesAmbientLighting);
-                // Рассчитать нормаль грани многоугольника:
-                objContents[i].faceNormal = objContents[i].getFaceNormal();
+            Axis theAxis = X;
+            if (word == "Y" || word == "y")
+                theAxis = Y;
+            else if (word == "Z" || word == "z")
+                theAxis = Z;
+            else if (word != "X" && word != "x"){
+                cout << "Scene file line " << reader.getLineNumber() << ": unknown axis '" << word << "'\n";
+                reader.skipLine();
+                continue;
             }
-            currentFaces.insert(currentFaces.end(), objContents.begin(), objContents.end() );
 
-            CTM = theCTMStack.top();
-            theCTMStack.pop();
-            for (unsigned int i = 0; i < currentFaces.size(); i++){
-                currentFaces[i].transform(&CTM);
+            if (readSimpNumbers(reader, command, values, 1)){
+                TransformationMatrix currentTransformation;
+                currentTransformation.addRotation(theAxis, values[0]);
+                currentAttributes.CTM *= currentTransformation;
             }
-            if (currentFaces.size() > 0 ){
-                Mesh newMesh;
-                newMesh.faces = currentFaces;
-                currentFaces.clear();
-                newMesh.isWireframe = isWireframe;
-                extractedMeshes.emplace_back( newMesh );
+        }
+        else if (command == "camera"){
+            if (readSimpNumbers(reader, command, values, 6)){
+                currentScene->xLow = values[0];
+                currentScene->yLow = values[1];
+                currentScene->xHigh = values[2];
+                currentScene->yHigh = values[3];
+                currentScene->camHither = values[4];
+                currentScene->camYon = values[5];
+                currentScene->cameraMovement = currentAttributes.CTM;
             }
-            if (!currentUseSurfaceColor) // Обработка рекурсивных случаев, когда мы унаследовали цвет, и его необходимо применить к загруженному файлу
-                usesSurfaceColor = false;
-
-            break;
         }
-
-
-        case 6:
-        {
-            TransformationMatrix currentTransformation1;
-            double transX = 0;
-            double transY = -0.75;
-            double transZ = 0;
-            currentTransformation1.addTranslation(transX, transY, transZ);
-            CTM *= currentTransformation1;
-
-            TransformationMatrix currentTransformation2;
-            double scaleX = 4;
-            double scaleY = 4;
-            double scaleZ = 4;
-            currentTransformation2.addNonUniformScale(scaleX, scaleY, scaleZ);
-            CTM *= currentTransformation2;
-
-            usesSurfaceColor = true;
-            double red = 0.6;
-            double green = 0.6;
-            double blue = 0.6;
-            theSurfaceColor = combineColorChannels(red, green, blue);
-
-            theSpecCoefficient = 0.5;
-            theSpecExponent = 2.5;
-
-            theReflectivity = 0.5;
-
-            theShadingModel = flat;
-
-            vector<Polygon> objContents = getPolysFromObj("./unitPlane.obj");
-            for (unsigned int i = 0; i < objContents.size(); i++){
-                objContents[i].transform(&CTM);
-                if (usesSurfaceColor)
-                    objContents[i].setSurfaceColor(theSurfaceColor);
-                objContents[i].setSpecularCoefficient(theSpecCoefficient);
-                objContents[i].setSpecularExponent(theSpecExponent);
-                objContents[i].setShadingModel(theShadingModel);
-                objContents[i].setReflectivity(theReflectivity);
-                objContents[i].setAffectedByAmbientLight(usesAmbientLighting);
-                objContents[i].faceNormal = objContents[i].getFaceNormal();
+        else if (command == "light"){
+            if (readSimpNumbers(reader, command, values, 5)){
+                // Создать источник света в начале координат текущего блока
+                Light newLight(values[0], values[1], values[2], values[3], values[4]);
+                newLight.position.transform( &currentAttributes.CTM );
+                currentScene->theLights.emplace_back(newLight);
             }
-            currentFaces.insert(currentFaces.end(), objContents.begin(), objContents.end() );
-
-            CTM = theCTMStack.top();
-            theCTMStack.pop();
-            for (unsigned int i = 0; i < currentFaces.size(); i++){
-                currentFaces[i].transform(&CTM);
+        }
+        else if (command == "ambient"){
+            if (readSimpNumbers(reader, command, values, 3)){
+                currentScene->ambientRedIntensity = values[0];
+                currentScene->ambientGreenIntensity = values[1];
+                currentScene->ambientBlueIntensity = values[2];
+                currentAttributes.usesAmbientLighting = true;
             }
-            if (currentFaces.size() > 0 ){
-                Mesh newMesh;
-                newMesh.faces = currentFaces;
-                currentFaces.clear();
-                newMesh.isWireframe = isWireframe;
-                extractedMeshes.emplace_back( newMesh );
+        }
+        else if (command == "depth"){
+            if (readSimpNumbers(reader, command, values, 5)){
+                currentScene->isDepthFogged = true;
+                currentScene->fogHither = values[0];
+                currentScene->fogYon = values[1];
+                currentScene->fogRedIntensity = values[2];
+                currentScene->fogGreenIntensity = values[3];
+                currentScene->fogBlueIntensity = values[4];
+                currentScene->fogColor = combineColorChannels(values[2], values[3], values[4]);
             }
-            if (!currentUseSurfaceColor)
-                usesSurfaceColor = false;
-
-            break;
         }
-
-
-        case 7:
-        {
-            TransformationMatrix currentTransformation1;
-            double transX = sphere_x;
-            double transY = 0;
-            double transZ = sphere_z;
-            currentTransformation1.addTranslation(transX, transY, transZ);
-            CTM *= currentTransformation1;
-
-            TransformationMatrix currentTransformation2;
-            double scaleX = 1;
-            double scaleY = 1;
-            double scaleZ = 1;
-            currentTransformation2.addNonUniformScale(scaleX, scaleY, scaleZ);
-            CTM *= currentTransformation2;
-
-            usesSurfaceColor = true;
-            double red = 0.6;
-            double green = 0.6;
-            double blue = 0.6;
-            theSurfaceColor = combineColorChannels(red, green, blue);
-
-            theSpecCoefficient = 0.5;
-            theSpecExponent = 2.5;
-
-            theReflectivity = 0.5;
-
-            theShadingModel = gouraud;
-
-            vector<Polygon> objContents = getPolysFromObj("./unitSphere_20.obj");
-            for (unsigned int i = 0; i < objContents.size(); i++){
-                objContents[i].transform(&CTM);
-                if (usesSurfaceColor)
-                    objContents[i].setSurfaceColor(theSurfaceColor);
-                objContents[i].setSpecularCoefficient(theSpecCoefficient);
-                objContents[i].setSpecularExponent(theSpecExponent);
-                objContents[i].setShadingModel(theShadingModel);
-                objContents[i].setReflectivity(theReflectivity);
-                objContents[i].setAffectedByAmbientLight(usesAmbientLighting);
-                objContents[i].faceNormal = objContents[i].getFaceNormal();
+        else if (command == "surface"){
+            if (readSimpNumbers(reader, command, values, 3)){
+                currentAttributes.usesSurfaceColor = true;
+                currentAttributes.surfaceColor = combineColorChannels(values[0], values[1], values[2]);
             }
-            currentFaces.insert(currentFaces.end(), objContents.begin(), objContents.end() );
-
-            CTM = theCTMStack.top();
-            theCTMStack.pop();
-            for (unsigned int i = 0; i < currentFaces.size(); i++){
-                currentFaces[i].transform(&CTM);
+        }
+        else if (command == "specular"){
+            if (readSimpNumbers(reader, command, values, 2)){
+                currentAttributes.specCoefficient = values[0];
+                currentAttributes.specExponent = values[1];
+            }
+        }
+        else if (command == "reflectivity"){
+            if (readSimpNumbers(reader, command, values, 1))
+                currentAttributes.reflectivity = values[0];
+        }
+        else if (command == "flat")
+            currentAttributes.shadingModel = flat;
+        else if (command == "gouraud")
+            currentAttributes.shadingModel = gouraud;
+        else if (command == "phong")
+            currentAttributes.shadingModel = phong;
+        else if (command == "wire")
+            currentAttributes.isWireframe = true;
+        else if (command == "filled")
+            currentAttributes.isWireframe = false;
+        else if (command == "static")
+            currentAttributes.isStatic = true;
+        else if (command == "dynamic")
+            currentAttributes.isStatic = false;
+        else if (command == "obj"){
+            if (!reader.readArgumentWord(word)){
+                cout << "Scene file line " << reader.getLineNumber() << ": 'obj' needs a file name\n";
+                continue;
             }
-            if (currentFaces.size() > 0 ){
-                Mesh newMesh;
-                newMesh.faces = currentFaces;
-                currentFaces.clear();
-                newMesh.isWireframe = isWireframe;
-                extractedMeshes.emplace_back( newMesh );
+            addObjToPendingMesh(word, currentAttributes, loadedObjs, pendingMeshes.back());
+        }
+        else if (command == "raybounces"){
+            if (readSimpNumbers(reader, command, values, 1))
+                currentScene->numRayBounces = (int)values[0];
+        }
+        else if (command == "noshadows")
+            currentScene->noRayShadows = true;
+        else if (command == "lightcutoff"){
+            // Отрицательный вклад не имеет смысла: 0 отключает отбор источников света
+            if (readSimpNumbers(reader, command, values, 1))
+                currentScene->minLightContribution = (values[0] > 0) ? values[0] : 0;
+        }
+        else if (command == "lod"){
+            if (readSimpNumbers(reader, command, values, 3)){
+                currentScene->lodPixelsPerFace = values[0];
+                currentScene->lodHysteresis = values[1];
+                currentScene->rayLodLevel = (int)values[2];
             }
-            if (!currentUseSurfaceColor)
-                usesSurfaceColor = false;
-
-            break;
         }
-
+        else {
+            cout << "Scene file line " << reader.getLineNumber() << ": unknown command '" << command << "'\n";
+            reader.skipLine();
         }
     }
 
-    if (currentFaces.size() > 0){
+    if (!theAttributeStack.empty())
+        cout << "Scene file: " << theAttributeStack.size() << " unclosed '{'\n";
 
-        Mesh newMesh;
-        newMesh.faces = currentFaces;
-        newMesh.isWireframe = isWireframe;
-
-        extractedMeshes.emplace_back( newMesh );
+    // Незакрытые блоки и грани верхнего уровня тоже становятся сетками:
+    while (!pendingMeshes.empty()){
+        flushPendingMesh(pendingMeshes.back(), currentAttributes, extractedMeshes);
+        pendingMeshes.pop_back();
+        if (!theAttributeStack.empty()){
+            currentAttributes = theAttributeStack.top();
+            theAttributeStack.pop();
+        }
     }
 
     return extractedMeshes;
 }
 
+// Прочитать count чисел аргументов команды
+// Возвращает: false и пропускает строку, если аргументов не хватает
+bool FileInterpreter::readSimpNumbers(SimpReader& reader, const string& command, double* values, int count){
+    for (int i = 0; i < count; i++){
+        if (!reader.readNumber(values[i])){
+            cout << "Scene file line " << reader.getLineNumber() << ": '" << command << "' expects " << count << " numbers\n";
+            reader.skipLine();
+            return false;
+        }
+    }
+    return true;
+}
 
+// Добавить грани файла obj к сетке текущего блока
+// Грани и уровни детализации берутся из кэша процесса AssetCache: файл читается и упрощается заново, только если он изменился.
+// Внутри сцены файл запрашивается у кэша один раз, сколько бы раз он ни использовался
+void FileInterpreter::addObjToPendingMesh(const string& filename, SimpAttributes& theAttributes, std::map< string, std::shared_ptr<const MeshAsset> >& loadedObjs, PendingMesh& theMesh){
+
+    auto found = loadedObjs.find(filename);
+    if (found == loadedObjs.end()){
+        std::shared_ptr<const MeshAsset> theAsset = AssetCache::getInstance().getMesh(filename, [this](const string& objFilename){
+            return loadObjAsset(objFilename);
+        });
+        found = loadedObjs.emplace(filename, theAsset).first;
+    }
 
+    if (found->second == nullptr){
+        cout << "Could not open obj file " << filename << "\n";
+        return;
+    }
 
+    // Копии граней кэша: вершины преобразуются в мировое пространство
+    vector<Polygon> objContents = found->second->faces;
+    vector< vector<Polygon> > objLevels = found->second->levels;
 
+    // Обработка полученных полигонов и их упрощенных версий:
+    prepareObjFaces(objContents, &theAttributes.CTM, theAttributes.usesSurfaceColor, theAttributes.surfaceColor, theAttributes.specCoefficient, theAttributes.specExponent, theAttributes.shadingModel, theAttributes.reflectivity, theAttributes.usesAmbientLighting);
+    for (auto &currentLevel : objLevels)
+        prepareObjFaces(currentLevel, &theAttributes.CTM, theAttributes.usesSurfaceColor, theAttributes.surfaceColor, theAttributes.specCoefficient, theAttributes.specExponent, theAttributes.shadingModel, theAttributes.reflectivity, theAttributes.usesAmbientLighting);
 
+    theMesh.faces.insert(theMesh.faces.end(), objContents.begin(), objContents.end() );
 
+    // Грани сетки определяются файлом, его преобразованием и материалом: одинаковые данные дают одинаковую версию в каждом кадре
+    hashValue(theMesh.geometryVersion, found->second->version);
+    for (int row = 0; row < 4; row++){
+        for (int col = 0; col < 4; col++)
+            hashValue(theMesh.geometryVersion, theAttributes.CTM.arrayVal(row, col));
+    }
+    hashValue(theMesh.geometryVersion, (unsigned long long)theAttributes.usesSurfaceColor);
+    hashValue(theMesh.geometryVersion, (unsigned long long)theAttributes.surfaceColor);
+    hashValue(theMesh.geometryVersion, (unsigned long long)theAttributes.shadingModel);
+    hashValue(theMesh.geometryVersion, (unsigned long long)theAttributes.usesAmbientLighting);
+    hashValue(theMesh.geometryVersion, theAttributes.specCoefficient);
+    hashValue(theMesh.geometryVersion, theAttributes.specExponent);
+    hashValue(theMesh.geometryVersion, theAttributes.reflectivity);
+
+    // Уровни детализации и иерархии граней сохраняются, только если сетка состоит из одного файла: уровни разных файлов не согласованы
+    if (theMesh.objCount == 0){
+        theMesh.lodFaces = objLevels;
+        theMesh.objectBvhs = std::shared_ptr< const vector<MeshBvh> >(found->second, &found->second->bvhs);
+        theMesh.objectToWorld = theAttributes.CTM;
+    }
+    else {
+        theMesh.lodFaces.clear();
+        theMesh.objectBvhs = nullptr;
+    }
+    theMesh.objCount++;
+}
 
-
-
-
-
-
-
-
-
-
-
-
+// Вставить грани блока в конечный объект сетки
+void FileInterpreter::flushPendingMesh(PendingMesh& theMesh, SimpAttributes& theAttributes, vector<Mesh>& extractedMeshes){
+    if (theMesh.faces.empty())
+        return;
+
+    Mesh newMesh;
+    newMesh.faces.swap(theMesh.faces);
+    newMesh.lodFaces.swap(theMesh.lodFaces);
+    newMesh.isWireframe = theAttributes.isWireframe;
+    newMesh.isStatic = theAttributes.isStatic;
+    newMesh.objectBvhs = theMesh.objectBvhs;
+    newMesh.objectToMesh = theMesh.objectToWorld;
+    newMesh.geometryVersion = theMesh.geometryVersion;
+    extractedMeshes.emplace_back( newMesh );
+}
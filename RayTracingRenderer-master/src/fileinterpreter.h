@@ -2,16 +2,20 @@
 #define FILEINTERPRETER_H
 
 #include <string>
-#include <list>
+#include "assetcache.h"
 #include "mesh.h"
 #include "polygon.h"
+#include "renderutilities.h"
 #include "scene.h"
+#include "simpreader.h"
+#include "transformationmatrix.h"
 
 #include <vector>
+#include <map>
+#include <memory>
 
 
 using std::string;
-using std::list;
 using std::vector;
 
 class FileInterpreter
@@ -21,31 +25,76 @@ public:
     // Конструктор
     FileInterpreter();
 
-    // Чтение файла и сборка сетки с учетом имени файла. Вызывает рекурсивную вспомогательную функцию
-    // Return: объект сетки, созданный из описаний файлов .simp
+    // Чтение файла описания сцены и сборка сцены. Аргументы доступны в файле как параметры $x, $z, $camX, $camY, $camZ
+    // Return: сцена, созданная из описания в файле .simp
     Scene buildSceneFromFile(double x, double z, double xCam, double yCam, double zCam);
 
+    // Задать файл описания сцены (по умолчанию DEFAULT_SCENE_FILENAME)
+    void setSceneFilename(string newSceneFilename);
+
+    static constexpr const char* DEFAULT_SCENE_FILENAME = "./foucault.simp";
+
 private:
     Scene* currentScene; // Объект Scene: используется для вставки значений во время построения
 
-    // Рекурсивная вспомогательная функция: извлекает многоугольники
-    vector<Mesh> getMeshHelper2(double sphere_x, double sphere_z, double xCam, double yCam, double zCam, bool currentIsWireframe, bool currentisDepthFogged, bool currentAmbientLighting, bool currentUseSurfaceColor, unsigned int currentSurfaceColor, ShadingModel currentShadingModel, double currentSpecCoef, double currentSpecExponent, double currentReflectivity);
+    // Уровни детализации:
+    static const unsigned int MAX_LOD_LEVELS = 3;   // Максимальное количество упрощенных уровней
+    static const unsigned int MIN_LOD_FACES = 32;   // Минимальное количество граней упрощенного уровня
+
+    string sceneFilename;   // Файл описания сцены
+
+    // Атрибуты блока { } файла .simp: восстанавливаются при выходе из блока
+    struct SimpAttributes {
+        TransformationMatrix CTM;
+        bool isWireframe = false;
+        bool isStatic = false;
+        bool usesAmbientLighting = false;
+        bool usesSurfaceColor = false;
+        unsigned int surfaceColor = 0xffffffff;
+        ShadingModel shadingModel = phong;
+        double specCoefficient = 0.3;
+        double specExponent = 8;
+        double reflectivity = 0.5;
+    };
+
+    // Грани, собираемые в сетку до конца блока
+    struct PendingMesh {
+        vector<Polygon> faces;
+        vector< vector<Polygon> > lodFaces;
+        unsigned int objCount = 0;
+        std::shared_ptr< const vector<MeshBvh> > objectBvhs;    // Иерархии граней единственного файла
+        TransformationMatrix objectToWorld;                     // Преобразование этого файла
+        unsigned long long geometryVersion = HASH_SEED;  // Хэш FNV-1a версий файлов, их преобразований и материалов (см. Mesh::geometryVersion)
+    };
+
+    // Прочитать сетки, источники света и настройки сцены из файла .simp за один проход
+    // Return: сетки сцены; источники света и настройки записываются в currentScene
+    vector<Mesh> getMeshesFromSimp(SimpReader& reader);
+
+    // Прочитать count чисел аргументов команды
+    // Return: false, если аргументов не хватает (сообщение выводится, строка пропускается)
+    bool readSimpNumbers(SimpReader& reader, const string& command, double* values, int count);
+
+    // Добавить грани файла obj с текущими атрибутами к сетке блока
+    void addObjToPendingMesh(const string& filename, SimpAttributes& theAttributes, std::map< string, std::shared_ptr<const MeshAsset> >& loadedObjs, PendingMesh& theMesh);
+
+    // Вставить грани блока в конечный объект сетки, если они есть
+    void flushPendingMesh(PendingMesh& theMesh, SimpAttributes& theAttributes, vector<Mesh>& extractedMeshes);
 
     // Чтение файла obj
     // Return: вектор <Polygon>, содержащий все грани, описанные объектом
     vector<Polygon> getPolysFromObj(string filename);
 
-    // интерпретировать прочитанную строку
-    // Return: список разделенных и очищенных токенов
-    list<string> interpretTokenLine(string newString);
+    // Построить упрощенные уровни детализации граней файла obj
+    // Return: вектор уровней, от более детального к более грубому, в пространстве объекта
+    vector< vector<Polygon> > getObjLevelsOfDetail(vector<Polygon>& objectSpaceFaces);
 
-    // Разделить строку
-    // Return: список <string>, содержащий каждый токен как отдельный элемент, в порядке чтения файла
-    list<string> split(string line);
+    // Прочитать файл obj и построить его уровни детализации (вызывается кэшем AssetCache при промахе)
+    // Return: nullptr, если файл не содержит граней
+    std::shared_ptr<MeshAsset> loadObjAsset(const string& filename);
 
-    // Очистить список токенов любых символов форматирования. Используется после того, как split извлек токены из строки
-    // Return: список <string>, содержащий токены, очищенные от символов форматирования
-    list<string> cleanseTokens(list<string> tokens);
+    // Подготовить грани, прочитанные из файла obj: преобразование и установка материала
+    void prepareObjFaces(vector<Polygon>& objFaces, TransformationMatrix* CTM, bool usesSurfaceColor, unsigned int theSurfaceColor, double theSpecCoefficient, double theSpecExponent, ShadingModel theShadingModel, double theReflectivity, bool usesAmbientLighting);
 };
 
 #endif // FILEINTERPRETER_H
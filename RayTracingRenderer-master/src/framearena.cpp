@@ -0,0 +1,95 @@
+#include "framearena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+thread_local FrameArena* FrameArena::current = nullptr;
+
+// Конструктор
+FrameArena::FrameArena(std::size_t newBlockSize){
+    blockSize = newBlockSize;
+    currentBlock = 0;
+    offset = 0;
+    bytesUsed = 0;
+    peakBytesUsed = 0;
+}
+
+// Деструктор
+FrameArena::~FrameArena(){
+    for (auto &currentBlockData : blocks)
+        delete [] currentBlockData.data;
+}
+
+// Выделить память
+void* FrameArena::allocate(std::size_t bytes, std::size_t alignment){
+
+    // Ищем блок, в котором поместится запрос, начиная с текущего:
+    while (currentBlock < blocks.size()){
+        Block& theBlock = blocks[currentBlock];
+
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(theBlock.data) + offset;
+        std::size_t padding = (alignment - (address % alignment)) % alignment;
+
+        if (offset + padding + bytes <= theBlock.size){
+            offset += padding + bytes;
+            bytesUsed += padding + bytes;
+            peakBytesUsed = std::max(peakBytesUsed, bytesUsed);
+            return theBlock.data + offset - bytes;
+        }
+
+        currentBlock++;
+        offset = 0;
+    }
+
+    // Ни один блок не подошел: добавляем новый (только в первых кадрах или при росте сцены)
+    Block newBlock;
+    newBlock.size = std::max(blockSize, bytes + alignment);
+    newBlock.data = new char[newBlock.size];
+    blocks.push_back(newBlock);
+
+    currentBlock = blocks.size() - 1;
+    offset = 0;
+
+    return allocate(bytes, alignment);
+}
+
+// Вернуть всю память арены
+void FrameArena::reset(){
+    currentBlock = 0;
+    offset = 0;
+    bytesUsed = 0;
+}
+
+// Количество байт, выделенных с последнего reset()
+std::size_t FrameArena::getBytesUsed(){
+    return bytesUsed;
+}
+
+// Наибольшее количество байт, выделенных между двумя вызовами reset()
+std::size_t FrameArena::getPeakBytesUsed(){
+    return peakBytesUsed;
+}
+
+// Общий размер блоков арены
+std::size_t FrameArena::getCapacity(){
+    std::size_t result = 0;
+    for (auto &currentBlockData : blocks)
+        result += currentBlockData.size;
+    return result;
+}
+
+// Получить арену, активную в текущем потоке
+FrameArena* FrameArena::getCurrent(){
+    return current;
+}
+
+// Делает арену активной в текущем потоке
+FrameArena::Scope::Scope(FrameArena* theArena){
+    previous = current;
+    current = theArena;
+}
+
+// Восстанавливает предыдущую арену
+FrameArena::Scope::~Scope(){
+    current = previous;
+}
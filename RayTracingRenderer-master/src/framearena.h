@@ -0,0 +1,84 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+using std::vector;
+
+// Арена кадра: линейный (bump) распределитель для временных объектов отрисовки
+// Память выделяется сдвигом указателя и никогда не освобождается поштучно: reset() за O(1) возвращает всю арену
+// к началу, сохраняя блоки памяти для следующего кадра. После первых кадров выделений из кучи больше не происходит
+class FrameArena
+{
+public:
+    // Конструктор
+    FrameArena(std::size_t newBlockSize = DEFAULT_BLOCK_SIZE);
+
+    // Деструктор
+    ~FrameArena();
+
+    // Выделить память. Предварительное условие: alignment - степень двойки
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+    // Выделить массив объектов, сконструированных конструктором по умолчанию
+    // Деструкторы объектов не вызываются: подходит только для типов, не владеющих ресурсами
+    template <class T>
+    T* allocateArray(std::size_t count){
+        T* result = static_cast<T*>( allocate(count * sizeof(T), alignof(T)) );
+        for (std::size_t i = 0; i < count; i++)
+            new (result + i) T();
+        return result;
+    }
+
+    // Вернуть всю память арены. Ранее выделенные указатели становятся недействительными
+    void reset();
+
+    // Количество байт, выделенных с последнего reset()
+    std::size_t getBytesUsed();
+
+    // Наибольшее количество байт, выделенных между двумя вызовами reset()
+    std::size_t getPeakBytesUsed();
+
+    // Общий размер блоков арены
+    std::size_t getCapacity();
+
+    // Получить арену, активную в текущем потоке (nullptr, если нет)
+    static FrameArena* getCurrent();
+
+    // Делает арену активной в текущем потоке на время жизни объекта
+    class Scope
+    {
+    public:
+        Scope(FrameArena* theArena);
+        ~Scope();
+
+    private:
+        FrameArena* previous;
+    };
+
+    static const std::size_t DEFAULT_BLOCK_SIZE = 1 << 20; // 1 МБ
+
+private:
+    // Блок памяти арены
+    struct Block {
+        char* data;
+        std::size_t size;
+    };
+
+    vector<Block> blocks;
+    std::size_t blockSize;          // Размер новых блоков
+    std::size_t currentBlock;       // Индекс блока, из которого идет выделение
+    std::size_t offset;             // Смещение в текущем блоке
+    std::size_t bytesUsed;
+    std::size_t peakBytesUsed;
+
+    static thread_local FrameArena* current;
+
+    // Запрет копирования: арена владеет своими блоками
+    FrameArena(const FrameArena&);
+    FrameArena& operator=(const FrameArena&);
+};
+
+#endif // FRAMEARENA_H
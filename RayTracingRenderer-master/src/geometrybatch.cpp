@@ -0,0 +1,174 @@
+#include "geometrybatch.h"
+
+#include <algorithm>
+
+// Конструктор
+GeometryBatch::GeometryBatch(){
+    count = 0;
+    skipped = 0;
+}
+
+// Загрузить треугольные грани в пакет
+// Массивы не освобождаются между кадрами: их емкость переиспользуется
+void GeometryBatch::load(vector<Polygon>& faces){
+    count = 0;
+    skipped = 0;
+
+    for (int k = 0; k < 3; k++){
+        x[k].resize(faces.size());
+        y[k].resize(faces.size());
+        z[k].resize(faces.size());
+        projectedX[k].resize(faces.size());
+        projectedY[k].resize(faces.size());
+    }
+    faceIndices.resize(faces.size());
+    depthClip.resize(faces.size());
+    keep.resize(faces.size());
+
+    for (unsigned int i = 0; i < faces.size(); i++){
+        if (faces[i].getVertexCount() != 3){
+            skipped++;
+            continue;
+        }
+
+        for (int k = 0; k < 3; k++){
+            x[k][count] = faces[i].vertices[k].x;
+            y[k][count] = faces[i].vertices[k].y;
+            z[k][count] = faces[i].vertices[k].z;
+        }
+        faceIndices[count] = i;
+        depthClip[count] = 0;
+        count++;
+    }
+}
+
+// Отбор по глубине: отбрасывает треугольники целиком перед hither или за yon
+void GeometryBatch::cullDepth(double hither, double yon){
+    const double* z0 = z[0].data();
+    const double* z1 = z[1].data();
+    const double* z2 = z[2].data();
+    unsigned char* keepMask = keep.data();
+    unsigned char* clipMask = depthClip.data();
+
+    for (unsigned int i = 0; i < count; i++){
+        double zMin = std::min(z0[i], std::min(z1[i], z2[i]));
+        double zMax = std::max(z0[i], std::max(z1[i], z2[i]));
+
+        // Как и Polygon::isInDepth: треугольник виден, если хотя бы часть его лежит между hither и yon
+        keepMask[i] = (zMax >= hither) & (zMin <= yon);
+        clipMask[i] = (zMin < hither) | (zMax > yon);
+    }
+
+    compact();
+}
+
+// Отбор задних граней
+// Площадь проекции (x/z, y/z) равна det(v0, v1, v2) / (z0 * z1 * z2): при z > 0 знаки совпадают,
+// а отсечение по hither не меняет плоскость треугольника и поэтому не меняет знак
+void GeometryBatch::cullBackFacing(){
+    const double* x0 = x[0].data(); const double* y0 = y[0].data(); const double* z0 = z[0].data();
+    const double* x1 = x[1].data(); const double* y1 = y[1].data(); const double* z1 = z[1].data();
+    const double* x2 = x[2].data(); const double* y2 = y[2].data(); const double* z2 = z[2].data();
+    unsigned char* keepMask = keep.data();
+
+    for (unsigned int i = 0; i < count; i++){
+        double determinant =   x0[i] * (y1[i] * z2[i] - z1[i] * y2[i])
+                             - y0[i] * (x1[i] * z2[i] - z1[i] * x2[i])
+                             + z0[i] * (x1[i] * y2[i] - y1[i] * x2[i]);
+
+        keepMask[i] = (determinant >= 0);
+    }
+
+    compact();
+}
+
+// Отбор по усеченному конусу
+void GeometryBatch::cullFrustum(double xLow, double xHigh, double yLow, double yHigh){
+    unsigned char* keepMask = keep.data();
+
+    // Треугольник отбрасывается, если все три вершины лежат снаружи одной боковой плоскости
+    for (unsigned int i = 0; i < count; i++){
+        unsigned char belowXLow = 1, aboveXHigh = 1, belowYLow = 1, aboveYHigh = 1;
+
+        for (int k = 0; k < 3; k++){
+            double currentZ = z[k][i];
+            belowXLow &= (x[k][i] <= xLow * currentZ);
+            aboveXHigh &= (x[k][i] >= xHigh * currentZ);
+            belowYLow &= (y[k][i] <= yLow * currentZ);
+            aboveYHigh &= (y[k][i] >= yHigh * currentZ);
+        }
+
+        keepMask[i] = !(belowXLow | aboveXHigh | belowYLow | aboveYHigh);
+    }
+
+    compact();
+}
+
+// Перспективное преобразование выживших треугольников
+void GeometryBatch::project(){
+    for (int k = 0; k < 3; k++){
+        const double* currentX = x[k].data();
+        const double* currentY = y[k].data();
+        const double* currentZ = z[k].data();
+        double* resultX = projectedX[k].data();
+        double* resultY = projectedY[k].data();
+
+        for (unsigned int i = 0; i < count; i++){
+            double inverseZ = 1.0 / currentZ[i];
+            resultX[i] = currentX[i] * inverseZ;
+            resultY[i] = currentY[i] * inverseZ;
+        }
+    }
+}
+
+// Получить количество треугольников в пакете
+unsigned int GeometryBatch::size(){
+    return count;
+}
+
+// Получить индекс исходной грани треугольника
+unsigned int GeometryBatch::getFaceIndex(unsigned int triangle){
+    return faceIndices[triangle];
+}
+
+// Проверить, пересекает ли треугольник плоскость hither или yon
+bool GeometryBatch::needsDepthClip(unsigned int triangle){
+    return depthClip[triangle] != 0;
+}
+
+// Записать перспективные координаты треугольника в многоугольник
+// Повторяет Polygon::transform(&cameraToPerspective): x и y делятся на z, нормали перенормализуются
+void GeometryBatch::getProjectedPolygon(unsigned int triangle, Polygon* thePolygon){
+    for (int k = 0; k < 3; k++){
+        thePolygon->vertices[k].x = projectedX[k][triangle];
+        thePolygon->vertices[k].y = projectedY[k][triangle];
+        thePolygon->vertices[k].normal.normalize();
+    }
+    thePolygon->faceNormal.normalize();
+}
+
+// Количество граней, пропущенных при загрузке (не треугольники)
+unsigned int GeometryBatch::getSkippedCount(){
+    return skipped;
+}
+
+// Уплотнить массивы, оставив только треугольники с keep[i] != 0 (с сохранением порядка)
+void GeometryBatch::compact(){
+    unsigned int survivors = 0;
+    for (unsigned int i = 0; i < count; i++){
+        if (!keep[i])
+            continue;
+
+        if (survivors != i){
+            for (int k = 0; k < 3; k++){
+                x[k][survivors] = x[k][i];
+                y[k][survivors] = y[k][i];
+                z[k][survivors] = z[k][i];
+            }
+            faceIndices[survivors] = faceIndices[i];
+            depthClip[survivors] = depthClip[i];
+        }
+        survivors++;
+    }
+    count = survivors;
+}
@@ -0,0 +1,72 @@
+#ifndef GEOMETRYBATCH_H
+#define GEOMETRYBATCH_H
+
+#include "polygon.h"
+#include <vector>
+
+using std::vector;
+
+// Пакет треугольников в виде структуры массивов (SoA)
+// Этапы отбора работают над целыми массивами и уплотняют выжившие треугольники между этапами,
+// поэтому освещение выполняется только для треугольников, которые действительно будут растеризованы
+class GeometryBatch
+{
+public:
+    // Конструктор
+    GeometryBatch();
+
+    // Загрузить треугольные грани в пакет. Грани с другим количеством вершин пропускаются
+    // Предварительное условие: грани находятся в пространстве камеры
+    void load(vector<Polygon>& faces);
+
+    // Отбор по глубине: отбрасывает треугольники целиком перед hither или за yon
+    // Треугольники, пересекающие эти плоскости, помечаются для отсечения
+    void cullDepth(double hither, double yon);
+
+    // Отбор задних граней: знак смешанного произведения вершин совпадает со знаком площади проекции
+    void cullBackFacing();
+
+    // Отбор по усеченному конусу: боковые плоскости в пространстве камеры x = xLow * z и т.д.
+    void cullFrustum(double xLow, double xHigh, double yLow, double yHigh);
+
+    // Перспективное преобразование выживших треугольников: x / z, y / z
+    void project();
+
+    // Получить количество треугольников в пакете
+    unsigned int size();
+
+    // Получить индекс исходной грани треугольника
+    unsigned int getFaceIndex(unsigned int triangle);
+
+    // Проверить, пересекает ли треугольник плоскость hither или yon
+    bool needsDepthClip(unsigned int triangle);
+
+    // Записать перспективные координаты треугольника в многоугольник
+    // Предварительное условие: project() уже вызван, многоугольник - копия исходной грани
+    void getProjectedPolygon(unsigned int triangle, Polygon* thePolygon);
+
+    // Количество граней, пропущенных при загрузке (не треугольники)
+    unsigned int getSkippedCount();
+
+private:
+    // Координаты вершин: x[k][i] - координата x вершины k треугольника i
+    vector<double> x[3];
+    vector<double> y[3];
+    vector<double> z[3];
+
+    // Результаты перспективного преобразования
+    vector<double> projectedX[3];
+    vector<double> projectedY[3];
+
+    vector<unsigned int> faceIndices;   // Индекс исходной грани
+    vector<unsigned char> depthClip;    // 1, если треугольник пересекает плоскость hither / yon
+    vector<unsigned char> keep;         // Маска выживших треугольников текущего этапа
+
+    unsigned int count;                 // Количество треугольников в пакете
+    unsigned int skipped;               // Количество пропущенных граней
+
+    // Уплотнить массивы, оставив только треугольники с keep[i] != 0 (с сохранением порядка)
+    void compact();
+};
+
+#endif // GEOMETRYBATCH_H
@@ -0,0 +1,180 @@
+#include "halfspacerasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Конструктор
+HalfSpaceRasterizer::HalfSpaceRasterizer(){
+    for (int i = 0; i < 3; i++){
+        vertices[i] = nullptr;
+        a[i] = b[i] = c[i] = bias[i] = 0;
+    }
+    xMin = xMax = yMin = yMax = 0;
+    tilesAccepted = tilesRejected = tilesPartial = 0;
+}
+
+// Подготовить функции ребер треугольника
+bool HalfSpaceRasterizer::setup(Vertex* v0, Vertex* v1, Vertex* v2){
+    tilesAccepted = tilesRejected = tilesPartial = 0;
+
+    long long x0 = (long long)std::round(v0->x), y0 = (long long)std::round(v0->y);
+    long long x1 = (long long)std::round(v1->x), y1 = (long long)std::round(v1->y);
+    long long x2 = (long long)std::round(v2->x), y2 = (long long)std::round(v2->y);
+
+    long long doubleArea = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+    if (doubleArea == 0)
+        return false;
+
+    // Обход против часовой стрелки: внутренняя область лежит слева от каждого ребра
+    if (doubleArea < 0){
+        std::swap(v1, v2);
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+    }
+
+    vertices[0] = v0;
+    vertices[1] = v1;
+    vertices[2] = v2;
+
+    long long xs[3] = {x0, x1, x2};
+    long long ys[3] = {y0, y1, y2};
+
+    for (int i = 0; i < 3; i++){
+        int from = (i + 1) % 3;
+        int to = (i + 2) % 3;
+
+        a[i] = ys[from] - ys[to];
+        b[i] = xs[to] - xs[from];
+        c[i] = xs[from] * ys[to] - ys[from] * xs[to];
+
+        // Построчный растеризатор округляет пересечения строки с ребрами:
+        // левое ребро (a > 0) покрывает пиксели с x > xEdge - 0.5, правое (a < 0) - с x <= xEdge + 0.5
+        if (a[i] > 0)
+            bias[i] = a[i] - 1;
+        else
+            bias[i] = -a[i];
+    }
+
+    xMin = (int)std::min(x0, std::min(x1, x2));
+    xMax = (int)std::max(x0, std::max(x1, x2));
+    yMin = (int)std::min(y0, std::min(y1, y2));
+    yMax = (int)std::max(y0, std::max(y1, y2));
+
+    return true;
+}
+
+// Получить вершину треугольника
+Vertex* HalfSpaceRasterizer::getVertex(int index){
+    return vertices[index];
+}
+
+// Ограничивающий прямоугольник треугольника в пикселях
+int HalfSpaceRasterizer::getXMin(){
+    return xMin;
+}
+
+int HalfSpaceRasterizer::getXMax(){
+    return xMax;
+}
+
+int HalfSpaceRasterizer::getYMin(){
+    return yMin;
+}
+
+int HalfSpaceRasterizer::getYMax(){
+    return yMax;
+}
+
+// Получить маску покрытия блока
+bool HalfSpaceRasterizer::getTileMask(int tileX, int tileY, unsigned char mask[TILE_SIZE]){
+
+    // Блок обрезается по ограничивающему прямоугольнику: за его пределами построчный растеризатор ничего не рисует
+    int left = std::max(tileX, xMin);
+    int right = std::min(tileX + TILE_SIZE - 1, xMax);
+    int bottom = std::max(tileY, yMin);
+    int top = std::min(tileY + TILE_SIZE - 1, yMax);
+
+    for (int row = 0; row < TILE_SIZE; row++)
+        mask[row] = 0;
+
+    if (left > right || bottom > top){
+        tilesRejected++;
+        return false;
+    }
+
+    // Функция ребра линейна, поэтому ее минимум и максимум на блоке достигаются в углах:
+    bool isInside = true;
+    for (int i = 0; i < 3; i++){
+        long long corners[4] = { getBiasedEdge(i, left, bottom), getBiasedEdge(i, right, bottom), getBiasedEdge(i, left, top), getBiasedEdge(i, right, top) };
+        long long cornerMin = std::min( std::min(corners[0], corners[1]), std::min(corners[2], corners[3]) );
+        long long cornerMax = std::max( std::max(corners[0], corners[1]), std::max(corners[2], corners[3]) );
+
+        if (cornerMax < 0){ // Весь блок снаружи этого ребра
+            tilesRejected++;
+            return false;
+        }
+        if (cornerMin < 0)
+            isInside = false;
+    }
+
+    unsigned char columns = 0;
+    for (int x = left; x <= right; x++)
+        columns |= (unsigned char)(1 << (x - tileX));
+
+    if (isInside){
+        tilesAccepted++;
+        for (int y = bottom; y <= top; y++)
+            mask[y - tileY] = columns;
+        return true;
+    }
+
+    tilesPartial++;
+
+    // Частично покрытый блок: все ребра вычисляются для строки из TILE_SIZE пикселей сразу.
+    // Циклы фиксированной длины без ветвлений векторизуются компилятором
+    bool hasCoverage = false;
+    for (int y = bottom; y <= top; y++){
+        long long rowStart[3];
+        for (int i = 0; i < 3; i++)
+            rowStart[i] = getBiasedEdge(i, tileX, y);
+
+        unsigned char inside[TILE_SIZE];
+        for (int k = 0; k < TILE_SIZE; k++){
+            inside[k] =   (rowStart[0] + 2 * a[0] * k >= 0)
+                        & (rowStart[1] + 2 * a[1] * k >= 0)
+                        & (rowStart[2] + 2 * a[2] * k >= 0);
+        }
+
+        unsigned char rowMask = 0;
+        for (int k = 0; k < TILE_SIZE; k++)
+            rowMask |= (unsigned char)(inside[k] << k);
+
+        mask[y - tileY] = rowMask & columns;
+        hasCoverage |= (mask[y - tileY] != 0);
+    }
+
+    return hasCoverage;
+}
+
+// Проверить, покрывает ли треугольник пиксель
+bool HalfSpaceRasterizer::isCovered(int x, int y){
+    if (x < xMin || x > xMax || y < yMin || y > yMax)
+        return false;
+
+    return getBiasedEdge(0, x, y) >= 0 && getBiasedEdge(1, x, y) >= 0 && getBiasedEdge(2, x, y) >= 0;
+}
+
+// Получить ненормированные барицентрические веса пикселя
+void HalfSpaceRasterizer::getWeights(int x, int y, double weights[3]){
+    for (int i = 0; i < 3; i++){
+        long long edge = a[i] * x + b[i] * y + c[i];
+
+        // Пиксели, покрытые благодаря округлению, лежат чуть снаружи: берем значения на ребре, как построчный растеризатор
+        weights[i] = edge > 0 ? (double)edge : 0.0;
+    }
+}
+
+// Удвоенная смещенная функция ребра
+long long HalfSpaceRasterizer::getBiasedEdge(int edge, int x, int y){
+    return 2 * (a[edge] * x + b[edge] * y + c[edge]) + bias[edge];
+}
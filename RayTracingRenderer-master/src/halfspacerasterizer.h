@@ -0,0 +1,63 @@
+#ifndef HALFSPACERASTERIZER_H
+#define HALFSPACERASTERIZER_H
+
+#include "vertex.h"
+
+// Растеризатор полупространств: треугольник задается тремя функциями ребер E(x, y) = a*x + b*y + c,
+// экран обходится блоками TILE_SIZE x TILE_SIZE с тривиальным принятием / отбрасыванием целых блоков
+// Правило покрытия повторяет построчный растеризатор: пиксель строки закрашивается,
+// если он лежит между округленными пересечениями строки с левым и правым ребрами
+class HalfSpaceRasterizer
+{
+public:
+    static const int TILE_SIZE = 8;     // Размер блока в пикселях: маска строки блока помещается в unsigned char
+
+    // Конструктор
+    HalfSpaceRasterizer();
+
+    // Подготовить функции ребер треугольника
+    // Предварительное условие: вершины находятся в экранных координатах с целыми x и y
+    // Возвращает: false, если треугольник вырожден (нулевая площадь)
+    bool setup(Vertex* v0, Vertex* v1, Vertex* v2);
+
+    // Получить вершину треугольника. Порядок вершин может отличаться от переданного в setup (обход всегда против часовой стрелки)
+    Vertex* getVertex(int index);
+
+    // Ограничивающий прямоугольник треугольника в пикселях (включительно)
+    int getXMin();
+    int getXMax();
+    int getYMin();
+    int getYMax();
+
+    // Получить маску покрытия блока с левым нижним углом (tileX, tileY)
+    // Бит i элемента mask[row] соответствует пикселю (tileX + i, tileY + row)
+    // Возвращает: false, если блок не содержит ни одного пикселя треугольника
+    bool getTileMask(int tileX, int tileY, unsigned char mask[TILE_SIZE]);
+
+    // Проверить, покрывает ли треугольник пиксель
+    bool isCovered(int x, int y);
+
+    // Получить ненормированные барицентрические веса пикселя (отрицательные веса обнуляются)
+    void getWeights(int x, int y, double weights[3]);
+
+    // Счетчики блоков последнего вызова setup: используются для статистики
+    unsigned int tilesAccepted;     // Блоки, целиком лежащие внутри треугольника
+    unsigned int tilesRejected;     // Блоки, целиком лежащие снаружи
+    unsigned int tilesPartial;      // Блоки, пересекающие ребра
+
+private:
+    Vertex* vertices[3];
+
+    // Функция ребра i проходит от вершины i + 1 к вершине i + 2 и равна 0 на вершине i: E_i - барицентрический вес вершины i
+    long long a[3], b[3], c[3];
+
+    // Смещение на полпикселя по горизонтали в удвоенных единицах: пиксель покрыт, если 2 * E_i + bias[i] >= 0 для всех ребер
+    long long bias[3];
+
+    int xMin, xMax, yMin, yMax;
+
+    // Удвоенная смещенная функция ребра
+    long long getBiasedEdge(int edge, int x, int y);
+};
+
+#endif // HALFSPACERASTERIZER_H
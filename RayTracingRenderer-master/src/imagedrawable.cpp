@@ -0,0 +1,27 @@
+#include "imagedrawable.h"
+
+#include <QString>
+
+// Конструктор
+ImageDrawable::ImageDrawable(int newXRes, int newYRes){
+    image = QImage(newXRes, newYRes, QImage::Format_RGB32);
+    image.fill(0xff000000);
+}
+
+void ImageDrawable::setPixel(int x, int y, unsigned int color){
+    image.setPixel(x, y, color);
+}
+
+unsigned int ImageDrawable::getPixel(int x, int y){
+    return (unsigned int)(image.pixel(x, y));
+}
+
+// Ничего не делает
+void ImageDrawable::updateScreen(){
+    // Ничего не делает
+}
+
+// Сохранить изображение
+bool ImageDrawable::save(const string& filename){
+    return image.save(QString::fromStdString(filename));
+}
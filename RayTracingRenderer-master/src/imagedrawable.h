@@ -0,0 +1,32 @@
+#ifndef IMAGEDRAWABLE_H
+#define IMAGEDRAWABLE_H
+
+#include <string>
+#include <QImage>
+#include "drawable.h"
+
+using std::string;
+
+// Поверхность рисования вне окна: изображение в памяти, которое можно сохранить в файл
+// Используется для отрисовки без интерфейса (например, SequenceRenderer: у каждого потока своя поверхность)
+class ImageDrawable : public Drawable
+{
+public:
+    // Конструктор
+    ImageDrawable(int newXRes, int newYRes);
+
+    void setPixel(int x, int y, unsigned int color);
+    unsigned int getPixel(int x, int y);
+
+    // Ничего не делает: изображение не показывается на экране
+    void updateScreen();
+
+    // Сохранить изображение. Формат определяется расширением файла (png, jpg, bmp, ppm, ...)
+    // Возвращает: false, если файл не удалось записать
+    bool save(const string& filename);
+
+private:
+    QImage image;
+};
+
+#endif // IMAGEDRAWABLE_H
@@ -1,5 +1,7 @@
 #include "light.h"
 #include <iostream>
+#include <limits>
+#include <algorithm>
 
 using std::cout;
 
@@ -10,6 +12,7 @@ Light::Light()
     blueIntensity = 0;
     attenuationA = 0.5;
     attenuationB = 0.5;
+    influenceRadius = std::numeric_limits<double>::max();
 }
 
 
@@ -20,6 +23,7 @@ Light::Light(double newRedIntensity, double newGreenIntensity, double newBlueInt
     blueIntensity = newBlueIntensity;
     attenuationA = newAttA;
     attenuationB = newAttB;
+    influenceRadius = std::numeric_limits<double>::max();
 }
 
 // перегрузка оператора присваивания
@@ -31,6 +35,8 @@ Light& Light::operator=(const Light& rhs){
     this->attenuationA = rhs.attenuationA;
     this->attenuationB = rhs.attenuationB;
 
+    this->influenceRadius = rhs.influenceRadius;
+
     this->position = rhs.position;
 
     return *this;
@@ -48,6 +54,34 @@ double Light::getAttenuationFactor(double distance){
     return (1.0 /((double) (attenuationA + (attenuationB * distance) ) ));
 }
 
+// Вычислить радиус влияния света для заданного минимального вклада
+void Light::computeInfluenceRadius(double minContribution){
+    double maxIntensity = std::max(redIntensity, std::max(greenIntensity, blueIntensity));
+
+    // Без отбора, или ослабление не зависит от расстояния: свет влияет на всю сцену
+    if (minContribution <= 0 || attenuationB <= 0){
+        influenceRadius = std::numeric_limits<double>::max();
+        return;
+    }
+
+    // maxIntensity / (A + B * d) >= minContribution  <=>  d <= (maxIntensity / minContribution - A) / B
+    influenceRadius = std::max(0.0, (maxIntensity / minContribution - attenuationA) / attenuationB);
+}
+
+// Проверить, лежит ли точка в пределах радиуса влияния света
+// extraRadius расширяет проверку до сферы вокруг точки (например, ограничивающей сферы многоугольника)
+bool Light::isInInfluence(Vertex* thePoint, double extraRadius){
+    if (influenceRadius == std::numeric_limits<double>::max())
+        return true;
+
+    double dx = position.x - thePoint->x;
+    double dy = position.y - thePoint->y;
+    double dz = position.z - thePoint->z;
+    double reach = influenceRadius + extraRadius;
+
+    return dx * dx + dy * dy + dz * dz <= reach * reach;
+}
+
 // Debug this light:
 void Light::debug(){
     cout << "\nLight: ";
@@ -29,6 +29,15 @@ public:
 
     double attenuationA, attenuationB;  // Константы затухания
 
+    double influenceRadius;             // Расстояние, за которым вклад света меньше минимального. Вычисляется computeInfluenceRadius()
+
+    // Вычислить радиус влияния света для заданного минимального вклада
+    // Вклад света на расстоянии d: max(intensity) / (attenuationA + attenuationB * d)
+    void computeInfluenceRadius(double minContribution);
+
+    // Проверить, лежит ли точка в пределах радиуса влияния света
+    bool isInInfluence(Vertex* thePoint, double extraRadius = 0);
+
     // Debug this light:
     void debug();
 
@@ -1,21 +1,172 @@
 #include "window361.h"
 #include "client.h"
+#include "tracer.h"
+#include "assetcache.h"
+#include "sequencerenderer.h"
+#include "bvhbenchmark.h"
 #include <QApplication>
 #include <iostream>
 
+// Output resolution of the window and of offline frames, unless --resolution is given
+static const int DEFAULT_X_RES = 1000;
+static const int DEFAULT_Y_RES = 1000;
+
+// Write the recorded trace events if --trace was given (needs a CONFIG+=trace build)
+static void writeTrace(int traceIndex, const QString& traceFile)
+{
+    if (traceIndex < 0 || !Tracer::isEnabled())
+        return;
+
+    if (Tracer::writeJson(traceFile.toStdString()))
+        std::cout << "Trace written to " << traceFile.toStdString() << " (" << Tracer::getEventCount() << " events, " << Tracer::getDroppedEventCount() << " dropped)\n";
+    else
+        std::cout << "Could not write trace to " << traceFile.toStdString() << "\n";
+}
+
 int main(int argc, char *argv[])
 {
 
     QApplication app(argc, argv);   // because it's a Qt application
-    Window361 window;               // make and show the window--size is already correct
-    window.show();
-    Drawable *sheet = window.getDrawable();
 
     // Handle command line arguments:
     QStringList args = app.arguments();
-    Client client(sheet);           // the client gets a (Drawable *)
+
+    // --halfspace: draw filled triangles with the tiled edge-function rasterizer instead of the scanline one
+    RasterizerType rasterizer = args.contains("--halfspace") ? halfSpaceRasterizer : scanlineRasterizer;
+
+    // --specular-table / --blinn-phong: tabulated power function or Blinn-Phong half vector instead of exact pow()
+    SpecularModel specularModel = phongSpecular;
+    if (args.contains("--specular-table"))
+        specularModel = tablePhongSpecular;
+    else if (args.contains("--blinn-phong"))
+        specularModel = blinnPhongSpecular;
+
+    // --full-redraw: redraw every pixel each frame instead of only the regions that changed since the previous one
+    bool isDirtyRegionsEnabled = !args.contains("--full-redraw");
+
+    // --bake-lighting: bake the shadows that meshes marked 'static' in the scene file cast from the lights, instead of tracing them per pixel
+    bool isBakedLightingEnabled = args.contains("--bake-lighting");
+
+    // --antialias <n>: take n samples (up to 16) on pixels at mesh edges, depth creases and sharp colour changes; other pixels keep one
+    int antialiasIndex = args.indexOf("--antialias");
+    int antiAliasingSamples = (antialiasIndex >= 0 && antialiasIndex + 1 < args.size()) ? args.at(antialiasIndex + 1).toInt() : 1;
+
+    // --resolution <width>x<height>: output resolution of the window and of offline frames
+    int xRes = DEFAULT_X_RES, yRes = DEFAULT_Y_RES;
+    int resolutionIndex = args.indexOf("--resolution");
+    if (resolutionIndex >= 0 && resolutionIndex + 1 < args.size()){
+        QStringList size = args.at(resolutionIndex + 1).split('x');
+        if (size.size() == 2 && size.at(0).toInt() > 0 && size.at(1).toInt() > 0){
+            xRes = size.at(0).toInt();
+            yRes = size.at(1).toInt();
+        }
+        else
+            std::cout << "--resolution ignored: expected <width>x<height>\n";
+    }
+
+    // --render-scale <s>: render at s (0.25 .. 1) times the output resolution and upscale to it
+    //   --upscale-edges: keep neighbours with sharply different colours out of the bilinear upscale filter
+    //   --target-frame-ms <t>: in the window, adjust the scale after each full page so that pages take about t ms
+    int scaleIndex = args.indexOf("--render-scale");
+    double renderScale = (scaleIndex >= 0 && scaleIndex + 1 < args.size()) ? args.at(scaleIndex + 1).toDouble() : 1.0;
+    UpscaleFilter upscaleFilter = args.contains("--upscale-edges") ? edgeAwareUpscale : bilinearUpscale;
+    int targetIndex = args.indexOf("--target-frame-ms");
+    double targetFrameTime = (targetIndex >= 0 && targetIndex + 1 < args.size()) ? args.at(targetIndex + 1).toDouble() : 0.0;
+
+    // --scene <file>: render a .simp scene description instead of ./foucault.simp
+    int sceneIndex = args.indexOf("--scene");
+    string sceneFile = (sceneIndex >= 0 && sceneIndex + 1 < args.size()) ? args.at(sceneIndex + 1).toStdString() : string(FileInterpreter::DEFAULT_SCENE_FILENAME);
+
+    // --watch-assets: drop cached obj meshes when their files change, instead of checking each file's modification time per frame
+    if (args.contains("--watch-assets"))
+        AssetCache::getInstance().setWatchFiles(true);
+
+    // --asset-cache-mb <n>: evict least recently used obj meshes once the cache holds more than n megabytes
+    int cacheLimitIndex = args.indexOf("--asset-cache-mb");
+    if (cacheLimitIndex >= 0 && cacheLimitIndex + 1 < args.size())
+        AssetCache::getInstance().setMemoryLimit((std::size_t)args.at(cacheLimitIndex + 1).toULongLong() << 20);
+
+    // --trace <file>: write the recorded scoped events as Chrome trace JSON on exit (needs a CONFIG+=trace build)
+    int traceIndex = args.indexOf("--trace");
+    QString traceFile = (traceIndex >= 0 && traceIndex + 1 < args.size()) ? args.at(traceIndex + 1) : QString("trace.json");
+    if (traceIndex >= 0 && !Tracer::isEnabled())
+        std::cout << "--trace ignored: build with CONFIG+=trace to record events\n";
+    TRACE_THREAD_NAME("main");
+
+    // --bench-bvh [file.obj ...]: compare median-split and SAH ray hierarchies on the scene's meshes, the given obj files
+    //   and generated stress meshes, then exit
+    //   --threads <n>: build thread count (default: one per core)
+    //   --rays <n>: rays traced per mesh
+    int benchIndex = args.indexOf("--bench-bvh");
+    if (benchIndex >= 0){
+        BvhBenchmark benchmark;
+        benchmark.addSceneMeshes(sceneFile);
+        for (int i = benchIndex + 1; i < args.size() && !args.at(i).startsWith("--"); i++)
+            benchmark.addObjFile(args.at(i).toStdString());
+        benchmark.addGeneratedMeshes();
+
+        int threadsIndex = args.indexOf("--threads");
+        if (threadsIndex >= 0 && threadsIndex + 1 < args.size())
+            benchmark.setThreadCount(args.at(threadsIndex + 1).toUInt());
+
+        int raysIndex = args.indexOf("--rays");
+        if (raysIndex >= 0 && raysIndex + 1 < args.size())
+            benchmark.setRayCount(args.at(raysIndex + 1).toUInt());
+
+        benchmark.run();
+        writeTrace(traceIndex, traceFile);
+        return 0;
+    }
+
+    // --sequence <first> <last>: render the animation frames offline on all cores instead of opening the window
+    //   --threads <n>: worker thread count (default: one per core)
+    //   --output <prefix>: frame file name prefix, may include a directory (default: ./frames/frame_)
+    //   --format <ext>: image format by extension (default: png)
+    int sequenceIndex = args.indexOf("--sequence");
+    if (sequenceIndex >= 0 && sequenceIndex + 2 < args.size()){
+        SequenceRenderer sequence(xRes, yRes);
+        sequence.setFrameRange(args.at(sequenceIndex + 1).toInt(), args.at(sequenceIndex + 2).toInt());
+        sequence.setSceneFile(sceneFile);
+        sequence.setRasterizer(rasterizer);
+        sequence.setSpecularModel(specularModel);
+        sequence.setDirtyRegionsEnabled(isDirtyRegionsEnabled);
+        sequence.setBakedLightingEnabled(isBakedLightingEnabled);
+        sequence.setAntiAliasingSamples(antiAliasingSamples);
+        sequence.setRenderScale(renderScale, upscaleFilter);
+
+        int threadsIndex = args.indexOf("--threads");
+        if (threadsIndex >= 0 && threadsIndex + 1 < args.size())
+            sequence.setThreadCount(args.at(threadsIndex + 1).toUInt());
+
+        int outputIndex = args.indexOf("--output");
+        int formatIndex = args.indexOf("--format");
+        sequence.setOutput((outputIndex >= 0 && outputIndex + 1 < args.size()) ? args.at(outputIndex + 1).toStdString() : string("./frames/frame_"),
+                           (formatIndex >= 0 && formatIndex + 1 < args.size()) ? args.at(formatIndex + 1).toStdString() : string("png"));
+
+        int written = sequence.render();
+        writeTrace(traceIndex, traceFile);
+        return written > 0 ? 0 : 1;
+    }
+
+    Window361 window(xRes, yRes);   // make and show the window
+    window.show();
+    Drawable *sheet = window.getDrawable();
+
+    Client client(sheet, xRes, yRes);   // the client gets a (Drawable *)
+    client.setRasterizer(rasterizer);
+    client.setSpecularModel(specularModel);
+    client.setDirtyRegionsEnabled(isDirtyRegionsEnabled);
+    client.setBakedLightingEnabled(isBakedLightingEnabled);
+    client.setAntiAliasingSamples(antiAliasingSamples);
+    client.setRenderScale(renderScale);
+    client.setUpscaleFilter(upscaleFilter);
+    client.setTargetFrameTime(targetFrameTime);
+    client.setSceneFile(sceneFile);
     window.setPageTurner(&client);  // the window must be given a (PageTurner *)
 
-    return app.exec();
-}
+    int result = app.exec();
 
+    writeTrace(traceIndex, traceFile);
+
+    return result;
+}
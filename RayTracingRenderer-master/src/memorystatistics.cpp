@@ -0,0 +1,187 @@
+#include "memorystatistics.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+
+using std::cout;
+
+MemoryStatistics::Counters MemoryStatistics::counters[MEMORY_SUBSYSTEM_COUNT];
+thread_local MemorySubsystem MemoryStatistics::currentSubsystem = untaggedMemory;
+
+// Собрано ли приложение с учетом памяти
+bool MemoryStatistics::isEnabled(){
+#ifdef RENDER_MEMORY_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Начать новый кадр
+void MemoryStatistics::beginFrame(){
+    for (int i = 0; i < MEMORY_SUBSYSTEM_COUNT; i++){
+        counters[i].peakBytes = counters[i].liveBytes.load();
+        counters[i].frameAllocations = 0;
+        counters[i].frameFrees = 0;
+        counters[i].frameBytes = 0;
+    }
+}
+
+// Вывести счетчики всех подсистем
+void MemoryStatistics::debug(){
+    if (!isEnabled())
+        return;
+
+    cout << "Memory by subsystem:\tlive\tpeak\tallocs\tfrees\tbytes allocated (this frame)\n";
+
+    std::size_t totalLive = 0, totalAllocations = 0, totalFrees = 0, totalBytes = 0;
+    for (int i = 0; i < MEMORY_SUBSYSTEM_COUNT; i++){
+        MemorySubsystem theSubsystem = (MemorySubsystem)i;
+
+        cout << "  " << std::left << std::setw(12) << getSubsystemName(theSubsystem) << std::right
+             << "\t" << getLiveBytes(theSubsystem)
+             << "\t" << getPeakBytes(theSubsystem)
+             << "\t" << getFrameAllocations(theSubsystem)
+             << "\t" << getFrameFrees(theSubsystem)
+             << "\t" << getFrameBytes(theSubsystem) << "\n";
+
+        totalLive += getLiveBytes(theSubsystem);
+        totalAllocations += getFrameAllocations(theSubsystem);
+        totalFrees += getFrameFrees(theSubsystem);
+        totalBytes += getFrameBytes(theSubsystem);
+    }
+
+    cout << "  " << std::left << std::setw(12) << "total" << std::right
+         << "\t" << totalLive << "\t-\t" << totalAllocations << "\t" << totalFrees << "\t" << totalBytes << "\n";
+}
+
+// Выделено и не освобождено
+std::size_t MemoryStatistics::getLiveBytes(MemorySubsystem theSubsystem){
+    return (std::size_t)counters[theSubsystem].liveBytes.load();
+}
+
+// Наибольший живой объем с начала кадра
+std::size_t MemoryStatistics::getPeakBytes(MemorySubsystem theSubsystem){
+    return (std::size_t)counters[theSubsystem].peakBytes.load();
+}
+
+// Выделения с начала кадра
+std::size_t MemoryStatistics::getFrameAllocations(MemorySubsystem theSubsystem){
+    return (std::size_t)counters[theSubsystem].frameAllocations.load();
+}
+
+// Освобождения с начала кадра
+std::size_t MemoryStatistics::getFrameFrees(MemorySubsystem theSubsystem){
+    return (std::size_t)counters[theSubsystem].frameFrees.load();
+}
+
+// Байты, выделенные с начала кадра
+std::size_t MemoryStatistics::getFrameBytes(MemorySubsystem theSubsystem){
+    return (std::size_t)counters[theSubsystem].frameBytes.load();
+}
+
+// Учесть выделение блока
+void MemoryStatistics::recordAllocation(MemorySubsystem theSubsystem, std::size_t bytes){
+    Counters& theCounters = counters[theSubsystem];
+
+    long long live = theCounters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    theCounters.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    theCounters.frameBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    // Обновляем пик, если другой поток не успел записать большее значение:
+    long long peak = theCounters.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !theCounters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)){
+        // compare_exchange_weak обновил peak, повторяем
+    }
+}
+
+// Учесть освобождение блока
+void MemoryStatistics::recordFree(MemorySubsystem theSubsystem, std::size_t bytes){
+    counters[theSubsystem].liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    counters[theSubsystem].frameFrees.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Подсистема, которой помечаются выделения текущего потока
+MemorySubsystem MemoryStatistics::getCurrentSubsystem(){
+    return currentSubsystem;
+}
+
+// Название подсистемы для вывода
+const char* MemoryStatistics::getSubsystemName(MemorySubsystem theSubsystem){
+    switch (theSubsystem){
+    case loaderMemory:
+        return "loader";
+    case sceneMemory:
+        return "scene";
+    case geometryMemory:
+        return "geometry";
+    case rasterMemory:
+        return "raster";
+    case rayTracingMemory:
+        return "ray tracing";
+    default:
+        return "untagged";
+    }
+}
+
+// Помечает выделения текущего потока подсистемой
+MemoryStatistics::Scope::Scope(MemorySubsystem theSubsystem){
+    previous = currentSubsystem;
+    currentSubsystem = theSubsystem;
+}
+
+// Восстанавливает предыдущую подсистему
+MemoryStatistics::Scope::~Scope(){
+    currentSubsystem = previous;
+}
+
+
+#ifdef RENDER_MEMORY_STATS
+
+// Заголовок перед каждым блоком: размер и подсистема, выделившая блок
+// Размер заголовка кратен max_align_t, поэтому пользовательский указатель сохраняет выравнивание malloc
+struct AllocationHeader {
+    std::size_t bytes;
+    MemorySubsystem subsystem;
+};
+
+static const std::size_t HEADER_SIZE = ((sizeof(AllocationHeader) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t)) * alignof(std::max_align_t);
+
+// Глобальное выделение памяти с учетом подсистемы
+void* operator new(std::size_t bytes){
+    void* raw = std::malloc(bytes + HEADER_SIZE);
+    if (raw == nullptr)
+        throw std::bad_alloc();
+
+    AllocationHeader* theHeader = static_cast<AllocationHeader*>(raw);
+    theHeader->bytes = bytes;
+    theHeader->subsystem = MemoryStatistics::getCurrentSubsystem();
+    MemoryStatistics::recordAllocation(theHeader->subsystem, bytes);
+
+    return static_cast<char*>(raw) + HEADER_SIZE;
+}
+
+// Глобальное выделение массива
+void* operator new[](std::size_t bytes){
+    return operator new(bytes);
+}
+
+// Глобальное освобождение памяти: учитывается в подсистеме, выделившей блок
+void operator delete(void* pointer) noexcept {
+    if (pointer == nullptr)
+        return;
+
+    AllocationHeader* theHeader = reinterpret_cast<AllocationHeader*>(static_cast<char*>(pointer) - HEADER_SIZE);
+    MemoryStatistics::recordFree(theHeader->subsystem, theHeader->bytes);
+
+    std::free(theHeader);
+}
+
+// Глобальное освобождение массива
+void operator delete[](void* pointer) noexcept {
+    operator delete(pointer);
+}
+
+#endif // RENDER_MEMORY_STATS
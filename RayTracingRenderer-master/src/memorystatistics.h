@@ -0,0 +1,84 @@
+#ifndef MEMORYSTATISTICS_H
+#define MEMORYSTATISTICS_H
+
+#include <atomic>
+#include <cstddef>
+
+// Подсистемы, по которым учитывается память
+enum MemorySubsystem {
+    untaggedMemory = 0,     // Выделения вне помеченных участков кода
+    loaderMemory,           // Чтение и разбор файлов, кэш уровней детализации
+    sceneMemory,            // Объекты Scene и их копии (сетки, грани, вершины)
+    geometryMemory,         // Преобразования, отбор, освещение и отсечение граней
+    rasterMemory,           // Растеризация и Z-буфер
+    rayTracingMemory,       // Отраженные лучи и лучи теней
+    MEMORY_SUBSYSTEM_COUNT
+};
+
+// Учет памяти по подсистемам
+// Включается при сборке с RENDER_MEMORY_STATS (qmake CONFIG+=memory_stats): тогда глобальные operator new/delete
+// записывают в заголовок каждого блока его размер и подсистему, активную в текущем потоке в момент выделения.
+// Освобождение учитывается в той подсистеме, которая выделила блок, поэтому живые байты остаются точными,
+// даже если память освобождает другой код. Без RENDER_MEMORY_STATS учет не компилируется и ничего не стоит
+class MemoryStatistics
+{
+public:
+    // Собрано ли приложение с учетом памяти
+    static bool isEnabled();
+
+    // Начать новый кадр: сбрасывает счетчики кадра, пиковое значение начинается с текущего живого объема
+    static void beginFrame();
+
+    // Вывести счетчики всех подсистем
+    static void debug();
+
+    // Счетчики подсистемы:
+    static std::size_t getLiveBytes(MemorySubsystem theSubsystem);          // Выделено и не освобождено
+    static std::size_t getPeakBytes(MemorySubsystem theSubsystem);          // Наибольший живой объем с начала кадра
+    static std::size_t getFrameAllocations(MemorySubsystem theSubsystem);   // Выделения с начала кадра
+    static std::size_t getFrameFrees(MemorySubsystem theSubsystem);         // Освобождения с начала кадра
+    static std::size_t getFrameBytes(MemorySubsystem theSubsystem);         // Байты, выделенные с начала кадра
+
+    // Учесть выделение и освобождение блока. Вызываются из operator new/delete
+    static void recordAllocation(MemorySubsystem theSubsystem, std::size_t bytes);
+    static void recordFree(MemorySubsystem theSubsystem, std::size_t bytes);
+
+    // Подсистема, которой помечаются выделения текущего потока
+    static MemorySubsystem getCurrentSubsystem();
+
+    // Помечает выделения текущего потока подсистемой на время жизни объекта
+    class Scope
+    {
+    public:
+        Scope(MemorySubsystem theSubsystem);
+        ~Scope();
+
+    private:
+        MemorySubsystem previous;
+    };
+
+private:
+    // Счетчики одной подсистемы. Атомарны, так как выделять память может любой поток
+    struct Counters {
+        std::atomic<long long> liveBytes;
+        std::atomic<long long> peakBytes;
+        std::atomic<long long> frameAllocations;
+        std::atomic<long long> frameFrees;
+        std::atomic<long long> frameBytes;
+    };
+
+    static Counters counters[MEMORY_SUBSYSTEM_COUNT];
+    static thread_local MemorySubsystem currentSubsystem;
+
+    // Название подсистемы для вывода
+    static const char* getSubsystemName(MemorySubsystem theSubsystem);
+};
+
+// Пометить выделения до конца текущего блока кода. Без RENDER_MEMORY_STATS раскрывается в пустую инструкцию
+#ifdef RENDER_MEMORY_STATS
+#define MEMORY_SCOPE(theSubsystem) MemoryStatistics::Scope currentMemoryScope(theSubsystem)
+#else
+#define MEMORY_SCOPE(theSubsystem) do {} while (0)
+#endif
+
+#endif // MEMORYSTATISTICS_H
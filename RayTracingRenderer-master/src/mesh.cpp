@@ -1,6 +1,7 @@
 #include "mesh.h"
 #include "polygon.h"
 #include <iostream>
+#include <algorithm>
 
 using std::cout;
 
@@ -9,23 +10,40 @@ Mesh::Mesh(){
     isWireframe = true; // По умолчанию заполнено
 
     faces.reserve(3);
-    boundingBoxFaces.reserve(6);
 }
 
 // Копировать конструктор
 Mesh::Mesh(const Mesh &existingMesh){
     faces = existingMesh.faces;
+    lodFaces = existingMesh.lodFaces;
     isWireframe = existingMesh.isWireframe;
+    isStatic = existingMesh.isStatic;
 
-    boundingBoxFaces = existingMesh.boundingBoxFaces;
+    boundingBox = existingMesh.boundingBox;
+    boundingSphereCenter = existingMesh.boundingSphereCenter;
+    boundingSphereRadius = existingMesh.boundingSphereRadius;
+
+    objectBvhs = existingMesh.objectBvhs;
+    objectToMesh = existingMesh.objectToMesh;
+    geometryVersion = existingMesh.geometryVersion;
+    meshTransform = existingMesh.meshTransform;
 }
 
 // Перегруженный оператор присваивания
 Mesh& Mesh::operator=(const Mesh& rhs){
     this->faces = rhs.faces;
+    this->lodFaces = rhs.lodFaces;
     this->isWireframe = rhs.isWireframe;
+    this->isStatic = rhs.isStatic;
+
+    this->boundingBox = rhs.boundingBox;
+    this->boundingSphereCenter = rhs.boundingSphereCenter;
+    this->boundingSphereRadius = rhs.boundingSphereRadius;
 
-    this->boundingBoxFaces = rhs.boundingBoxFaces;
+    this->objectBvhs = rhs.objectBvhs;
+    this->objectToMesh = rhs.objectToMesh;
+    this->geometryVersion = rhs.geometryVersion;
+    this->meshTransform = rhs.meshTransform;
 
     return *this;
 }
@@ -36,134 +54,122 @@ void Mesh::transform(TransformationMatrix* theMatrix){
 }
 
 // Преобразовать этот многоугольник с помощью матрицы преобразования
+// Если границы уже созданы, прямоугольник пересчитывается по преобразованным вершинам в том же проходе
 void Mesh::transform(TransformationMatrix* theMatrix, bool doRound){
+    bool updateBounds = hasBounds();
+    BoundingBox newBox;
 
     // Преобразуем грани видимой сетки:
     for(unsigned int i = 0; i < faces.size(); i++){
         faces[i].transform(theMatrix, doRound);
+        if (updateBounds)
+            newBox.add(faces[i]);
     }
 
-    // Преобразование граней ограничительной рамки:
-    for (unsigned int i = 0; i < boundingBoxFaces.size(); i++){
-        boundingBoxFaces[i].transform(theMatrix, doRound);
+    // Преобразуем упрощенные уровни детализации:
+    for (auto &currentLevel : lodFaces){
+        for (auto &currentFace : currentLevel){
+            currentFace.transform(theMatrix, doRound);
+            if (updateBounds)
+                newBox.add(currentFace);
+        }
     }
+
+    if (updateBounds)
+        setBounds(newBox);
+
+    // Иерархии граней не преобразуются: накапливается матрица экземпляра
+    if (objectBvhs != nullptr)
+        objectToMesh = (*theMatrix) * objectToMesh;
+
+    meshTransform = (*theMatrix) * meshTransform;
 }
 
 // Создать / обновить ограничивающий прямоугольник вокруг граней этой сетки
-// Условие: сетка имеет хотя бы 1 полигон
+// Уровни детализации учитываются: трассировка лучей отсекает по прямоугольнику и грани упрощенных уровней
 void Mesh::generateBoundingBox(){
+    BoundingBox newBox;
 
-    double xMin = faces[0].vertices[0].x;
-    double xMax = faces[0].vertices[0].x;
-    double yMin = faces[0].vertices[0].y;
-    double yMax = faces[0].vertices[0].y;
-    double zMin = faces[0].vertices[0].z;
-    double zMax = faces[0].vertices[0].z;
+    for (auto &currentFace : faces)
+        newBox.add(currentFace);
 
-    for (int i = 0; i < faces.size(); i++){
-
-        // Получить количество вершин для текущего многоугольника один раз:
-        int numVertices = faces[i].getVertexCount();
-
-        // Перебираем каждую вершину в многоугольнике
-        for (int j = 0; j < numVertices; j++){
+    for (auto &currentLevel : lodFaces){
+        for (auto &currentFace : currentLevel)
+            newBox.add(currentFace);
+    }
 
-            if (faces[i].vertices[j].x < xMin)
-                xMin = faces[i].vertices[j].x;
+    setBounds(newBox);
+}
 
-            if (faces[i].vertices[j].x > xMax)
-                xMax = faces[i].vertices[j].x;
+// Созданы ли границы сетки
+bool Mesh::hasBounds(){
+    return !boundingBox.isEmpty();
+}
 
-            if (faces[i].vertices[j].y < yMin)
-                yMin = faces[i].vertices[j].y;
+// Получить ограничивающую сферу сетки
+// Условие: ограничивающий прямоугольник уже создан
+void Mesh::getBoundingSphere(Vertex& center, double& radius){
+    center = boundingSphereCenter;
+    radius = boundingSphereRadius;
+}
 
-            if (faces[i].vertices[j].y > yMax)
-                yMax = faces[i].vertices[j].y;
+// Запомнить новый прямоугольник и пересчитать сферу
+void Mesh::setBounds(BoundingBox& newBox){
+    // Убедитесь, что ограничивающая рамка не плоская:
+    newBox.inflateFlatSides(0.001);
 
-            if (faces[i].vertices[j].z < zMin)
-                zMin = faces[i].vertices[j].z;
+    boundingBox = newBox;
+    boundingBox.getBoundingSphere(boundingSphereCenter, boundingSphereRadius);
+}
 
-            if (faces[i].vertices[j].z > zMax)
-                zMax = faces[i].vertices[j].z;
-        }
+// Отбор сетки: консервативная проверка ограничивающего прямоугольника по ближней / дальней плоскостям и усеченному конусу
+// Предварительное условие: сетка находится в пространстве камеры
+// Возвращает: false, только если сетка гарантированно целиком вне объема видимости
+bool Mesh::isInViewVolume(double hither, double yon, double xLow, double xHigh, double yLow, double yHigh){
+    if (!hasBounds())
+        return true;
+
+    // Сетка отбрасывается, если все углы прямоугольника лежат снаружи одной из плоскостей.
+    // Боковые плоскости усеченного конуса в пространстве камеры: x = xLow * z, x = xHigh * z, y = yLow * z, y = yHigh * z
+    bool beforeHither = true;
+    bool afterYon = true;
+    bool belowXLow = true;
+    bool aboveXHigh = true;
+    bool belowYLow = true;
+    bool aboveYHigh = true;
+
+    for (int i = 0; i < 8; i++){
+        Vertex corner = boundingBox.getCorner(i);
+
+        if (corner.z >= hither)
+            beforeHither = false;
+        if (corner.z <= yon)
+            afterYon = false;
+        if (corner.x >= xLow * corner.z)
+            belowXLow = false;
+        if (corner.x <= xHigh * corner.z)
+            aboveXHigh = false;
+        if (corner.y >= yLow * corner.z)
+            belowYLow = false;
+        if (corner.y <= yHigh * corner.z)
+            aboveYHigh = false;
     }
 
-    double swell = 0.001;
-
-    // Убедитесь, что ограничивающая рамка не плоская:
-    if (xMin == xMax){
-        xMin -= swell;
-        xMax += swell;
-    }
+    return !(beforeHither || afterYon || belowXLow || aboveXHigh || belowYLow || aboveYHigh);
+}
 
-    if (yMin == yMax){
-        yMin -= swell;
-        yMax += swell;
-    }
+// Получить количество уровней детализации (уровень 0 - исходные грани)
+int Mesh::getLodCount(){
+    return (int)lodFaces.size() + 1;
+}
 
-    if (zMin == zMax){
-        zMin -= swell;
-        zMax += swell;
-    }
+// Получить грани заданного уровня детализации
+vector<Polygon>& Mesh::getLodFaces(int level){
+    if (level <= 0 || lodFaces.empty())
+        return faces;
 
-    // Собираем 6 сторон ограничивающего куба, используя наши минимальные / максимальные координаты
-    Polygon left, right, front, back, top, bottom;
-
-    Vertex frontLeftTop(xMin, yMax, zMin);
-    Vertex frontLeftBot(xMin, yMin, zMin); // Mins
-    Vertex frontRightTop(xMax, yMax, zMin);
-    Vertex frontRightBot(xMax, yMin, zMin);
-
-    Vertex backLeftTop(xMin, yMax, zMax);
-    Vertex backLeftBot(xMin, yMin, zMax);
-    Vertex backRightTop(xMax, yMax, zMax); // Maxs
-    Vertex backRightBot(xMax, yMin, zMax);
-
-    left.addVertex( backLeftTop );
-    left.addVertex( backLeftBot);
-    left.addVertex( frontLeftBot );
-    left.addVertex( frontLeftTop );
-
-    right.addVertex( frontRightTop );
-    right.addVertex( frontRightBot );
-    right.addVertex( backRightBot );
-    right.addVertex( backRightTop );
-
-    top.addVertex( backLeftTop );
-    top.addVertex( frontLeftTop );
-    top.addVertex( frontRightTop );
-    top.addVertex( backRightTop );
-
-    bottom.addVertex( frontLeftBot );
-    bottom.addVertex( backLeftBot );
-    bottom.addVertex( backRightBot );
-    bottom.addVertex( frontRightBot );
-
-    front.addVertex( frontLeftTop );
-    front.addVertex( frontLeftBot );
-    front.addVertex( frontRightBot );
-    front.addVertex( frontRightTop );
-
-    back.addVertex( backRightTop );
-    back.addVertex( backRightBot );
-    back.addVertex( backLeftBot );
-    back.addVertex( backLeftTop );
-
-    // Генерируем нормали поверхности для каждой грани ограничительной рамки:
-    left.faceNormal = left.getFaceNormal();
-    right.faceNormal = right.getFaceNormal();
-    front.faceNormal = front.getFaceNormal();
-    back.faceNormal = back.getFaceNormal();
-    top.faceNormal = top.getFaceNormal();
-    bottom.faceNormal = bottom.getFaceNormal();
-
-    // Добавить грани в ограничительную рамку:
-    boundingBoxFaces.emplace_back(left);
-    boundingBoxFaces.emplace_back(right);
-    boundingBoxFaces.emplace_back(top);
-    boundingBoxFaces.emplace_back(bottom);
-    boundingBoxFaces.emplace_back(front);
-    boundingBoxFaces.emplace_back(back);
+    if (level > (int)lodFaces.size())
+        level = (int)lodFaces.size();
 
+    return lodFaces[level - 1];
 }
-
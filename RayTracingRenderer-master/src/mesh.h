@@ -2,6 +2,9 @@
 #define MESH_H
 
 #include "polygon.h"
+#include "boundingbox.h"
+#include "meshbvh.h"
+#include <memory>
 #include <vector>
 
 using std::vector;
@@ -25,17 +28,54 @@ public:
     // Преобразование сетки с помощью матрицы преобразования
     void transform(TransformationMatrix* theMatrix, bool doRound);
 
-    // Создать / обновить ограничивающий прямоугольник вокруг граней этой сетки
-    // Условие: сетка имеет хотя бы 1 полигон
+    // Создать / обновить ограничивающий прямоугольник и сферу вокруг граней этой сетки (всех уровней детализации)
+    // После создания границы пересчитываются при каждом преобразовании сетки
     void generateBoundingBox();
 
+    // Созданы ли границы сетки
+    bool hasBounds();
+
+    // Получить ограничивающую сферу сетки, построенную по ограничивающему прямоугольнику
+    // Условие: ограничивающий прямоугольник уже создан
+    void getBoundingSphere(Vertex& center, double& radius);
+
+    // Отбор сетки: консервативная проверка ограничивающего прямоугольника по ближней / дальней плоскостям и усеченному конусу
+    // Предварительное условие: сетка находится в пространстве камеры
+    // Возвращает: false, только если сетка гарантированно целиком вне объема видимости
+    bool isInViewVolume(double hither, double yon, double xLow, double xHigh, double yLow, double yHigh);
+
+    // Получить количество уровней детализации (уровень 0 - исходные грани)
+    int getLodCount();
+
+    // Получить грани заданного уровня детализации. Уровень 0 - исходные грани, уровни > 0 - упрощенные версии
+    vector<Polygon>& getLodFaces(int level);
+
     // Debug this mesh
     void debug();
 
     // Mesh attributes:
     vector<Polygon> faces; // Набор граней этой сетки
-    vector<Polygon> boundingBoxFaces;    // Набор из 6 граней, образующих ограничивающий прямоугольник вокруг этого многоугольника
+    vector< vector<Polygon> > lodFaces;  // Упрощенные версии граней: lodFaces[i] - уровень детализации i + 1 (каждый следующий грубее)
+    BoundingBox boundingBox;             // Ограничивающий прямоугольник граней всех уровней детализации в текущем пространстве сетки
+    Vertex boundingSphereCenter;         // Сфера, описанная вокруг boundingBox
+    double boundingSphereRadius = 0;
+
+    // Иерархии граней уровней детализации в пространстве объекта файла obj (общие с AssetCache; [0] - faces, [i] - lodFaces[i - 1])
+    // nullptr, если сетка собрана не из одного файла
+    std::shared_ptr< const vector<MeshBvh> > objectBvhs;
+    TransformationMatrix objectToMesh;   // Из пространства объекта иерархий в текущее пространство граней сетки
     bool isWireframe = false; // Должны ли полигоны этой сетки отображаться в каркасном виде или заполняться
+    bool isStatic = false;    // Сетка не движется между кадрами: ее освещение от неподвижных источников можно запечь
+
+    // Версия граней: меняется при любом изменении вершин или материалов граней, кроме transform (оно накапливается в meshTransform).
+    // Сетки, собранные из одних и тех же данных, получают одну версию, поэтому DirtyRegionTracker сравнивает кадры по версии
+    // и meshTransform, не обходя вершины. Код, изменяющий грани напрямую, должен изменить и версию
+    unsigned long long geometryVersion = 0;
+    TransformationMatrix meshTransform;  // Преобразования transform, примененные после сборки граней
+
+private:
+    // Запомнить новый прямоугольник (раздвинув плоские стороны) и пересчитать сферу
+    void setBounds(BoundingBox& newBox);
 };
 
 #endif // MESH_H
@@ -0,0 +1,260 @@
+#include "meshbvh.h"
+#include "memorystatistics.h"
+#include "tracer.h"
+
+#include <algorithm>
+#include <thread>
+
+// Запас прямоугольников узлов относительно диагонали корня: луч, переведенный в пространство объекта,
+// вычислен с другими ошибками округления, чем точная проверка грани в пространстве камеры
+static const double NODE_MARGIN = 1e-6;
+
+static_assert(sizeof(BoundingBox) + 3 * sizeof(unsigned int) <= 64, "MeshBvh node must fit one cache line");
+
+// Конструктор
+MeshBvh::MeshBvh(){
+    depth = 0;
+}
+
+// Построить иерархию по граням
+void MeshBvh::build(vector<Polygon>& faces, BvhSplitMethod method, unsigned int maxThreads){
+    TRACE_SCOPE("buildMeshBvh");
+
+    nodes.clear();
+    faceIndices.clear();
+    depth = 0;
+
+    if (faces.empty())
+        return;
+
+    BuildInput input;
+    input.method = method;
+    input.faceBounds.resize(faces.size());
+    input.centroids.resize(faces.size() * 3);
+    faceIndices.resize(faces.size());
+
+    for (unsigned int i = 0; i < faces.size(); i++){
+        input.faceBounds[i].add(faces[i]);
+        for (int axis = 0; axis < 3; axis++)
+            input.centroids[i * 3 + axis] = (input.faceBounds[i].min[axis] + input.faceBounds[i].max[axis]) / 2.0;
+        faceIndices[i] = i;
+    }
+
+    // Каждый уровень параллельного построения удваивает количество потоков
+    unsigned int threadCount = (maxThreads > 0) ? maxThreads : std::thread::hardware_concurrency();
+    int parallelLevels = 0;
+    while ((1u << parallelLevels) < threadCount)
+        parallelLevels++;
+
+    nodes.reserve(faces.size() * 2 / MAX_LEAF_FACES + 1);
+    buildNode(input, nodes, 0, faces.size(), 0, parallelLevels);
+
+    double margin = nodes[0].bounds.getDiagonal() * NODE_MARGIN;
+    for (auto &currentNode : nodes)
+        currentNode.bounds.inflate(margin);
+
+    // Уровни: потомки хранятся после родителя, поэтому один проход от корня
+    vector<int> nodeDepths(nodes.size(), 1);
+    for (unsigned int i = 0; i < nodes.size(); i++){
+        if (nodes[i].faceCount == 0){
+            nodeDepths[i + 1] = nodeDepths[i] + 1;
+            nodeDepths[ nodes[i].offset ] = nodeDepths[i] + 1;
+        }
+        depth = std::max(depth, nodeDepths[i]);
+    }
+}
+
+// Пустая иерархия
+bool MeshBvh::isEmpty() const {
+    return nodes.empty();
+}
+
+// Количество узлов
+std::size_t MeshBvh::getNodeCount() const {
+    return nodes.size();
+}
+
+// Количество уровней
+int MeshBvh::getDepth() const {
+    return depth;
+}
+
+// Оценка стоимости луча по эвристике площади поверхности
+double MeshBvh::getSahCost() const {
+    if (nodes.empty())
+        return 0;
+
+    double rootArea = nodes[0].bounds.getSurfaceArea();
+    if (rootArea <= 0)
+        return nodes[0].faceCount * INTERSECTION_COST;
+
+    double cost = 0;
+    for (auto &currentNode : nodes){
+        double nodeCost = (currentNode.faceCount > 0) ? currentNode.faceCount * INTERSECTION_COST : TRAVERSAL_COST;
+        cost += nodeCost * currentNode.bounds.getSurfaceArea() / rootArea;
+    }
+
+    return cost;
+}
+
+// Приблизительный объем данных
+std::size_t MeshBvh::getMemoryUsed() const {
+    return sizeof(MeshBvh) + nodes.size() * sizeof(Node) + faceIndices.size() * sizeof(unsigned int);
+}
+
+// Построить поддерево граней
+unsigned int MeshBvh::buildNode(const BuildInput& input, vector<Node>& output, unsigned int first, unsigned int count, int nodeDepth, int parallelLevels){
+    unsigned int nodeIndex = output.size();
+    output.emplace_back();
+
+    BoundingBox bounds;
+    BoundingBox centroidBounds;
+    for (unsigned int i = first; i < first + count; i++){
+        bounds.add(input.faceBounds[ faceIndices[i] ]);
+        const double* centroid = &input.centroids[ faceIndices[i] * 3 ];
+        centroidBounds.add( Vertex(centroid[0], centroid[1], centroid[2]) );
+    }
+    output[nodeIndex].bounds = bounds;
+
+    int axis = 0;
+    for (int i = 1; i < 3; i++){
+        if (centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis])
+            axis = i;
+    }
+
+    // Лист: мало граней, предельная глубина стека обхода или совпадающие центры
+    bool isLeaf = count <= MAX_LEAF_FACES || nodeDepth >= MAX_DEPTH - 2 || centroidBounds.max[axis] == centroidBounds.min[axis];
+
+    unsigned int leftCount = 0;
+    if (!isLeaf && input.method == sahSplit){
+        leftCount = partitionSah(input, first, count, bounds, centroidBounds, axis);
+        isLeaf = (leftCount == 0);
+    }
+
+    if (isLeaf){
+        output[nodeIndex].offset = first;
+        output[nodeIndex].faceCount = count;
+        return nodeIndex;
+    }
+
+    // Деление по медиане вдоль самой длинной оси центров
+    if (input.method == medianSplit){
+        leftCount = count / 2;
+        std::nth_element(faceIndices.begin() + first, faceIndices.begin() + first + leftCount, faceIndices.begin() + first + count,
+            [&input, axis](unsigned int a, unsigned int b){
+                return input.centroids[a * 3 + axis] < input.centroids[b * 3 + axis];
+            });
+    }
+
+    output[nodeIndex].splitAxis = axis;
+    unsigned int middle = first + leftCount;
+
+    // Правое поддерево строится в отдельном потоке в свой массив; грани потомков не пересекаются в faceIndices
+    if (parallelLevels > 0 && count >= PARALLEL_MIN_FACES){
+        vector<Node> rightNodes;
+        rightNodes.reserve((count - leftCount) * 2 / MAX_LEAF_FACES + 1);
+
+        std::thread rightWorker([&](){
+            MEMORY_SCOPE(loaderMemory);
+            TRACE_SCOPE("buildMeshBvhSubtree");
+            buildNode(input, rightNodes, middle, first + count - middle, nodeDepth + 1, parallelLevels - 1);
+        });
+        buildNode(input, output, first, leftCount, nodeDepth + 1, parallelLevels - 1);
+        rightWorker.join();
+
+        // Номера правых потомков сдвигаются на положение поддерева в общем массиве
+        unsigned int rightChild = output.size();
+        for (auto &rightNode : rightNodes){
+            if (rightNode.faceCount == 0)
+                rightNode.offset += rightChild;
+        }
+        output.insert(output.end(), rightNodes.begin(), rightNodes.end());
+        output[nodeIndex].offset = rightChild;
+
+        return nodeIndex;
+    }
+
+    buildNode(input, output, first, leftCount, nodeDepth + 1, parallelLevels);
+    unsigned int rightChild = buildNode(input, output, middle, first + count - middle, nodeDepth + 1, parallelLevels);
+
+    // Вектор узлов мог перераспределиться: узел адресуется номером
+    output[nodeIndex].offset = rightChild;
+
+    return nodeIndex;
+}
+
+// Выбрать деление узла по эвристике площади поверхности
+// Центры граней раскладываются по SAH_BINS корзинам вдоль каждой оси; для каждой из SAH_BINS - 1 границ между корзинами
+// стоимость деления = TRAVERSAL_COST + INTERSECTION_COST * (площадь левого * граней слева + площадь правого * граней справа) / площадь узла
+unsigned int MeshBvh::partitionSah(const BuildInput& input, unsigned int first, unsigned int count, const BoundingBox& bounds, const BoundingBox& centroidBounds, int& axis){
+    struct Bin {
+        BoundingBox bounds;
+        unsigned int count = 0;
+    };
+
+    double nodeArea = bounds.getSurfaceArea();
+    double bestCost = std::numeric_limits<double>::max();
+    int bestAxis = -1;
+    unsigned int bestSplit = 0;
+
+    for (int currentAxis = 0; currentAxis < 3; currentAxis++){
+        double axisMin = centroidBounds.min[currentAxis];
+        double axisExtent = centroidBounds.max[currentAxis] - axisMin;
+        if (axisExtent <= 0)
+            continue;
+
+        Bin bins[SAH_BINS];
+        double binScale = SAH_BINS / axisExtent;
+        for (unsigned int i = first; i < first + count; i++){
+            unsigned int face = faceIndices[i];
+            unsigned int bin = std::min(SAH_BINS - 1, (unsigned int)( (input.centroids[face * 3 + currentAxis] - axisMin) * binScale ));
+            bins[bin].bounds.add(input.faceBounds[face]);
+            bins[bin].count++;
+        }
+
+        // Площади и количества граней справа от каждой границы - проходом с конца
+        double rightArea[SAH_BINS];
+        unsigned int rightCount[SAH_BINS];
+        BoundingBox rightBounds;
+        unsigned int rightFaces = 0;
+        for (unsigned int bin = SAH_BINS - 1; bin > 0; bin--){
+            rightBounds.add(bins[bin].bounds);
+            rightFaces += bins[bin].count;
+            rightArea[bin] = rightBounds.getSurfaceArea();
+            rightCount[bin] = rightFaces;
+        }
+
+        BoundingBox leftBounds;
+        unsigned int leftFaces = 0;
+        for (unsigned int split = 1; split < SAH_BINS; split++){
+            leftBounds.add(bins[split - 1].bounds);
+            leftFaces += bins[split - 1].count;
+            if (leftFaces == 0 || rightCount[split] == 0)
+                continue;
+
+            double cost = leftBounds.getSurfaceArea() * leftFaces + rightArea[split] * rightCount[split];
+            if (cost < bestCost){
+                bestCost = cost;
+                bestAxis = currentAxis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    if (bestAxis < 0)
+        return 0;
+
+    // Узел остается листом, если проверить все его грани не дороже деления (плоский узел нулевой площади делится всегда)
+    if (count <= MAX_SAH_LEAF_FACES && nodeArea > 0 && count * INTERSECTION_COST <= TRAVERSAL_COST + INTERSECTION_COST * bestCost / nodeArea)
+        return 0;
+
+    double axisMin = centroidBounds.min[bestAxis];
+    double binScale = SAH_BINS / (centroidBounds.max[bestAxis] - axisMin);
+    auto middle = std::partition(faceIndices.begin() + first, faceIndices.begin() + first + count,
+        [&input, bestAxis, bestSplit, axisMin, binScale](unsigned int face){
+            return std::min(SAH_BINS - 1, (unsigned int)( (input.centroids[face * 3 + bestAxis] - axisMin) * binScale )) < bestSplit;
+        });
+
+    axis = bestAxis;
+    return middle - (faceIndices.begin() + first);
+}
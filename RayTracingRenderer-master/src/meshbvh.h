@@ -0,0 +1,135 @@
+#ifndef MESHBVH_H
+#define MESHBVH_H
+
+#include <cstddef>
+#include <vector>
+#include "boundingbox.h"
+#include "polygon.h"
+
+using std::vector;
+
+// Способ деления граней при построении иерархии
+enum BvhSplitMethod {
+    medianSplit = 0,    // Пополам по медиане центров вдоль самой длинной оси (быстрое построение, для сравнения)
+    sahSplit = 1        // Эвристика площади поверхности по корзинам (binned SAH): меньше узлов и граней на луч
+};
+
+// Иерархия ограничивающих прямоугольников граней одной сетки (нижний уровень)
+// Строится один раз в пространстве объекта файла obj и хранится в AssetCache вместе с гранями: движение сетки
+// ее не меняет, луч переводится в пространство объекта на границе экземпляра (SceneBvh).
+// Узлы хранятся одним массивом в порядке обхода в глубину: левый потомок внутреннего узла следует сразу за ним.
+// Узел занимает одну строку кэша (64 байта). Большие поддеревья строятся параллельно, каждое в свой массив,
+// после чего массивы сдвигаются и дописываются за левым поддеревом - порядок узлов не зависит от количества потоков
+class MeshBvh
+{
+public:
+    // Конструктор
+    MeshBvh();
+
+    // Построить иерархию по граням
+    // maxThreads: 0 = по количеству ядер, 1 = в текущем потоке
+    void build(vector<Polygon>& faces, BvhSplitMethod method = sahSplit, unsigned int maxThreads = 0);
+
+    // Пустая иерархия (нет граней)
+    bool isEmpty() const;
+
+    // Обойти грани листьев, прямоугольники которых луч пересекает на [0, maxDistance]
+    // Из двух потомков первым обходится ближний по направлению луча вдоль оси деления
+    // visitFace(номер грани) возвращает true, чтобы остановить обход; maxDistance может уменьшаться во время обхода
+    // boxTests увеличивается на количество проверенных прямоугольников узлов
+    // Возвращает: true, если обход остановлен посетителем
+    template <typename FaceVisitor>
+    bool traverse(const SlabRay& theRay, const double& maxDistance, FaceVisitor visitFace, unsigned long long& boxTests) const;
+
+    // Количество узлов
+    std::size_t getNodeCount() const;
+
+    // Количество уровней
+    int getDepth() const;
+
+    // Оценка стоимости луча по эвристике площади поверхности: сумма стоимостей узлов, взвешенных отношением их площади к площади корня
+    double getSahCost() const;
+
+    // Приблизительный объем данных, байт
+    std::size_t getMemoryUsed() const;
+
+    static const unsigned int MAX_LEAF_FACES = 4;       // Узлы с большим количеством граней делятся, если это не дороже по SAH
+    static const unsigned int MAX_SAH_LEAF_FACES = 16;  // Узлы с большим количеством граней делятся всегда
+    static const unsigned int SAH_BINS = 16;            // Корзины центров вдоль каждой оси
+    static const unsigned int PARALLEL_MIN_FACES = 4096; // Поддеревья меньше строятся в потоке родителя
+    static const int MAX_DEPTH = 64;                    // Глубина стека обхода
+
+    static constexpr double TRAVERSAL_COST = 1.0;       // Стоимость проверки прямоугольника узла (SAH)
+    static constexpr double INTERSECTION_COST = 1.5;    // Стоимость проверки грани (SAH)
+
+private:
+    // Узел: лист, если faceCount > 0
+    struct alignas(64) Node {
+        BoundingBox bounds;
+        unsigned int offset = 0;        // Лист: первая грань в faceIndices; внутренний узел: номер правого потомка
+        unsigned int faceCount = 0;
+        unsigned int splitAxis = 0;     // Внутренний узел: ось деления
+    };
+
+    // Данные граней на время построения
+    struct BuildInput {
+        vector<BoundingBox> faceBounds;
+        vector<double> centroids;       // Центры прямоугольников граней (по 3 координаты)
+        BvhSplitMethod method;
+    };
+
+    vector<Node> nodes;
+    vector<unsigned int> faceIndices;   // Номера граней в порядке листьев
+    int depth;
+
+    // Построить поддерево граней faceIndices[first, first + count) в конец массива output
+    // parallelLevels: сколько уровней ниже этого еще могут строить правое поддерево в отдельном потоке
+    // Возвращает: номер корня поддерева в output
+    unsigned int buildNode(const BuildInput& input, vector<Node>& output, unsigned int first, unsigned int count, int nodeDepth, int parallelLevels);
+
+    // Выбрать деление узла по эвристике площади поверхности
+    // Возвращает: количество граней левого потомка (faceIndices переставлены); 0 - узел выгоднее оставить листом
+    unsigned int partitionSah(const BuildInput& input, unsigned int first, unsigned int count, const BoundingBox& bounds, const BoundingBox& centroidBounds, int& axis);
+};
+
+// Обойти грани листьев, которые может пересечь луч
+template <typename FaceVisitor>
+bool MeshBvh::traverse(const SlabRay& theRay, const double& maxDistance, FaceVisitor visitFace, unsigned long long& boxTests) const {
+    if (nodes.empty())
+        return false;
+
+    unsigned int stack[MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0){
+        unsigned int nodeIndex = stack[--stackSize];
+        const Node& currentNode = nodes[nodeIndex];
+
+        boxTests++;
+        if (!currentNode.bounds.intersectsRay(theRay, maxDistance))
+            continue;
+
+        if (currentNode.faceCount > 0){
+            for (unsigned int i = 0; i < currentNode.faceCount; i++){
+                if (visitFace(faceIndices[currentNode.offset + i]))
+                    return true;
+            }
+            continue;
+        }
+
+        // Ближний потомок кладется в стек последним: ближайшее пересечение раньше сокращает maxDistance
+        if (theRay.inverseDirection[currentNode.splitAxis] < 0){
+            stack[stackSize++] = nodeIndex + 1;
+            stack[stackSize++] = currentNode.offset;
+        }
+        else {
+            stack[stackSize++] = currentNode.offset;
+            stack[stackSize++] = nodeIndex + 1;
+        }
+    }
+
+    return false;
+}
+
+#endif // MESHBVH_H
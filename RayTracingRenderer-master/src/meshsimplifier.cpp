@@ -0,0 +1,314 @@
+#include "meshsimplifier.h"
+#include "normalvector.h"
+
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <queue>
+#include <tuple>
+#include <cmath>
+
+using std::map;
+using std::priority_queue;
+using std::tuple;
+using std::make_tuple;
+
+// Штраф для граничных ребер: не дает «съедать» открытые края сетки
+static const double BOUNDARY_WEIGHT = 1000.0;
+
+// Конструктор квадрики: нулевая матрица
+MeshSimplifier::Quadric::Quadric(){
+    for (int i = 0; i < 10; i++)
+        q[i] = 0;
+}
+
+// Добавить квадрику плоскости ax + by + cz + d = 0
+void MeshSimplifier::Quadric::addPlane(double a, double b, double c, double d, double weight){
+    q[0] += weight * a * a;  q[1] += weight * a * b;  q[2] += weight * a * c;  q[3] += weight * a * d;
+                             q[4] += weight * b * b;  q[5] += weight * b * c;  q[6] += weight * b * d;
+                                                      q[7] += weight * c * c;  q[8] += weight * c * d;
+                                                                               q[9] += weight * d * d;
+}
+
+// Сложить две квадрики
+void MeshSimplifier::Quadric::add(const Quadric& rhs){
+    for (int i = 0; i < 10; i++)
+        q[i] += rhs.q[i];
+}
+
+// Ошибка в точке: v^T * Q * v
+double MeshSimplifier::Quadric::error(double x, double y, double z) const {
+    return    q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+            + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+            + q[7] * z * z + 2 * q[8] * z
+            + q[9];
+}
+
+// Конструктор
+MeshSimplifier::MeshSimplifier(){
+    // Ничего не делает
+}
+
+// Построить упрощенную версию набора треугольных граней
+vector<Polygon> MeshSimplifier::simplify(vector<Polygon>& faces, unsigned int targetFaceCount){
+
+    positions.clear();
+    quadrics.clear();
+    stamps.clear();
+    removed.clear();
+    triangles.clear();
+    triangleRemoved.clear();
+    vertexTriangles.clear();
+
+    vector<int> triangleSource; // Индекс исходной грани каждого треугольника: используется для копирования материала
+
+    // Свариваем вершины с одинаковыми координатами: грани хранят собственные копии вершин
+    map< tuple<double, double, double>, int > weldMap;
+    for (unsigned int i = 0; i < faces.size(); i++){
+        if (faces[i].getVertexCount() != 3)
+            continue;
+
+        for (int j = 0; j < 3; j++){
+            Vertex& current = faces[i].vertices[j];
+            tuple<double, double, double> key = make_tuple(current.x, current.y, current.z);
+
+            auto found = weldMap.find(key);
+            int index;
+            if (found == weldMap.end()){
+                index = (int)positions.size();
+                weldMap[key] = index;
+                positions.emplace_back(current);
+                positions.back().normal = NormalVector();
+            }
+            else
+                index = found->second;
+
+            // Накапливаем нормали: у сваренной вершины нормаль - среднее нормалей исходных вершин
+            positions[index].normal.xn += current.normal.xn;
+            positions[index].normal.yn += current.normal.yn;
+            positions[index].normal.zn += current.normal.zn;
+
+            triangles.push_back(index);
+        }
+        triangleSource.push_back(i);
+    }
+
+    int numTriangles = (int)triangleSource.size();
+    if (numTriangles == 0 || (unsigned int)numTriangles <= targetFaceCount)
+        return faces;
+
+    for (auto &current : positions){
+        if (!current.normal.isZero())
+            current.normal.normalize();
+    }
+
+    quadrics.resize(positions.size());
+    stamps.assign(positions.size(), 0);
+    removed.assign(positions.size(), false);
+    triangleRemoved.assign(numTriangles, false);
+    vertexTriangles.resize(positions.size());
+
+    // Квадрики плоскостей треугольников и подсчет использования ребер:
+    map< std::pair<int, int>, int > edgeUses;
+    for (int t = 0; t < numTriangles; t++){
+        Vertex& p0 = positions[ triangles[3 * t] ];
+        Vertex& p1 = positions[ triangles[3 * t + 1] ];
+        Vertex& p2 = positions[ triangles[3 * t + 2] ];
+
+        NormalVector e1(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+        NormalVector e2(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z);
+        NormalVector planeNormal = e1.crossProduct(e2);
+        double area = planeNormal.length() / 2.0;
+
+        if (area > 0){
+            planeNormal.normalize();
+            double d = -(planeNormal.xn * p0.x + planeNormal.yn * p0.y + planeNormal.zn * p0.z);
+
+            for (int k = 0; k < 3; k++)
+                quadrics[ triangles[3 * t + k] ].addPlane(planeNormal.xn, planeNormal.yn, planeNormal.zn, d, area);
+        }
+
+        for (int k = 0; k < 3; k++){
+            int a = triangles[3 * t + k];
+            int b = triangles[3 * t + (k + 1) % 3];
+            vertexTriangles[a].push_back(t);
+            edgeUses[ std::make_pair(std::min(a, b), std::max(a, b)) ]++;
+        }
+    }
+
+    // Граничные ребра: добавляем перпендикулярную плоскость с большим весом
+    for (int t = 0; t < numTriangles; t++){
+        Vertex& p0 = positions[ triangles[3 * t] ];
+        Vertex& p1 = positions[ triangles[3 * t + 1] ];
+        Vertex& p2 = positions[ triangles[3 * t + 2] ];
+        NormalVector faceNormal = NormalVector(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z).crossProduct( NormalVector(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z) );
+
+        for (int k = 0; k < 3; k++){
+            int a = triangles[3 * t + k];
+            int b = triangles[3 * t + (k + 1) % 3];
+            if (edgeUses[ std::make_pair(std::min(a, b), std::max(a, b)) ] != 1)
+                continue;
+
+            NormalVector edge(positions[b].x - positions[a].x, positions[b].y - positions[a].y, positions[b].z - positions[a].z);
+            NormalVector edgePlane = edge.crossProduct(faceNormal);
+            if (edgePlane.isZero())
+                continue;
+            edgePlane.normalize();
+            double d = -(edgePlane.xn * positions[a].x + edgePlane.yn * positions[a].y + edgePlane.zn * positions[a].z);
+
+            quadrics[a].addPlane(edgePlane.xn, edgePlane.yn, edgePlane.zn, d, BOUNDARY_WEIGHT);
+            quadrics[b].addPlane(edgePlane.xn, edgePlane.yn, edgePlane.zn, d, BOUNDARY_WEIGHT);
+        }
+    }
+
+    // Заполняем очередь кандидатов:
+    priority_queue<Collapse> candidates;
+    for (auto &currentEdge : edgeUses)
+        candidates.push( evaluateCollapse(currentEdge.first.first, currentEdge.first.second) );
+
+    // Стягиваем ребра, пока не достигнем нужного количества треугольников:
+    int activeTriangles = numTriangles;
+    while (activeTriangles > (int)targetFaceCount && !candidates.empty()){
+
+        Collapse current = candidates.top();
+        candidates.pop();
+
+        // Пропускаем устаревших кандидатов:
+        if (removed[current.v1] || removed[current.v2] || stamps[current.v1] != current.stamp1 || stamps[current.v2] != current.stamp2)
+            continue;
+
+        if (flipsTriangles(current.v1, current.v2, current.x, current.y, current.z) || flipsTriangles(current.v2, current.v1, current.x, current.y, current.z))
+            continue;
+
+        // Стягиваем v2 в v1:
+        Vertex& survivor = positions[current.v1];
+        survivor.x = current.x;
+        survivor.y = current.y;
+        survivor.z = current.z;
+
+        survivor.normal.xn += positions[current.v2].normal.xn;
+        survivor.normal.yn += positions[current.v2].normal.yn;
+        survivor.normal.zn += positions[current.v2].normal.zn;
+        if (!survivor.normal.isZero())
+            survivor.normal.normalize();
+
+        quadrics[current.v1].add(quadrics[current.v2]);
+        removed[current.v2] = true;
+        stamps[current.v1]++;
+
+        for (int t : vertexTriangles[current.v2]){
+            if (triangleRemoved[t])
+                continue;
+
+            bool hasSurvivor = false;
+            for (int k = 0; k < 3; k++){
+                if (triangles[3 * t + k] == current.v1)
+                    hasSurvivor = true;
+            }
+
+            if (hasSurvivor){ // Треугольник содержал стянутое ребро: он вырождается
+                triangleRemoved[t] = true;
+                activeTriangles--;
+                continue;
+            }
+
+            for (int k = 0; k < 3; k++){
+                if (triangles[3 * t + k] == current.v2)
+                    triangles[3 * t + k] = current.v1;
+            }
+            vertexTriangles[current.v1].push_back(t);
+        }
+        vertexTriangles[current.v2].clear();
+
+        // Пересчитываем стоимость ребер, смежных с выжившей вершиной:
+        for (int t : vertexTriangles[current.v1]){
+            if (triangleRemoved[t])
+                continue;
+
+            for (int k = 0; k < 3; k++){
+                int neighbour = triangles[3 * t + k];
+                if (neighbour != current.v1)
+                    candidates.push( evaluateCollapse(current.v1, neighbour) );
+            }
+        }
+    }
+
+    // Собираем итоговые грани, копируя материал исходных граней:
+    vector<Polygon> result;
+    result.reserve(activeTriangles);
+    for (int t = 0; t < numTriangles; t++){
+        if (triangleRemoved[t])
+            continue;
+
+        Polygon newFace( faces[ triangleSource[t] ] );
+        newFace.clearVertices();
+
+        for (int k = 0; k < 3; k++)
+            newFace.addVertex( positions[ triangles[3 * t + k] ] );
+
+        newFace.faceNormal = newFace.getFaceNormal();
+        result.emplace_back(newFace);
+    }
+
+    return result;
+}
+
+// Вычислить лучшую позицию и стоимость стягивания ребра
+// Рассматриваются обе конечные точки и середина ребра
+MeshSimplifier::Collapse MeshSimplifier::evaluateCollapse(int v1, int v2){
+    Quadric combined = quadrics[v1];
+    combined.add(quadrics[v2]);
+
+    Collapse result;
+    result.v1 = v1;
+    result.v2 = v2;
+    result.stamp1 = stamps[v1];
+    result.stamp2 = stamps[v2];
+
+    double candidateX[3] = { positions[v1].x, positions[v2].x, (positions[v1].x + positions[v2].x) / 2.0 };
+    double candidateY[3] = { positions[v1].y, positions[v2].y, (positions[v1].y + positions[v2].y) / 2.0 };
+    double candidateZ[3] = { positions[v1].z, positions[v2].z, (positions[v1].z + positions[v2].z) / 2.0 };
+
+    result.cost = std::numeric_limits<double>::max();
+    for (int i = 0; i < 3; i++){
+        double currentCost = combined.error(candidateX[i], candidateY[i], candidateZ[i]);
+        if (currentCost < result.cost){
+            result.cost = currentCost;
+            result.x = candidateX[i];
+            result.y = candidateY[i];
+            result.z = candidateZ[i];
+        }
+    }
+
+    return result;
+}
+
+// Проверить, не перевернет ли перемещение вершины нормали смежных треугольников
+bool MeshSimplifier::flipsTriangles(int vertex, int ignoredVertex, double x, double y, double z){
+    for (int t : vertexTriangles[vertex]){
+        if (triangleRemoved[t])
+            continue;
+
+        int corner = -1;
+        bool hasIgnored = false;
+        for (int k = 0; k < 3; k++){
+            if (triangles[3 * t + k] == vertex)
+                corner = k;
+            if (triangles[3 * t + k] == ignoredVertex)
+                hasIgnored = true;
+        }
+        if (hasIgnored || corner < 0) // Этот треугольник исчезнет при стягивании
+            continue;
+
+        Vertex& a = positions[ triangles[3 * t + (corner + 1) % 3] ];
+        Vertex& b = positions[ triangles[3 * t + (corner + 2) % 3] ];
+        Vertex& old = positions[vertex];
+
+        NormalVector oldNormal = NormalVector(a.x - old.x, a.y - old.y, a.z - old.z).crossProduct( NormalVector(b.x - old.x, b.y - old.y, b.z - old.z) );
+        NormalVector newNormal = NormalVector(a.x - x, a.y - y, a.z - z).crossProduct( NormalVector(b.x - x, b.y - y, b.z - z) );
+
+        if (newNormal.isZero() || oldNormal.dotProduct(newNormal) <= 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include "polygon.h"
+#include <vector>
+
+using std::vector;
+
+// Упрощение сетки: квадратичное стягивание ребер (Garland-Heckbert)
+class MeshSimplifier
+{
+public:
+    // Конструктор
+    MeshSimplifier();
+
+    // Построить упрощенную версию набора треугольных граней
+    // Предварительное условие: все грани - треугольники
+    // Возвращает: вектор <Polygon>, содержащий не более targetFaceCount граней (если сетку удалось упростить)
+    vector<Polygon> simplify(vector<Polygon>& faces, unsigned int targetFaceCount);
+
+private:
+    // Квадрика ошибки: симметричная матрица 4x4, хранится как 10 коэффициентов
+    struct Quadric {
+        double q[10];
+
+        Quadric();
+
+        // Добавить квадрику плоскости ax + by + cz + d = 0
+        void addPlane(double a, double b, double c, double d, double weight);
+
+        // Сложить две квадрики
+        void add(const Quadric& rhs);
+
+        // Ошибка в точке (x, y, z)
+        double error(double x, double y, double z) const;
+    };
+
+    // Кандидат на стягивание ребра
+    struct Collapse {
+        double cost;
+        int v1, v2;                 // Стягиваем v2 в v1
+        int stamp1, stamp2;         // Версии вершин в момент вычисления
+        double x, y, z;             // Новая позиция вершины
+
+        bool operator<(const Collapse& rhs) const { return cost > rhs.cost; } // Мин-куча
+    };
+
+    // Рабочие данные упрощения:
+    vector<Vertex> positions;           // Уникальные вершины (после сварки)
+    vector<Quadric> quadrics;           // Квадрика каждой вершины
+    vector<int> stamps;                 // Версия вершины: увеличивается при каждом изменении
+    vector<bool> removed;               // Вершина удалена стягиванием
+    vector<int> triangles;              // Индексы вершин треугольников (по 3 на треугольник)
+    vector<bool> triangleRemoved;       // Треугольник выродился
+    vector< vector<int> > vertexTriangles;  // Треугольники, использующие вершину
+
+    // Вычислить лучшую позицию и стоимость стягивания ребра
+    Collapse evaluateCollapse(int v1, int v2);
+
+    // Проверить, не перевернет ли перемещение вершины нормали смежных треугольников
+    bool flipsTriangles(int vertex, int ignoredVertex, double x, double y, double z);
+};
+
+#endif // MESHSIMPLIFIER_H
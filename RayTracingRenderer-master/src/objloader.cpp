@@ -0,0 +1,313 @@
+#include "objloader.h"
+#include "renderutilities.h"
+#include "memorystatistics.h"
+#include "tracer.h"
+#include "objtokenizer.h"
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <QFile>
+#include <QByteArray>
+
+using std::cout;
+
+// Конструктор
+ObjLoader::ObjLoader(){
+    maxThreads = 0;
+}
+
+// Ограничить количество потоков разбора
+void ObjLoader::setMaxThreads(unsigned int newMaxThreads){
+    maxThreads = newMaxThreads;
+}
+
+// Прочитать файл obj
+vector<Polygon> ObjLoader::load(const string& filename){
+    vector<Polygon> result;
+
+    QFile file(QString::fromStdString(filename));
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+
+    qint64 size = file.size();
+    if (size <= 0)
+        return result;
+
+    // Файл отображается в память; если отображение недоступно, читаем его целиком
+    QByteArray fallbackContents;
+    const char* data = reinterpret_cast<const char*>( file.map(0, size) );
+    if (data == nullptr){
+        fallbackContents = file.readAll();
+        data = fallbackContents.constData();
+        size = fallbackContents.size();
+    }
+
+    vector<Chunk> chunks = splitIntoChunks(data, (std::size_t)size);
+
+    // Выполнить работу для каждой части: первая часть - в текущем потоке, остальные - в отдельных потоках
+    auto runOnChunks = [&chunks](std::function<void(Chunk&)> work){
+        vector<std::thread> workers;
+        for (std::size_t i = 1; i < chunks.size(); i++){
+            workers.emplace_back([&chunks, &work, i](){
+                MEMORY_SCOPE(loaderMemory);
+                work(chunks[i]);
+            });
+        }
+        work(chunks[0]);
+        for (auto &currentWorker : workers)
+            currentWorker.join();
+    };
+
+    // Первый проход: вершины, нормали и индексы граней каждой части
+    runOnChunks([this](Chunk& theChunk){
+        TRACE_SCOPE("parseObjChunk");
+        parseChunk(theChunk);
+    });
+
+    // Объединяем вершины и нормали в порядке файла. Элемент 0 - заглушка: индексы obj начинаются с 1
+    std::size_t vertexCount = 1, normalCount = 1;
+    for (auto &currentChunk : chunks){
+        currentChunk.vertexBase = vertexCount - 1;
+        currentChunk.normalBase = normalCount - 1;
+        vertexCount += currentChunk.vertices.size();
+        normalCount += currentChunk.normals.size();
+    }
+
+    vector<Vertex> allVertices;
+    allVertices.reserve(vertexCount);
+    allVertices.emplace_back( Vertex() );
+
+    vector<NormalVector> allNormals;
+    allNormals.reserve(normalCount);
+    allNormals.emplace_back( NormalVector() );
+
+    for (auto &currentChunk : chunks){
+        allVertices.insert(allVertices.end(), currentChunk.vertices.begin(), currentChunk.vertices.end());
+        allNormals.insert(allNormals.end(), currentChunk.normals.begin(), currentChunk.normals.end());
+        vector<Vertex>().swap(currentChunk.vertices);
+        vector<NormalVector>().swap(currentChunk.normals);
+    }
+
+    // Второй проход: грани каждой части
+    runOnChunks([this, &allVertices, &allNormals](Chunk& theChunk){
+        TRACE_SCOPE("buildObjChunkFaces");
+        buildChunkFaces(theChunk, allVertices, allNormals);
+    });
+
+    // Ошибки частей выводятся из этого потока, в порядке файла
+    std::size_t faceCount = 0;
+    unsigned int invalidFaces = 0;
+    for (auto &currentChunk : chunks){
+        faceCount += currentChunk.faces.size();
+        invalidFaces += currentChunk.invalidFaces;
+    }
+
+    if (invalidFaces > 0)
+        cout << "Obj file " << filename << ": skipped " << invalidFaces << " faces with invalid indices\n";
+
+    result.reserve(faceCount);
+    for (auto &currentChunk : chunks)
+        result.insert(result.end(), currentChunk.faces.begin(), currentChunk.faces.end());
+
+    if (fallbackContents.isEmpty())
+        file.unmap( reinterpret_cast<uchar*>(const_cast<char*>(data)) );
+    file.close();
+
+    return result;
+}
+
+// Разделить данные на части по границам строк
+vector<ObjLoader::Chunk> ObjLoader::splitIntoChunks(const char* data, std::size_t size){
+    unsigned int threadCount = (maxThreads > 0) ? maxThreads : std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+
+    std::size_t chunkCount = size / MIN_CHUNK_BYTES;
+    if (chunkCount > threadCount)
+        chunkCount = threadCount;
+    if (chunkCount == 0)
+        chunkCount = 1;
+
+    vector<Chunk> chunks(chunkCount);
+
+    const char* end = data + size;
+    const char* chunkBegin = data;
+    for (std::size_t i = 0; i < chunkCount; i++){
+        const char* chunkEnd = end;
+
+        // Граница части сдвигается вперед до начала следующей строки:
+        if (i + 1 < chunkCount){
+            chunkEnd = data + size * (i + 1) / chunkCount;
+            if (chunkEnd < chunkBegin)
+                chunkEnd = chunkBegin;
+
+            const char* lineEnd = static_cast<const char*>( std::memchr(chunkEnd, '\n', end - chunkEnd) );
+            chunkEnd = (lineEnd == nullptr) ? end : lineEnd + 1;
+        }
+
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    return chunks;
+}
+
+// Первый проход: разобрать строки части
+// Строки передаются токенизатору как срезы отображенного файла: ни строки, ни токены не копируются
+void ObjLoader::parseChunk(Chunk& theChunk){
+    const char* position = theChunk.begin;
+
+    while (position < theChunk.end){
+        const char* lineEnd = static_cast<const char*>( std::memchr(position, '\n', theChunk.end - position) );
+        if (lineEnd == nullptr)
+            lineEnd = theChunk.end;
+
+        ObjTokenizer tokens( string_view(position, lineEnd - position) );
+
+        switch (tokens.getRecordType()){
+        case objVertex:
+        {
+            // v x y z [w] [r g b]
+            double values[7];
+            int valueCount = 0;
+            while (valueCount < 7 && tokens.nextNumber(values[valueCount]))
+                valueCount++;
+
+            if (valueCount >= 3){
+                Vertex v1;
+                v1.x = values[0];
+                v1.y = values[1];
+                v1.z = values[2];
+
+                if (valueCount == 4)
+                    v1.setW(values[3]);
+                else if (valueCount == 6)
+                    v1.color = combineColorChannels( values[3], values[4], values[5] );
+                else if (valueCount == 7){
+                    v1.setW(values[3]);
+                    v1.color = combineColorChannels( values[4], values[5], values[6] );
+                }
+
+                v1.z *= -1;
+
+                theChunk.vertices.emplace_back(v1);
+            }
+            break;
+        }
+
+        case objNormal:
+        {
+            NormalVector newNormal;
+            if (tokens.nextNumber(newNormal.xn) && tokens.nextNumber(newNormal.yn) && tokens.nextNumber(newNormal.zn)){
+                newNormal.zn *= -1;
+                theChunk.normals.emplace_back(newNormal);
+            }
+            break;
+        }
+
+        case objFace:
+        {
+            unsigned int cornerCount = 0;
+            int vertexIndex, textureIndex, normalIndex;
+            while (tokens.nextCorner(vertexIndex, textureIndex, normalIndex)){
+                FaceCorner newCorner;
+                newCorner.vertex = makeIndex(vertexIndex, theChunk.vertices.size());
+                if (normalIndex != 0)
+                    newCorner.normal = makeIndex(normalIndex, theChunk.normals.size());
+
+                theChunk.corners.emplace_back(newCorner);
+                cornerCount++;
+            }
+
+            if (cornerCount > 0)
+                theChunk.faceSizes.emplace_back(cornerCount);
+            break;
+        }
+
+        default:    // Текстурные координаты не используются; прочие записи пропускаются
+            break;
+        }
+
+        position = lineEnd + 1;
+    }
+}
+
+// Второй проход: построить грани части
+void ObjLoader::buildChunkFaces(Chunk& theChunk, vector<Vertex>& allVertices, vector<NormalVector>& allNormals){
+    vector<Polygon> triangulatedFaces;
+
+    theChunk.faces.reserve(theChunk.faceSizes.size());
+
+    std::size_t cornerIndex = 0;
+    for (auto faceSize : theChunk.faceSizes){
+
+        Polygon newFace;
+        bool isValid = true;
+
+        for (unsigned int i = 0; i < faceSize && isValid; i++){
+            FaceCorner& theCorner = theChunk.corners[cornerIndex + i];
+
+            Vertex newVertex = allVertices[ resolveIndex(theCorner.vertex, theChunk.vertexBase, allVertices.size(), isValid) ];
+
+            if (theCorner.normal.index != 0 || theCorner.normal.isRelative)
+                newVertex.normal = allNormals[ resolveIndex(theCorner.normal, theChunk.normalBase, allNormals.size(), isValid) ];
+
+            newFace.addVertex(newVertex);
+        }
+        cornerIndex += faceSize;
+
+        if (!isValid){
+            theChunk.invalidFaces++;
+            continue;
+        }
+
+        NormalVector faceNormal = newFace.getFaceNormal();
+        for (int i = 0; i < newFace.getVertexCount(); i++){
+            if (newFace.vertices[i].normal.isZero() ) {
+                newFace.vertices[i].normal = faceNormal; // Set 0,0,0 normals to be the face normal
+            }
+        }
+
+        if (newFace.getVertexCount() > 3){
+            newFace.getTriangulatedFaces(triangulatedFaces);
+            theChunk.faces.insert(theChunk.faces.end(), triangulatedFaces.begin(), triangulatedFaces.end());
+        } else
+            theChunk.faces.emplace_back(newFace);
+    }
+
+    // Индексы больше не нужны:
+    vector<FaceCorner>().swap(theChunk.corners);
+    vector<unsigned int>().swap(theChunk.faceSizes);
+}
+
+// Пересчитать индекс obj
+ObjLoader::ObjIndex ObjLoader::makeIndex(int fileIndex, std::size_t countBeforeLine){
+    ObjIndex result;
+
+    // Индексы obj начинаются с 1: индекс 0 остается 0, и resolveIndex отбрасывает грань как ошибочную
+    if (fileIndex >= 0){
+        result.index = fileIndex;
+        return result;
+    }
+
+    // -1 - последний элемент, прочитанный до текущей строки. Результат <= 0 указывает на предыдущие части
+    result.index = (int)countBeforeLine + fileIndex + 1;
+    result.isRelative = true;
+    return result;
+}
+
+// Получить номер элемента общего массива
+std::size_t ObjLoader::resolveIndex(const ObjIndex& theIndex, std::size_t base, std::size_t arraySize, bool& isValid){
+    long long index = theIndex.index;
+    if (theIndex.isRelative)
+        index += (long long)base;
+
+    if (index < 1 || index >= (long long)arraySize){
+        isValid = false;
+        return 0;
+    }
+    return (std::size_t)index;
+}
@@ -0,0 +1,83 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <string>
+#include <vector>
+#include "polygon.h"
+#include "vertex.h"
+#include "normalvector.h"
+
+using std::string;
+using std::vector;
+
+// Загрузчик файлов obj для больших сеток
+// Файл отображается в память и делится на части, выровненные по границам строк; части разбираются параллельно в два прохода:
+// 1) каждая часть читает свои вершины, нормали и индексы граней. Отрицательные индексы obj отсчитываются от последней
+//    вершины, прочитанной до текущей строки, поэтому они запоминаются относительно начала части;
+// 2) после того как известны количества вершин и нормалей всех предыдущих частей, каждая часть строит свои грани.
+// Грани возвращаются в порядке файла: результат совпадает с последовательным чтением
+class ObjLoader
+{
+public:
+    // Конструктор
+    ObjLoader();
+
+    // Прочитать файл obj
+    // Возвращает: все грани файла (многоугольники триангулированы); пустой вектор, если файл не удалось открыть
+    vector<Polygon> load(const string& filename);
+
+    // Ограничить количество потоков разбора. 0 = по количеству ядер
+    void setMaxThreads(unsigned int newMaxThreads);
+
+    static const std::size_t MIN_CHUNK_BYTES = 1 << 18;    // Меньшие части не окупают запуск потока
+
+private:
+    // Ссылка угла грани на вершину или нормаль
+    struct ObjIndex {
+        int index = 0;              // Индекс в файле (с 1) или, если isRelative, номер в части (с 1)
+        bool isRelative = false;    // Отрицательный индекс, пересчитанный относительно начала части
+    };
+
+    // Угол грани
+    struct FaceCorner {
+        ObjIndex vertex;
+        ObjIndex normal;            // index == 0: нормаль не задана
+    };
+
+    // Результат разбора одной части файла
+    struct Chunk {
+        const char* begin;
+        const char* end;
+
+        vector<Vertex> vertices;
+        vector<NormalVector> normals;
+        vector<FaceCorner> corners;             // Углы всех граней подряд
+        vector<unsigned int> faceSizes;         // Количество углов каждой грани
+
+        std::size_t vertexBase = 0;             // Вершины всех предыдущих частей
+        std::size_t normalBase = 0;
+
+        vector<Polygon> faces;
+        unsigned int invalidFaces = 0;          // Грани с индексами вне массивов: выводятся вызывающим потоком
+    };
+
+    unsigned int maxThreads;
+
+    // Разделить данные на части по границам строк
+    vector<Chunk> splitIntoChunks(const char* data, std::size_t size);
+
+    // Первый проход: разобрать строки части
+    void parseChunk(Chunk& theChunk);
+
+    // Второй проход: построить грани части по общим массивам вершин и нормалей
+    void buildChunkFaces(Chunk& theChunk, vector<Vertex>& allVertices, vector<NormalVector>& allNormals);
+
+    // Пересчитать индекс obj: положительный остается глобальным, отрицательный - относительно начала части
+    ObjIndex makeIndex(int fileIndex, std::size_t countBeforeLine);
+
+    // Получить номер элемента общего массива по индексу
+    // Возвращает: номер элемента; если индекс вне массива - 0 и isValid = false
+    static std::size_t resolveIndex(const ObjIndex& theIndex, std::size_t base, std::size_t arraySize, bool& isValid);
+};
+
+#endif // OBJLOADER_H
@@ -0,0 +1,102 @@
+#include "objtokenizer.h"
+
+#include <charconv>
+
+// Конструктор: определяет тип записи и встает на первый аргумент
+ObjTokenizer::ObjTokenizer(string_view line){
+    remaining = line;
+    skipSpaces();
+
+    // Команда - первое слово строки:
+    std::size_t commandLength = 0;
+    while (commandLength < remaining.size() && remaining[commandLength] != ' ' && remaining[commandLength] != '\t' && remaining[commandLength] != '\r')
+        commandLength++;
+
+    string_view command = remaining.substr(0, commandLength);
+    remaining.remove_prefix(commandLength);
+
+    if (command == "v")
+        recordType = objVertex;
+    else if (command == "vn")
+        recordType = objNormal;
+    else if (command == "vt")
+        recordType = objTexture;
+    else if (command == "f")
+        recordType = objFace;
+    else
+        recordType = objOther;
+}
+
+// Тип записи строки
+ObjRecordType ObjTokenizer::getRecordType(){
+    return recordType;
+}
+
+// Прочитать следующее число записи
+bool ObjTokenizer::nextNumber(double& result){
+    skipSpaces();
+
+    // from_chars не принимает знак '+':
+    if (!remaining.empty() && remaining[0] == '+')
+        remaining.remove_prefix(1);
+
+    std::from_chars_result parsed = std::from_chars(remaining.data(), remaining.data() + remaining.size(), result);
+    if (parsed.ec != std::errc())
+        return false;
+
+    remaining.remove_prefix(parsed.ptr - remaining.data());
+    return true;
+}
+
+// Прочитать следующий угол грани
+bool ObjTokenizer::nextCorner(int& vertexIndex, int& textureIndex, int& normalIndex){
+    skipSpaces();
+
+    vertexIndex = 0;
+    textureIndex = 0;
+    normalIndex = 0;
+
+    if (!parseInt(vertexIndex))
+        return false;
+
+    if (remaining.empty() || remaining[0] != '/')
+        return true;
+    remaining.remove_prefix(1);
+
+    // v//n:
+    if (!remaining.empty() && remaining[0] == '/'){
+        remaining.remove_prefix(1);
+        return parseInt(normalIndex);
+    }
+
+    // v/t или v/t/n:
+    parseInt(textureIndex);
+
+    if (remaining.empty() || remaining[0] != '/')
+        return true;
+    remaining.remove_prefix(1);
+
+    return parseInt(normalIndex);
+}
+
+// Пропустить пробелы, табуляцию и возврат каретки
+void ObjTokenizer::skipSpaces(){
+    std::size_t count = 0;
+    while (count < remaining.size() && (remaining[count] == ' ' || remaining[count] == '\t' || remaining[count] == '\r'))
+        count++;
+    remaining.remove_prefix(count);
+}
+
+// Прочитать целое число в начале remaining
+bool ObjTokenizer::parseInt(int& result){
+    const char* start = remaining.data();
+    if (!remaining.empty() && remaining[0] == '+')
+        start++;
+
+    std::from_chars_result parsed = std::from_chars(start, remaining.data() + remaining.size(), result);
+    if (parsed.ec != std::errc())
+        return false;
+
+    remaining.remove_prefix(parsed.ptr - remaining.data());
+    return true;
+}
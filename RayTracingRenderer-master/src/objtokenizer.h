@@ -0,0 +1,47 @@
+#ifndef OBJTOKENIZER_H
+#define OBJTOKENIZER_H
+
+#include <string_view>
+
+using std::string_view;
+
+// Тип записи строки obj
+enum ObjRecordType {
+    objVertex,      // v x y z [w] [r g b]
+    objNormal,      // vn x y z
+    objTexture,     // vt u [v] [w]
+    objFace,        // f v1 v2 v3 ...
+    objOther        // Комментарии, пустые строки и неиспользуемые команды (g, o, s, usemtl, ...)
+};
+
+// Разбор одной строки obj без копирования: токены - срезы string_view исходного буфера,
+// числа читаются std::from_chars (не зависит от локали и не бросает исключений). Память не выделяется
+class ObjTokenizer
+{
+public:
+    // Конструктор: определяет тип записи и встает на первый аргумент
+    ObjTokenizer(string_view line);
+
+    // Тип записи строки
+    ObjRecordType getRecordType();
+
+    // Прочитать следующее число записи
+    // Возвращает: false, если аргументы закончились или следующий токен не является числом
+    bool nextNumber(double& result);
+
+    // Прочитать следующий угол грани вида v, v/t, v/t/n или v//n. Отсутствующие индексы возвращаются как 0
+    // Возвращает: false, если углы закончились или угол записан неверно
+    bool nextCorner(int& vertexIndex, int& textureIndex, int& normalIndex);
+
+private:
+    string_view remaining;      // Непрочитанная часть строки
+    ObjRecordType recordType;
+
+    // Пропустить пробелы, табуляцию и возврат каретки
+    void skipSpaces();
+
+    // Прочитать целое число в начале remaining
+    bool parseInt(int& result);
+};
+
+#endif // OBJTOKENIZER_H
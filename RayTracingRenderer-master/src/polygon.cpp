@@ -3,6 +3,7 @@
 #include "renderutilities.h"
 #include <vector>
 #include "normalvector.h"
+#include "framearena.h"
 #include <cmath>
 
 using std::vector;
@@ -12,7 +13,7 @@ using std::cout;
 Polygon::Polygon(){ //
     vertexArraySize = 3; // Выделяем 3 вершины (для треугольника)
 
-    vertices = new Vertex[vertexArraySize];
+    reallocateVertices(vertexArraySize, false);
     currentVertices = 0;
 
     isAmbientLit = false;
@@ -25,7 +26,7 @@ Polygon::Polygon(){ //
 Polygon::Polygon(Vertex p0, Vertex p1, Vertex p2){
     vertexArraySize = 3; // Выделяем 3 вершины (для треугольника)
 
-    vertices = new Vertex[vertexArraySize];
+    reallocateVertices(vertexArraySize, false);
     vertices[0] = Vertex{p0.x, p0.y, p0.z, p0.color};
     vertices[1] = Vertex{p1.x, p1.y, p1.z, p1.color};
     vertices[2] = Vertex{p2.x, p2.y, p2.z, p2.color};
@@ -55,7 +56,7 @@ Polygon::Polygon(const Polygon& currentPoly){
     this->specularExponent = currentPoly.specularExponent;
     this->reflectivity = currentPoly.reflectivity;
 
-    this->vertices = new Vertex[vertexArraySize];
+    reallocateVertices(vertexArraySize, false);
     for (unsigned int i = 0; i < vertexArraySize; i++){
         this->vertices[i] = currentPoly.vertices[i];
     }
@@ -78,10 +79,7 @@ Polygon& Polygon::operator=(const Polygon& rhs){
     this->specularExponent = rhs.specularExponent;
     this->reflectivity = rhs.reflectivity;
 
-    if (vertices != nullptr)
-        delete[] vertices;
-
-    this->vertices = new Vertex[vertexArraySize];
+    reallocateVertices(vertexArraySize, false);
     for (unsigned int i = 0; i < currentVertices; i++)
         this->vertices[i] = rhs.vertices[i];
 
@@ -91,10 +89,7 @@ Polygon& Polygon::operator=(const Polygon& rhs){
 }
 
 Polygon::~Polygon(){
-    if (vertices == nullptr)
-        return;
-
-    delete[] vertices;
+    releaseVertices();
 }
 
 // Удалить все вершины из массива вершин этого многоугольника
@@ -102,11 +97,9 @@ void Polygon::clearVertices(){
     if (vertices == nullptr)
         return;
 
-    delete[] vertices;
-
     vertexArraySize = 3;
 
-    vertices = new Vertex[vertexArraySize];
+    reallocateVertices(vertexArraySize, false);
     currentVertices = 0;
 }
 
@@ -124,19 +117,13 @@ void Polygon::addVertex(Vertex newPoint){
         return;
     }
     else{
-        Vertex* newVertices = new Vertex[vertexArraySize + 1];
-        for (unsigned int i = 0; i < vertexArraySize; i++){
-            newVertices[i] = vertices[i];
-        }
-        delete [] vertices;
+        reallocateVertices(vertexArraySize + 1, true);
 
         newPoint.vertexNumber = vertexArraySize;
-        newVertices[vertexArraySize] = Vertex(newPoint);
+        vertices[vertexArraySize] = Vertex(newPoint);
 
         vertexArraySize++;
         currentVertices++;
-
-        vertices = newVertices;
     }
 
     return;
@@ -403,7 +390,7 @@ void Polygon::transform(TransformationMatrix* theMatrix, bool doRound){
 }
 
 // Получить количество вершин, содержащихся в этом многоугольнике
-int Polygon::getVertexCount(){
+int Polygon::getVertexCount() const {
     return currentVertices;
 }
 
@@ -413,9 +400,19 @@ int Polygon::getVertexCount(){
 vector<Polygon>* Polygon::getTriangulatedFaces(){
     vector<Polygon>* result = new vector<Polygon>();
 
+    getTriangulatedFaces(*result);
+
+    return result;
+}
+
+// Триангуляция этого многоугольника в существующий вектор
+// Вектор очищается, но его память переиспользуется: используется при отрисовке, где вектор живет между кадрами
+void Polygon::getTriangulatedFaces(vector<Polygon>& result){
+    result.clear();
+
     if (currentVertices < 4){
-        result->emplace_back( *this );
-        return result;
+        result.emplace_back( *this );
+        return;
     }
 
     Vertex v1 = vertices[0];
@@ -432,10 +429,8 @@ vector<Polygon>* Polygon::getTriangulatedFaces(){
         newFace.addVertex(vertices[ index + 1 ]);
         index++;
 
-        result->emplace_back(newFace);
+        result.emplace_back(newFace);
     }
-
-    return result;
 }
 
 // Проверяем, влияет ли окружающий свет на этот полигон
@@ -552,3 +547,37 @@ void Polygon::debug(){
     cout << "End Polygon.\n\n";
 }
 
+// Заменить массив вершин массивом нового размера
+// Пока в потоке активна арена кадра, массив берется из нее и не освобождается поштучно
+void Polygon::reallocateVertices(unsigned int newSize, bool keepVertices){
+    Vertex* newVertices;
+    bool newIsArenaStorage;
+
+    FrameArena* arena = FrameArena::getCurrent();
+    if (arena != nullptr){
+        newVertices = arena->allocateArray<Vertex>(newSize);
+        newIsArenaStorage = true;
+    }
+    else {
+        newVertices = new Vertex[newSize];
+        newIsArenaStorage = false;
+    }
+
+    if (keepVertices && vertices != nullptr){
+        for (unsigned int i = 0; i < vertexArraySize && i < newSize; i++)
+            newVertices[i] = vertices[i];
+    }
+
+    releaseVertices();
+
+    vertices = newVertices;
+    isArenaStorage = newIsArenaStorage;
+}
+
+// Освободить массив вершин (массивы из арены кадра освобождаются вместе с ареной)
+void Polygon::releaseVertices(){
+    if (vertices != nullptr && !isArenaStorage)
+        delete[] vertices;
+
+    vertices = nullptr;
+}
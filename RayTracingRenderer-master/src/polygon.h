@@ -88,6 +88,9 @@ public:
     // Возвращает: сетка, содержащая только треугольные грани. Каждый треугольник будет содержать первую вершину
     vector<Polygon>* getTriangulatedFaces();
 
+    // Триангуляция этого многоугольника в существующий вектор (вектор очищается, его память переиспользуется)
+    void getTriangulatedFaces(vector<Polygon>& result);
+
     // Проверяем поворот вершины: определяем, смотрим ли мы на переднюю или заднюю часть многоугольника
     bool isFacingCamera();
 
@@ -98,7 +101,7 @@ public:
     void transform(TransformationMatrix* theMatrix, bool doRound);
 
     // Получить количество вершин, содержащихся в этом многоугольнике
-    int getVertexCount();
+    int getVertexCount() const;
 
     // Проверяем, влияет ли окружающий свет на этот полигон
     bool isAffectedByAmbientLight();
@@ -153,6 +156,7 @@ public:
 private:
     unsigned int vertexArraySize; // Размер массива вершин в этом многоугольнике
     unsigned int currentVertices; // Количество вершин, добавленных к этому многоугольнику
+    bool isArenaStorage = false;  // Массив вершин выделен из арены кадра (FrameArena) и не освобождается деструктором
 
     bool isAmbientLit; // Окружающее освещение
 
@@ -168,6 +172,12 @@ private:
     // Рассчитать векторное пересечение с плоскостью. Используется для обрезки полигонов.
     Vertex intersection(Vertex C, Vertex D, Vertex P, NormalVector n, bool doPerspectiveCorrect);
 
+    // Заменить массив вершин массивом нового размера (из арены кадра, если она активна)
+    void reallocateVertices(unsigned int newSize, bool keepVertices);
+
+    // Освободить массив вершин
+    void releaseVertices();
+
     // Вспомогательная функция: обрезает полигоны, используя алгоритм отсечения Сазерленда-Ходжмана
     Polygon clipHelper(Polygon source, Vertex P, NormalVector n, bool doPerspectiveCorrect);
 };
@@ -6,7 +6,13 @@
 
 QT       += core gui
 
-CONFIG+=c++11
+CONFIG+=c++17
+
+# qmake CONFIG+=memory_stats: count live/peak bytes and allocations per subsystem (see memorystatistics.h)
+memory_stats: DEFINES += RENDER_MEMORY_STATS
+
+# qmake CONFIG+=trace: record scoped events and write them as Chrome trace JSON (see tracer.h)
+trace: DEFINES += RENDER_TRACE
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -28,7 +34,32 @@ SOURCES += main.cpp\
     renderutilities.cpp \
     normalvector.cpp \
     light.cpp \
-    scene.cpp
+    scene.cpp \
+    meshsimplifier.cpp \
+    renderstatistics.cpp \
+    raystatistics.cpp \
+    geometrybatch.cpp \
+    halfspacerasterizer.cpp \
+    specularevaluator.cpp \
+    vertexlightingcache.cpp \
+    framearena.cpp \
+    memorystatistics.cpp \
+    tracer.cpp \
+    simpreader.cpp \
+    objloader.cpp \
+    objtokenizer.cpp \
+    assetcache.cpp \
+    imagedrawable.cpp \
+    sequencerenderer.cpp \
+    dirtyregiontracker.cpp \
+    staticlightingcache.cpp \
+    shadowcastertable.cpp \
+    boundingbox.cpp \
+    meshbvh.cpp \
+    scenebvh.cpp \
+    bvhbenchmark.cpp \
+    adaptivesampler.cpp \
+    resolutionscaler.cpp
 
 HEADERS  += \
     drawable.h \
@@ -46,5 +77,30 @@ HEADERS  += \
     renderutilities.h \
     normalvector.h \
     light.h \
-    scene.h
+    scene.h \
+    meshsimplifier.h \
+    renderstatistics.h \
+    raystatistics.h \
+    geometrybatch.h \
+    halfspacerasterizer.h \
+    specularevaluator.h \
+    vertexlightingcache.h \
+    framearena.h \
+    memorystatistics.h \
+    tracer.h \
+    simpreader.h \
+    objloader.h \
+    objtokenizer.h \
+    assetcache.h \
+    imagedrawable.h \
+    sequencerenderer.h \
+    dirtyregiontracker.h \
+    staticlightingcache.h \
+    shadowcastertable.h \
+    boundingbox.h \
+    meshbvh.h \
+    scenebvh.h \
+    bvhbenchmark.h \
+    adaptivesampler.h \
+    resolutionscaler.h
 
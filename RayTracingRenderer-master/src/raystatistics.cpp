@@ -0,0 +1,81 @@
+#include "raystatistics.h"
+#include <algorithm>
+#include <iostream>
+
+using std::cout;
+
+// Конструктор
+RayStatistics::RayStatistics(){
+    reset();
+}
+
+// Обнулить счетчики
+void RayStatistics::reset(){
+    shadingPoints = 0;
+    boxTests = 0;
+    faceTests = 0;
+
+    std::fill(shadowRays.begin(), shadowRays.end(), 0);
+    std::fill(shadowRaysBlocked.begin(), shadowRaysBlocked.end(), 0);
+    std::fill(reflectionRays.begin(), reflectionRays.end(), 0);
+    std::fill(reflectionHits.begin(), reflectionHits.end(), 0);
+}
+
+// Прибавить счетчики другого потока или кадра
+void RayStatistics::merge(const RayStatistics& other){
+    shadingPoints += other.shadingPoints;
+    boxTests += other.boxTests;
+    faceTests += other.faceTests;
+
+    if (shadowRays.size() < other.shadowRays.size()){
+        shadowRays.resize(other.shadowRays.size(), 0);
+        shadowRaysBlocked.resize(other.shadowRays.size(), 0);
+    }
+    for (unsigned int i = 0; i < other.shadowRays.size(); i++){
+        shadowRays[i] += other.shadowRays[i];
+        shadowRaysBlocked[i] += other.shadowRaysBlocked[i];
+    }
+
+    if (reflectionRays.size() < other.reflectionRays.size()){
+        reflectionRays.resize(other.reflectionRays.size(), 0);
+        reflectionHits.resize(other.reflectionRays.size(), 0);
+    }
+    for (unsigned int i = 0; i < other.reflectionRays.size(); i++){
+        reflectionRays[i] += other.reflectionRays[i];
+        reflectionHits[i] += other.reflectionHits[i];
+    }
+}
+
+// Вывести счетчики
+void RayStatistics::debug(){
+    unsigned long long totalShadowRays = 0, totalReflectionRays = 0, totalReflectionHits = 0;
+    for (auto count : shadowRays)
+        totalShadowRays += count;
+    for (unsigned int i = 0; i < reflectionRays.size(); i++){
+        totalReflectionRays += reflectionRays[i];
+        totalReflectionHits += reflectionHits[i];
+    }
+
+    if (shadingPoints + totalShadowRays + totalReflectionRays == 0)
+        return;
+
+    // Каждое попадание отраженного луча освещается так же, как видимая точка
+    cout << "Shading points:\t" << shadingPoints - totalReflectionHits << "\treflection hits: " << totalReflectionHits << "\n";
+
+    for (unsigned int i = 0; i < shadowRays.size(); i++){
+        if (shadowRays[i] > 0)
+            cout << "Shadow rays, light " << i << ":\t" << shadowRays[i] << "\tblocked: " << shadowRaysBlocked[i] << " (" << (100.0 * shadowRaysBlocked[i] / shadowRays[i]) << "%)\n";
+    }
+
+    for (unsigned int i = 0; i < reflectionRays.size(); i++){
+        if (reflectionRays[i] > 0)
+            cout << "Reflection rays, depth " << i << ":\t" << reflectionRays[i] << "\thit: " << reflectionHits[i] << " (" << (100.0 * reflectionHits[i] / reflectionRays[i]) << "%)"
+                 << "\tenvironment: " << reflectionRays[i] - reflectionHits[i] << "\n";
+    }
+
+    unsigned long long totalRays = totalShadowRays + totalReflectionRays;
+    cout << "Ray box tests:\t" << boxTests << "\tface tests: " << faceTests;
+    if (totalRays > 0)
+        cout << "\tper ray: " << (double)boxTests / totalRays << " / " << (double)faceTests / totalRays;
+    cout << "\n";
+}
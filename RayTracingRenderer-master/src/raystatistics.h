@@ -0,0 +1,57 @@
+#ifndef RAYSTATISTICS_H
+#define RAYSTATISTICS_H
+
+#include <vector>
+
+using std::vector;
+
+// Счетчики трассировки лучей одного кадра
+// У каждого Renderer (потока отрисовки) свои счетчики; итог нескольких потоков собирается функцией merge
+class RayStatistics
+{
+public:
+    // Конструктор
+    RayStatistics();
+
+    // Обнулить счетчики (размеры таблиц по источникам и глубинам сохраняются)
+    void reset();
+
+    // Прибавить счетчики другого потока или кадра
+    void merge(const RayStatistics& other);
+
+    // Вывести счетчики
+    void debug();
+
+    // Теневой луч к источнику lightIndex
+    void addShadowRay(unsigned int lightIndex, bool isBlocked){
+        if (lightIndex >= shadowRays.size()){
+            shadowRays.resize(lightIndex + 1, 0);
+            shadowRaysBlocked.resize(lightIndex + 1, 0);
+        }
+        shadowRays[lightIndex]++;
+        if (isBlocked)
+            shadowRaysBlocked[lightIndex]++;
+    }
+
+    // Отраженный луч глубины depth (1 - отражение видимой точки)
+    void addReflectionRay(unsigned int depth, bool isHit){
+        if (depth >= reflectionRays.size()){
+            reflectionRays.resize(depth + 1, 0);
+            reflectionHits.resize(depth + 1, 0);
+        }
+        reflectionRays[depth]++;
+        if (isHit)
+            reflectionHits[depth]++;
+    }
+
+    unsigned long long shadingPoints;   // Освещенные точки, включая точки попадания отраженных лучей
+    unsigned long long boxTests;        // Проверки прямоугольников: узлы иерархий и прямоугольники сеток из списков теневых сеток
+    unsigned long long faceTests;       // Проверки граней
+
+    vector<unsigned long long> shadowRays;          // По номеру источника
+    vector<unsigned long long> shadowRaysBlocked;   // Лучи, встретившие грань до источника
+    vector<unsigned long long> reflectionRays;      // По глубине отражения
+    vector<unsigned long long> reflectionHits;      // Лучи, попавшие в грань; остальные возвращают environmentColor
+};
+
+#endif // RAYSTATISTICS_H
@@ -8,8 +8,8 @@
 
 #include<QDebug>
 
-RenderArea361::RenderArea361(QWidget *parent) : QWidget(parent), Drawable(){
-    image = QImage(1000, 1000, QImage::Format_RGB888);
+RenderArea361::RenderArea361(int xRes, int yRes, QWidget *parent) : QWidget(parent), Drawable(){
+    image = QImage(xRes, yRes, QImage::Format_RGB888);
     image.fill(0x00ff0000);
     this->setSizePolicy(QSizePolicy());
     this->update();
@@ -29,7 +29,7 @@ void RenderArea361::updateScreen(){
 
 QSize RenderArea361::sizeHint() const
 {
-    return QSize(1000, 1000);
+    return image.size();
 }
 
 void RenderArea361::paintEvent(QPaintEvent *event){
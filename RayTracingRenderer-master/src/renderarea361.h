@@ -9,7 +9,7 @@ class RenderArea361 : public QWidget, public Drawable
 {
     Q_OBJECT
 public:
-    explicit RenderArea361(QWidget *parent = 0);
+    RenderArea361(int xRes, int yRes, QWidget *parent = 0);
     QSize sizeHint() const;
     void setPixel(int x, int y, uint color);
     uint getPixel(int x, int y);
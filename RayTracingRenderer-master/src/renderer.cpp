@@ -1,8 +1,10 @@
 #include "renderer.h"
 #include "renderutilities.h"
 
+#define _USE_MATH_DEFINES       // Allow use of M_PI (3.14159265358979323846)
 #include <cmath>
 #include <iostream>
+#include <algorithm>
 #include "math.h"
 
 #include <QDebug>
@@ -13,19 +15,31 @@ using std::cout;
 // Конструктор
 Renderer::Renderer(Drawable* newDrawable, int newXRes, int newYRes, int borderWidth){
     this->drawable = newDrawable;
+    outputDrawable = newDrawable;
 
     border = borderWidth;
     xRes = newXRes;
     yRes = newYRes;
-
-    ZBuffer = new int*[yRes];
-    for (int row = 0; row < yRes; row++){
-        ZBuffer[row] = new int[xRes];
-        for (int col = 0; col < xRes; col++){
+    outputXRes = newXRes;
+    outputYRes = newYRes;
+
+    MEMORY_SCOPE(rasterMemory);
+    ZBuffer = new int*[outputYRes];
+    for (int row = 0; row < outputYRes; row++){
+        ZBuffer[row] = new int[outputXRes];
+        for (int col = 0; col < outputXRes; col++){
             ZBuffer[row][col] = maxZVal;
         }
     }
 
+    resolutionScaler.setOutputResolution(outputXRes, outputYRes);
+
+    // До первого кадра область перерисовки - весь экран (строки рендерера 1..yRes):
+    scissor.xMin = 0;
+    scissor.yMin = 1;
+    scissor.xMax = xRes - 1;
+    scissor.yMax = yRes;
+
     // Create a perspective transformation matrix:
     cameraToPerspective.arrayVal(3, 3) = 0; // Removes w component
     cameraToPerspective.arrayVal(3, 2) = 1; // Replaces w component with a copy of the z component
@@ -33,12 +47,10 @@ Renderer::Renderer(Drawable* newDrawable, int newXRes, int newYRes, int borderWi
 
 // Деструктор
 Renderer::~Renderer(){
-    for (int x = 0; x < xRes; x++){
-        for (int y = 0; y < yRes; y++){
-            delete ZBuffer[x];
-        }
+    for (int row = 0; row < outputYRes; row++){
+        delete [] ZBuffer[row];
     }
-    delete ZBuffer;
+    delete [] ZBuffer;
 }
 
 // Рисуем прямоугольник. Используется только для настройки цветов фона панели. Игнорирует z-буфер.
@@ -104,7 +116,7 @@ void Renderer::drawLine(Line theLine, ShadingModel theShadingModel, bool doAmbie
                     viewVector.normalize();
 
                    // Вычисляем значение освещенного пикселя, применяем расстояние, затем пытаемся установить его:
-                    currentPosition.color = lightPointInCameraSpace(&currentPosition, &viewVector, doAmbient, specularExponent, specularCoefficient);
+                    currentPosition.color = lightPointInCameraSpace(&currentPosition, &viewVector, doAmbient, specularExponent, specularCoefficient, nullptr);
 
                     if (currentScene->isDepthFogged)
                         setPixel((int)theLine.p1.x, y, correctZ, getDistanceFoggedColor( currentPosition.color, correctZ ) );
@@ -198,7 +210,7 @@ void Renderer::drawLine(Line theLine, ShadingModel theShadingModel, bool doAmbie
                         NormalVector viewVector(-currentPosition.x, -currentPosition.y, -currentPosition.z);
                         viewVector.normalize();
 
-                        currentPosition.color = lightPointInCameraSpace(&currentPosition, &viewVector, doAmbient, specularExponent, specularCoefficient);
+                        currentPosition.color = lightPointInCameraSpace(&currentPosition, &viewVector, doAmbient, specularExponent, specularCoefficient, nullptr);
 
                         if (currentScene->isDepthFogged) // Вычисляем значение освещенного пикселя, применяем расстояние, затем пытаемся установить его:
                             setPixel(round_x, y, correctZ, getDistanceFoggedColor( currentPosition.color, correctZ ) );
@@ -258,7 +270,7 @@ void Renderer::drawLine(Line theLine, ShadingModel theShadingModel, bool doAmbie
                         viewVector.normalize();
 
                         // Вычисляем значение освещенного пикселя, применяем расстояние, затем пытаемся установить его:
-                        currentPosition.color = lightPointInCameraSpace(&currentPosition, &viewVector, doAmbient, specularExponent, specularCoefficient);
+                        currentPosition.color = lightPointInCameraSpace(&currentPosition, &viewVector, doAmbient, specularExponent, specularCoefficient, nullptr);
 
                         if (currentScene->isDepthFogged)
                             setPixel(x, round_y, correctZ, getDistanceFoggedColor( currentPosition.color, correctZ ) );
@@ -287,6 +299,7 @@ void Renderer::drawLine(Line theLine, ShadingModel theShadingModel, bool doAmbie
 // Если вершины Полигона не одного цвета, цвет будет LERP'd
 // Предварительное условие: все полигоны находятся в пространстве камеры
 void Renderer::drawPolygon(Polygon thePolygon, bool isWireframe){
+    TRACE_SCOPE("drawPolygon");
 
     if (!thePolygon.isInDepth(currentScene->camHither, currentScene->camYon)){
         return;
@@ -294,19 +307,10 @@ void Renderer::drawPolygon(Polygon thePolygon, bool isWireframe){
 
     thePolygon.clipHitherYon(currentScene->camHither, currentScene->camYon);
 
-    if(!thePolygon.isValid())
+    if(!thePolygon.isValid() || isOutsideScissor(&thePolygon))
         return;
 
-    if (thePolygon.isLine() && thePolygon.isAffectedByAmbientLight() ){
-        thePolygon.lightAmbiently( currentScene->ambientRedIntensity, currentScene->ambientGreenIntensity, currentScene->ambientBlueIntensity);
-    }
-
-    else if (thePolygon.getShadingModel() == flat && !isWireframe && !thePolygon.isLine() ){ // Only light the polygon if it's not wireframe or a line
-        flatShadePolygon( &thePolygon );
-    }
-    else if (thePolygon.getShadingModel() == gouraud && !isWireframe && !thePolygon.isLine()){ // Only light the polygon if it's not wireframe or a line
-        gouraudShadePolygon( &thePolygon );
-    }
+    shadePolygon( &thePolygon, isWireframe );
 
     thePolygon.transform( &cameraToPerspective );
 
@@ -318,38 +322,92 @@ void Renderer::drawPolygon(Polygon thePolygon, bool isWireframe){
         return;
     }
 
-    thePolygon.clipToScreen(currentScene->xLow, currentScene->xHigh, currentScene->yLow, currentScene->yHigh);
+    drawProjectedPolygon( &thePolygon, isWireframe );
+}
+
+// Осветить многоугольник в соответствии с его моделью затенения
+// Предварительное условие: многоугольник находится в пространстве камеры и уже обрезан по hither / yon
+void Renderer::shadePolygon(Polygon* thePolygon, bool isWireframe){
+    TRACE_SCOPE("shadePolygon");
+
+    gatherPolygonLights( thePolygon );
+    TRACE_SET_ARG("lights", polygonLights.size());
+
+    if (thePolygon->isLine() && thePolygon->isAffectedByAmbientLight() ){
+        thePolygon->lightAmbiently( currentScene->ambientRedIntensity, currentScene->ambientGreenIntensity, currentScene->ambientBlueIntensity);
+    }
+
+    else if (thePolygon->getShadingModel() == flat && !isWireframe && !thePolygon->isLine() ){ // Only light the polygon if it's not wireframe or a line
+        frameStatistics.facesShaded++;
+        flatShadePolygon( thePolygon );
+    }
+    else if (thePolygon->getShadingModel() == gouraud && !isWireframe && !thePolygon->isLine()){ // Only light the polygon if it's not wireframe or a line
+        frameStatistics.facesShaded++;
+        gouraudShadePolygon( thePolygon );
+    }
+}
+
+// Собрать источники света, радиус влияния которых достигает ограничивающей сферы многоугольника
+void Renderer::gatherPolygonLights(Polygon* thePolygon){
+    polygonLights.clear();
+
+    Vertex center = thePolygon->getFaceCenter();
 
-    if(!thePolygon.isValid())
+    double radiusSquared = 0;
+    for (int i = 0; i < thePolygon->getVertexCount(); i++){
+        double dx = thePolygon->vertices[i].x - center.x;
+        double dy = thePolygon->vertices[i].y - center.y;
+        double dz = thePolygon->vertices[i].z - center.z;
+        radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+    }
+    double radius = sqrt(radiusSquared);
+
+    for (unsigned int i = 0; i < currentScene->theLights.size(); i++){
+        if (currentScene->theLights[i].isInInfluence(&center, radius))
+            polygonLights.push_back(i);
+        else
+            frameStatistics.lightsCulled++;
+    }
+}
+
+// Отсечь по экрану и растеризовать многоугольник, прошедший отбор
+// Предварительное условие: многоугольник освещен и находится в перспективном пространстве
+void Renderer::drawProjectedPolygon(Polygon* thePolygon, bool isWireframe){
+    TRACE_SCOPE("drawProjectedPolygon");
+
+    thePolygon->clipToScreen(currentScene->xLow, currentScene->xHigh, currentScene->yLow, currentScene->yHigh);
+
+    if(!thePolygon->isValid())
         return;
 
-    thePolygon.transform(&perspectiveToScreen, true);
+    thePolygon->transform(&perspectiveToScreen, true);
 
-    if(thePolygon.isLine()){
-        drawLine(Line(*(thePolygon.getLast()), *(thePolygon.getPrev(thePolygon.getLast()->vertexNumber) )), ambientOnly, true, 0, 0);
+    if(thePolygon->isLine()){
+        drawLine(Line(*(thePolygon->getLast()), *(thePolygon->getPrev(thePolygon->getLast()->vertexNumber) )), ambientOnly, true, 0, 0);
         return;
     }
 
-    // Триангуляция
-    vector<Polygon>* theFaces = thePolygon.getTriangulatedFaces();  
+    // Триангуляция (вектор переиспользуется, вершины треугольников берутся из арены кадра)
+    thePolygon->getTriangulatedFaces(triangulatedFaces);
 
-    for (unsigned int i = 0; i < theFaces->size(); i++){
+    for (unsigned int i = 0; i < triangulatedFaces.size(); i++){
 
         if (!isWireframe) {
-            rasterizePolygon( &theFaces->at(i) );
+            if (rasterizer == halfSpaceRasterizer)
+                rasterizeTriangleHalfSpace( &triangulatedFaces[i] );
+            else
+                rasterizePolygon( &triangulatedFaces[i] );
         }
         else{
-            drawPolygonWireframe( &theFaces->at(i) );
+            drawPolygonWireframe( &triangulatedFaces[i] );
         }
     }
-
-    delete theFaces;
 }
 
 // Рисуем многоугольник используя непрозрачность
 // Если вершины Полигона не одного цвета, цвет будет LERP'd
 void Renderer::rasterizePolygon(Polygon* thePolygon){
-
+    MEMORY_SCOPE(rasterMemory);
 
     Vertex* topLeftVertex = thePolygon->getHighest();
     Vertex* topRightVertex = topLeftVertex;
@@ -420,7 +478,15 @@ void Renderer::rasterizePolygon(Polygon* thePolygon){
         double xLeft_rounded = round(xLeft);
         double xRight_rounded = round(xRight);
 
-        if (thePolygon->getShadingModel() == phong){
+        // Проход дополнительного образца: строки без пикселей краев пропускаются
+        bool isRowDrawn = true;
+        if (isSamplePass){
+            unsigned int firstEdge, lastEdge;
+            adaptiveSampler.getRowEdges(yRes - y, (int)xLeft_rounded, (int)xRight_rounded, firstEdge, lastEdge);
+            isRowDrawn = firstEdge < lastEdge;
+        }
+
+        if (isRowDrawn && thePolygon->getShadingModel() == phong){
 
             Vertex lhs(xLeft_rounded, (double)y, leftCorrectZ, getPerspCorrectLerpColor(topLeftVertex, botLeftVertex, leftRatio));
             lhs.normal = NormalVector(topLeftVertex->normal, topLeftVertex->z, botLeftVertex->normal, botLeftVertex->z, y, topLeftVertex->y, botLeftVertex->y);
@@ -430,11 +496,11 @@ void Renderer::rasterizePolygon(Polygon* thePolygon){
 
             drawPerPxLitScanlineIfVisible( &lhs, &rhs, thePolygon->isAffectedByAmbientLight(), thePolygon->getSpecularCoefficient(), thePolygon->getSpecularExponent());
         }
-        else
+        else if (isRowDrawn)
         {
-            Vertex* start = new Vertex(xLeft_rounded, (double)y, leftCorrectZ, getPerspCorrectLerpColor(topLeftVertex, botLeftVertex, leftRatio));
-            Vertex* end = new Vertex(xRight_rounded, (double)y, rightCorrectZ, getPerspCorrectLerpColor(topRightVertex, botRightVertex, rightRatio));
-            drawScanlineIfVisible( start, end);
+            Vertex start(xLeft_rounded, (double)y, leftCorrectZ, getPerspCorrectLerpColor(topLeftVertex, botLeftVertex, leftRatio));
+            Vertex end(xRight_rounded, (double)y, rightCorrectZ, getPerspCorrectLerpColor(topRightVertex, botRightVertex, rightRatio));
+            drawScanlineIfVisible( &start, &end);
         }
 
         y--;
@@ -498,19 +564,134 @@ void Renderer::rasterizePolygon(Polygon* thePolygon){
     drawable->updateScreen();
 }
 
+// Рисуем треугольник функциями ребер, обходя экран блоками HalfSpaceRasterizer::TILE_SIZE
+// Предварительное условие: треугольник находится в экранных координатах
+void Renderer::rasterizeTriangleHalfSpace(Polygon* thePolygon){
+    MEMORY_SCOPE(rasterMemory);
+
+    // Вырожденные треугольники (отрезки) рисуются построчно, как и раньше
+    if (thePolygon->getVertexCount() != 3 || !halfSpace.setup( &thePolygon->vertices[0], &thePolygon->vertices[1], &thePolygon->vertices[2] )){
+        rasterizePolygon(thePolygon);
+        return;
+    }
+
+    const int tileSize = HalfSpaceRasterizer::TILE_SIZE;
+    unsigned char mask[tileSize];
+
+    // Блоки выровнены по экранной сетке:
+    for (int tileY = halfSpace.getYMin() - (halfSpace.getYMin() % tileSize); tileY <= halfSpace.getYMax(); tileY += tileSize){
+        for (int tileX = halfSpace.getXMin() - (halfSpace.getXMin() % tileSize); tileX <= halfSpace.getXMax(); tileX += tileSize){
+
+            // Проход дополнительного образца: блоки без пикселей краев пропускаются
+            if (isSamplePass){
+                ScreenRect tileRect;
+                tileRect.xMin = tileX;
+                tileRect.yMin = tileY;
+                tileRect.xMax = tileX + tileSize - 1;
+                tileRect.yMax = tileY + tileSize - 1;
+                if (!adaptiveSampler.hasEdges(tileRect))
+                    continue;
+            }
+
+            if (!halfSpace.getTileMask(tileX, tileY, mask))
+                continue;
+
+            for (int row = 0; row < tileSize; row++){
+                for (int column = 0; column < tileSize; column++){
+                    if (mask[row] & (1 << column))
+                        shadeHalfSpacePixel(thePolygon, tileX + column, tileY + row);
+                }
+            }
+        }
+    }
+
+    frameStatistics.tilesAccepted += halfSpace.tilesAccepted;
+    frameStatistics.tilesRejected += halfSpace.tilesRejected;
+    frameStatistics.tilesPartial += halfSpace.tilesPartial;
+
+    drawable->updateScreen();
+}
+
+// Закрасить пиксель треугольника по барицентрическим весам, с учетом Z-буфера
+// Интерполяция перспективно-корректна: линейно в экранном пространстве интерполируются 1 / z и значение / z
+void Renderer::shadeHalfSpacePixel(Polygon* thePolygon, int x, int y){
+
+    double weights[3];
+    halfSpace.getWeights(x, y, weights);
+
+    Vertex* v0 = halfSpace.getVertex(0);
+    Vertex* v1 = halfSpace.getVertex(1);
+    Vertex* v2 = halfSpace.getVertex(2);
+
+    double w0 = weights[0] / v0->z;
+    double w1 = weights[1] / v1->z;
+    double w2 = weights[2] / v2->z;
+    double inverseSum = 1.0 / (w0 + w1 + w2);
+
+    double correctZ = (weights[0] + weights[1] + weights[2]) * inverseSum;
+
+    if (!isVisible(x, y, correctZ))
+        return;
+
+    // Нормированные перспективно-корректные веса:
+    w0 *= inverseSum;
+    w1 *= inverseSum;
+    w2 *= inverseSum;
+
+    unsigned int color;
+    if (v0->color == v1->color && v1->color == v2->color)
+        color = v0->color;
+    else {
+        double red = w0 * extractColorChannel(v0->color, 1) + w1 * extractColorChannel(v1->color, 1) + w2 * extractColorChannel(v2->color, 1);
+        double green = w0 * extractColorChannel(v0->color, 2) + w1 * extractColorChannel(v1->color, 2) + w2 * extractColorChannel(v2->color, 2);
+        double blue = w0 * extractColorChannel(v0->color, 3) + w1 * extractColorChannel(v1->color, 3) + w2 * extractColorChannel(v2->color, 3);
+        color = combineColorChannels(red, green, blue);
+    }
+
+    if (thePolygon->getShadingModel() == phong){
+
+        Vertex currentPosition(x, y, correctZ);
+
+        currentPosition.transform(&screenToPerspective);
+
+        currentPosition.x *= correctZ;
+        currentPosition.y *= correctZ;
+
+        currentPosition.normal.xn = w0 * v0->normal.xn + w1 * v1->normal.xn + w2 * v2->normal.xn;
+        currentPosition.normal.yn = w0 * v0->normal.yn + w1 * v1->normal.yn + w2 * v2->normal.yn;
+        currentPosition.normal.zn = w0 * v0->normal.zn + w1 * v1->normal.zn + w2 * v2->normal.zn;
+        currentPosition.normal.normalize();
+
+        currentPosition.color = color;
+
+        NormalVector viewVector(-currentPosition.x, -currentPosition.y, -currentPosition.z);
+        viewVector.normalize();
+
+        // Концы строки треугольника: используются трассировкой лучей для граней с общим ребром
+        bool isEndPoint = !halfSpace.isCovered(x - 1, y) || !halfSpace.isCovered(x + 1, y);
+
+        setPixel(x, y, correctZ, recursivelyLightPointInCS(&currentPosition, &viewVector, thePolygon->isAffectedByAmbientLight(), thePolygon->getSpecularExponent(), thePolygon->getSpecularCoefficient(), currentScene->numRayBounces, isEndPoint) );
+    }
+    else if (currentScene->isDepthFogged)
+        setPixel(x, y, correctZ, getDistanceFoggedColor(color, correctZ) );
+    else
+        setPixel(x, y, correctZ, color);
+}
+
 // Осветить полигон, используя плоскую заливку
 // Предварительное условие: все вершины имеют действительную нормаль
 void Renderer::flatShadePolygon(Polygon* thePolygon){
 
-    unsigned int* ambientValues = new unsigned int[ thePolygon->getVertexCount() ];
+    // Временные массивы берутся из арены кадра и освобождаются вместе с ней
+    unsigned int* ambientValues = frameArena.allocateArray<unsigned int>( thePolygon->getVertexCount() );
 
-    double* redDiffuseTotals = new double[ thePolygon->getVertexCount() ];
-    double* greenDiffuseTotals = new double[ thePolygon->getVertexCount() ];
-    double* blueDiffuseTotals = new double[ thePolygon->getVertexCount() ];
+    double* redDiffuseTotals = frameArena.allocateArray<double>( thePolygon->getVertexCount() );
+    double* greenDiffuseTotals = frameArena.allocateArray<double>( thePolygon->getVertexCount() );
+    double* blueDiffuseTotals = frameArena.allocateArray<double>( thePolygon->getVertexCount() );
 
-    double* redSpecTotals = new double[ thePolygon->getVertexCount() ];
-    double* greenSpecTotals = new double[ thePolygon->getVertexCount() ];
-    double* blueSpecTotals = new double[ thePolygon->getVertexCount() ];
+    double* redSpecTotals = frameArena.allocateArray<double>( thePolygon->getVertexCount() );
+    double* greenSpecTotals = frameArena.allocateArray<double>( thePolygon->getVertexCount() );
+    double* blueSpecTotals = frameArena.allocateArray<double>( thePolygon->getVertexCount() );
 
     for (int i = 0; i < thePolygon->getVertexCount(); i++){
         ambientValues[i] = 0;
@@ -534,8 +715,11 @@ void Renderer::flatShadePolygon(Polygon* thePolygon){
     NormalVector faceNormal = thePolygon->getNormalAverage();
 
 
-    for (unsigned int i = 0; i < currentScene->theLights.size(); i++){
+    for (unsigned int j = 0; j < polygonLights.size(); j++){
+        unsigned int i = polygonLights[j];
 
+        if (!currentScene->theLights[i].isInInfluence(&faceCenter))
+            continue;
 
         NormalVector lightDirection(currentScene->theLights[i].position.x - faceCenter.x, currentScene->theLights[i].position.y - faceCenter.y, currentScene->theLights[i].position.z - faceCenter.z);
         lightDirection.normalize();
@@ -568,14 +752,8 @@ void Renderer::flatShadePolygon(Polygon* thePolygon){
             viewVector.normalize();
 
 
-            NormalVector reflectionVector = reflectOutVector(&faceNormal, &lightDirection);
-
-
-            double viewDotReflection = viewVector.dotProduct(reflectionVector);
-            if (viewDotReflection < 0)
-                viewDotReflection = 0;
-
-            viewDotReflection = pow(viewDotReflection, thePolygon->getSpecularExponent() );
+            // Для всей грани используется одно направление на свет и на наблюдателя (из центра грани)
+            double viewDotReflection = specularEvaluator.evaluate(&faceNormal, &lightDirection, &viewVector, thePolygon->getSpecularExponent() );
 
             redSpecIntensity *= (currentScene->theLights[i].redIntensity * attenuationFactor * viewDotReflection);
             greenSpecIntensity *= (currentScene->theLights[i].greenIntensity * attenuationFactor * viewDotReflection);
@@ -606,17 +784,6 @@ void Renderer::flatShadePolygon(Polygon* thePolygon){
                                                        )
                                                   );
     }
-
-
-    delete [] ambientValues;
-
-    delete [] redDiffuseTotals;
-    delete [] greenDiffuseTotals;
-    delete [] blueDiffuseTotals;
-
-    delete [] redSpecTotals;
-    delete [] greenSpecTotals;
-    delete [] blueSpecTotals;
 }
 
 // Осветить полигон, используя затенение Гуро
@@ -625,10 +792,23 @@ void Renderer::gouraudShadePolygon(Polygon* thePolygon){
 
     for (int i = 0; i < thePolygon->getVertexCount(); i++){
 
+        // Вершина, общая с уже освещенной гранью этой сетки, берется из кэша:
+        unsigned int litColor;
+        if (gouraudCache.find(&thePolygon->vertices[i], currentMeshIndex, currentMeshLodLevel, thePolygon->isAffectedByAmbientLight(), thePolygon->getSpecularExponent(), thePolygon->getSpecularCoefficient(), litColor)){
+            frameStatistics.gouraudCacheHits++;
+            thePolygon->vertices[i].color = litColor;
+            continue;
+        }
+
         NormalVector viewVector(-thePolygon->vertices[i].x, -thePolygon->vertices[i].y, -thePolygon->vertices[i].z);
         viewVector.normalize();
 
-        thePolygon->vertices[i].color = lightPointInCameraSpace(&thePolygon->vertices[i], &viewVector, thePolygon->isAffectedByAmbientLight(), thePolygon->getSpecularExponent(), thePolygon->getSpecularCoefficient());
+        litColor = lightPointInCameraSpace(&thePolygon->vertices[i], &viewVector, thePolygon->isAffectedByAmbientLight(), thePolygon->getSpecularExponent(), thePolygon->getSpecularCoefficient(), &polygonLights, currentPolygon);
+
+        frameStatistics.gouraudCacheMisses++;
+        gouraudCache.store(&thePolygon->vertices[i], currentMeshIndex, currentMeshLodLevel, thePolygon->isAffectedByAmbientLight(), thePolygon->getSpecularExponent(), thePolygon->getSpecularCoefficient(), litColor);
+
+        thePolygon->vertices[i].color = litColor;
     }
 }
 
@@ -650,25 +830,168 @@ void Renderer::drawPolygonWireframe(Polygon* thePolygon){
 
 // Рисуем каркас (сетку)
 void Renderer::drawMesh(Mesh* theMesh){
-    for (unsigned int i = 0; i < theMesh->faces.size(); i++){
-        currentPolygon = &theMesh->faces[i];
-        drawPolygon(theMesh->faces[i], theMesh->isWireframe);
+    vector<Polygon>& lodFaces = theMesh->getLodFaces(currentMeshLodLevel);
+    TRACE_SCOPE_ARG("drawMesh", "faces", lodFaces.size());
+
+    frameStatistics.facesDrawn += lodFaces.size();
+
+    if (!theMesh->isWireframe){
+        drawMeshBatched(lodFaces);
+        return;
+    }
+
+    for (unsigned int i = 0; i < lodFaces.size(); i++){
+        currentPolygon = &lodFaces[i];
+        drawPolygon(lodFaces[i], theMesh->isWireframe);
     }
 
     currentPolygon = nullptr;
 }
 
+// Рисуем заполненные грани сетки пакетом: отбор -> отсечение -> освещение -> проекция
+// Треугольники освещаются только после того, как прошли отбор по глубине, задним граням и усеченному конусу
+void Renderer::drawMeshBatched(vector<Polygon>& faces){
+    TRACE_SCOPE("drawMeshBatched");
+
+    geometryBatch.load(faces);
+
+    // Грани, не являющиеся треугольниками (линии, многоугольники), рисуются по одной:
+    if (geometryBatch.getSkippedCount() > 0){
+        for (unsigned int i = 0; i < faces.size(); i++){
+            if (faces[i].getVertexCount() == 3)
+                continue;
+
+            currentPolygon = &faces[i];
+            drawPolygon(faces[i], false);
+        }
+    }
+
+    // Этапы отбора над всем пакетом:
+    geometryBatch.cullDepth(currentScene->camHither, currentScene->camYon);
+    geometryBatch.cullBackFacing();
+    geometryBatch.cullFrustum(currentScene->xLow, currentScene->xHigh, currentScene->yLow, currentScene->yHigh);
+    geometryBatch.project();
+
+    frameStatistics.facesRejected += faces.size() - geometryBatch.getSkippedCount() - geometryBatch.size();
+
+    for (unsigned int i = 0; i < geometryBatch.size(); i++){
+
+        currentPolygon = &faces[ geometryBatch.getFaceIndex(i) ];
+        Polygon thePolygon( *currentPolygon );
+
+        if (geometryBatch.needsDepthClip(i)){
+            // Треугольник пересекает hither / yon: отсекаем и проецируем по одному
+            thePolygon.clipHitherYon(currentScene->camHither, currentScene->camYon);
+
+            if (!thePolygon.isValid() || isOutsideScissor(&thePolygon))
+                continue;
+
+            shadePolygon( &thePolygon, false );
+
+            thePolygon.transform( &cameraToPerspective );
+
+            if (!thePolygon.isFacingCamera() || !thePolygon.isInFrustum(currentScene->xLow, currentScene->xHigh, currentScene->yLow, currentScene->yHigh))
+                continue;
+        }
+        else {
+            if (isOutsideScissor(&thePolygon))
+                continue;
+
+            shadePolygon( &thePolygon, false );
+
+            geometryBatch.getProjectedPolygon(i, &thePolygon);
+        }
+
+        drawProjectedPolygon( &thePolygon, false );
+    }
+
+    currentPolygon = nullptr;
+}
+
+// Выбрать уровень детализации сетки по ее экранному размеру, с учетом гистерезиса
+// Предварительное условие: сетка находится в пространстве камеры
+int Renderer::selectLodLevel(Mesh* theMesh, unsigned int meshIndex){
+
+    if (previousLodLevels.size() <= meshIndex)
+        previousLodLevels.resize(meshIndex + 1, 0);
+
+    int maxLevel = theMesh->getLodCount() - 1;
+    if (maxLevel == 0 || !theMesh->hasBounds())
+        return 0;
+
+    Vertex center;
+    double radius;
+    theMesh->getBoundingSphere(center, radius);
+
+    // Сетка пересекает ближнюю плоскость: используем исходные грани
+    if (center.z - radius <= currentScene->camHither)
+        return previousLodLevels[meshIndex] = 0;
+
+    // Экранная площадь проекции ограничивающей сферы:
+    double projectedRadius = radius / center.z * screenScale;
+    double projectedArea = M_PI * projectedRadius * projectedRadius;
+
+    int level = std::min(previousLodLevels[meshIndex], maxLevel);
+
+    // Переходим на более детальный уровень, только если он уверенно помещается в экранную площадь
+    while (level > 0 && theMesh->getLodFaces(level - 1).size() * currentScene->lodPixelsPerFace * (1 + currentScene->lodHysteresis) <= projectedArea)
+        level--;
+
+    // Переходим на более грубый уровень, только если текущий уверенно не помещается
+    while (level < maxLevel && theMesh->getLodFaces(level).size() * currentScene->lodPixelsPerFace * (1 - currentScene->lodHysteresis) > projectedArea)
+        level++;
+
+    previousLodLevels[meshIndex] = level;
+
+    return level;
+}
+
+// Получить грани сетки, используемые при трассировке лучей
+vector<Polygon>& Renderer::getRayTraceFaces(Mesh* theMesh, bool isReflectionRay){
+    return theMesh->getLodFaces( getRayTraceLevel(theMesh, isReflectionRay) );
+}
+
+// Получить уровень детализации сетки, используемый при трассировке лучей (в пределах уровней сетки)
+int Renderer::getRayTraceLevel(Mesh* theMesh, bool isReflectionRay){
+    int level = 0;
+
+    if (theMesh == currentMesh)
+        level = currentMeshLodLevel;
+    else if (isReflectionRay)
+        level = currentScene->rayLodLevel;
+
+    return std::max(0, std::min(level, theMesh->getLodCount() - 1));
+}
+
 // Рендерим сцену
 void Renderer::renderScene(Scene theScene){
+    TRACE_SCOPE("renderScene");
     currentScene = &theScene;
+    frameStatistics.reset();
+
+    // Кадр рисуется во внутреннее изображение, если разрешение масштабируется
+    drawable = resolutionScaler.isEnabled() ? resolutionScaler.getImage() : outputDrawable;
+    frameStatistics.renderXRes = xRes;
+    frameStatistics.renderYRes = yRes;
+
+    // Копия сцены в параметре уже учтена вызывающим кодом; временные объекты кадра относятся к геометрии
+    MEMORY_SCOPE(geometryMemory);
 
-    drawRectangle(0, 0, xRes - 1, yRes - 1, currentScene->fogColor);
+    // Все временные объекты кадра (копии и отсечения многоугольников, треугольники, массивы освещения) берутся из арены
+    FrameArena::Scope arenaScope(&frameArena);
+
+    // Подпись неподвижной части сцены проверяется в мировом пространстве, до преобразования в пространство камеры
+    std::size_t bakedFacesBefore = 0;
+    if (isBakedLightingEnabled){
+        staticLighting.update(theScene);
+        bakedFacesBefore = staticLighting.getBakedFaces();
+    }
 
     transformCamera(theScene.cameraMovement);
 
     for (auto &currentLight : theScene.theLights){
         currentLight.position.transform(&worldToCamera);
-
+        currentLight.computeInfluenceRadius(currentScene->minLightContribution);
     }
 
 
@@ -676,87 +999,280 @@ void Renderer::renderScene(Scene theScene){
         processingMesh.transform(&worldToCamera);
     }
 
+    // Верхний уровень иерархии лучей: сетки в пространстве камеры
+    sceneBvh.update(theScene);
+    frameStatistics.bvhTopNodes = sceneBvh.getNodeCount();
+    frameStatistics.bvhInstances = sceneBvh.getInstanceCount();
+    frameStatistics.bvhRebuilds = sceneBvh.getRebuildCount();
+    frameStatistics.bvhRefits = sceneBvh.getRefitCount();
+
+    // Списки теневых сеток для пар (источник, приемник) по ограничивающим сферам в пространстве камеры
+    if (!theScene.noRayShadows){
+        shadowCasters.build(theScene);
+        frameStatistics.shadowCasters = shadowCasters.getCasterCount();
+        frameStatistics.shadowCasterPairs = shadowCasters.getPairCount();
+    }
 
-    for (auto &renderMesh : theScene.theMeshes){
-        currentMesh = &renderMesh; // Update the currentMesh pointer to the current mesh being drawn
-        drawMesh(&renderMesh);
+    // Область перерисовки: изменившиеся с предыдущего кадра сетки, их тени и отражения
+    scissor = dirtyRegions.update(theScene, &cameraToPerspective, &perspectiveToScreen, xRes, yRes);
+    isPartialRedraw = scissor.getArea() < (long long)xRes * yRes;
+    frameStatistics.redrawnPixels = scissor.getArea();
+    frameStatistics.screenPixels = (long long)xRes * yRes;
 
-//        // UNCOMMENT TO VISIBLY DEBUG BOUNDING BOXES:
-//        for (int i = 0; i < renderMesh.boundingBoxFaces.size(); i++){
-//            drawPolygon(renderMesh.boundingBoxFaces[i], true);
-//        }
+    if (!scissor.isEmpty()){
+        // Строка y рендерера выводится в строку yRes - y поверхности рисования
+        drawRectangle(scissor.xMin, yRes - scissor.yMax, scissor.xMax, std::min(yRes - scissor.yMin, yRes - 1), currentScene->fogColor);
+        resetDepthBuffer();
     }
 
 
+    adaptiveSampler.beginFrame(scissor);
+
+    // Освещение вершин действительно в течение кадра: проходы дополнительных образцов берут его из первого прохода
+    gouraudCache.clear();
+
+    drawMeshes(theScene);
+
+    // Дополнительные образцы пикселей на краях
+    if (adaptiveSampler.isEnabled())
+        antiAliasEdges(theScene);
+
+    // Увеличение до разрешения вывода: только пиксели вывода, зависящие от области перерисовки
+    if (resolutionScaler.isEnabled()){
+        TRACE_SCOPE("upscaleFrame");
+        frameStatistics.upscaledPixels = resolutionScaler.upscale(outputDrawable, scissor);
+        outputDrawable->updateScreen();
+    }
+    drawable = outputDrawable;
+
+
+    if (isBakedLightingEnabled){
+        frameStatistics.bakedFaces = staticLighting.getBakedFaces() - bakedFacesBefore;
+        frameStatistics.bakedCacheBytes = staticLighting.getMemoryUsed();
+    }
+
+    // Конец кадра: вся временная память возвращается за O(1)
+    frameStatistics.arenaBytesUsed = frameArena.getBytesUsed();
+    frameStatistics.arenaCapacity = frameArena.getCapacity();
+    frameArena.reset();
+
     currentScene = nullptr;
     currentMesh = nullptr;
+    currentMeshLodLevel = 0;
+}
+
+// Нарисовать сетки сцены в области перерисовки
+void Renderer::drawMeshes(Scene& theScene){
+    for (unsigned int meshIndex = 0; meshIndex < theScene.theMeshes.size() && !scissor.isEmpty(); meshIndex++){
+        Mesh& renderMesh = theScene.theMeshes[meshIndex];
+        TRACE_SCOPE_ARG("mesh", "index", meshIndex);
+
+        // Отбрасываем сетки, целиком лежащие вне объема видимости, до обработки граней:
+        if (!renderMesh.isInViewVolume(currentScene->camHither, currentScene->camYon, currentScene->xLow, currentScene->xHigh, currentScene->yLow, currentScene->yHigh)){
+            frameStatistics.meshesCulled++;
+            frameStatistics.facesCulled += renderMesh.faces.size();
+            continue;
+        }
+
+        // Сетка не изменилась и не попадает в область перерисовки: ее пиксели остались от предыдущего кадра
+        // (прямоугольники сеток вычисляются, только если отслеживание изменений включено)
+        if (isPartialRedraw && dirtyRegions.isEnabled() && !scissor.intersects(dirtyRegions.getMeshRect(meshIndex))){
+            frameStatistics.meshesClean++;
+            continue;
+        }
+
+        // Проход дополнительного образца: сетка не накрывает ни одного пикселя края
+        if (isSamplePass && dirtyRegions.isEnabled()){
+            ScreenRect meshRect = dirtyRegions.getMeshRect(meshIndex);
+            if (!meshRect.isEmpty()){
+                meshRect.xMin -= 2;
+                meshRect.xMax += 2;
+                meshRect.yMin -= 2;
+                meshRect.yMax += 2;
+            }
+            if (!adaptiveSampler.hasEdges(meshRect))
+                continue;
+        }
+
+        currentMesh = &renderMesh; // Update the currentMesh pointer to the current mesh being drawn
+        currentMeshIndex = meshIndex;
+        currentMeshLodLevel = selectLodLevel(&renderMesh, meshIndex);
+        frameStatistics.meshesDrawn++;
+        drawMesh(&renderMesh);
+    }
+}
+
+// Дополнительные образцы пикселей на краях
+// Каждый проход рисует сцену заново со сдвигом экрана на долю пикселя в отдельное изображение AdaptiveSampler.
+// Область перерисовки сужается до прямоугольника краев, а isVisible пропускает только пиксели краев:
+// освещение по пикселям и лучи считаются лишь для них. Сетки, грани, строки и блоки без пикселей краев пропускаются
+// до освещения и растеризации, а освещение вершин Гуро берется из кэша первого прохода
+void Renderer::antiAliasEdges(Scene& theScene){
+    TRACE_SCOPE("antiAliasEdges");
+
+    ScreenRect edgeRect = adaptiveSampler.findEdges(drawable, scissor);
+    frameStatistics.antiAliasedPixels = adaptiveSampler.getEdgePixelCount();
+    if (edgeRect.isEmpty())
+        return;
+
+    Drawable* frameDrawable = drawable;
+    ScreenRect frameScissor = scissor;
+    bool frameIsPartialRedraw = isPartialRedraw;
+    TransformationMatrix framePerspectiveToScreen = perspectiveToScreen;
+    TransformationMatrix frameScreenToPerspective = screenToPerspective;
+
+    scissor = edgeRect;
+    isPartialRedraw = true;
+    isSamplePass = true;
+
+    for (int pass = 1; pass < adaptiveSampler.getSampleCount(); pass++){
+        double dx, dy;
+        adaptiveSampler.getSampleOffset(pass, dx, dy);
+
+        // Сдвиг применяется после перехода в экранные координаты
+        perspectiveToScreen = TransformationMatrix();
+        perspectiveToScreen.addTranslation(dx, dy, 0);
+        perspectiveToScreen *= framePerspectiveToScreen;
+        screenToPerspective = perspectiveToScreen.getInverse();
+
+        drawable = adaptiveSampler.beginSamplePass(currentScene->fogColor);
+        resetDepthBuffer();
+        drawMeshes(theScene);
+        adaptiveSampler.endSamplePass();
+    }
+
+    drawable = frameDrawable;
+    adaptiveSampler.resolve(drawable);
+    drawable->updateScreen();
+
+    scissor = frameScissor;
+    isPartialRedraw = frameIsPartialRedraw;
+    isSamplePass = false;
+    perspectiveToScreen = framePerspectiveToScreen;
+    screenToPerspective = frameScreenToPerspective;
+
+    frameStatistics.antiAliasSamples = (unsigned long long)adaptiveSampler.getEdgePixelCount() * adaptiveSampler.getSamplePassCount();
 }
 
 // Нарисовать линию скана с учетом Z-буфера.
 // Предварительное условие: начальная и конечная вершины располагаются слева направо
 // Примечание: LERP, если start.color! = End.color. НЕ обновляет экран!
+// 1 / z и цвет / z линейны в экранном пространстве: они вычисляются один раз для строки и продвигаются сложением,
+// на пиксель остается одно деление
 void Renderer::drawScanlineIfVisible(Vertex* start, Vertex* end){
 
-    double z = start->z;
-    double z_slope; // Make sure we're setting a valid z-slope value
-    if (end->x - start->x == 0)
-        z_slope = 0;
-    else
-        z_slope = (end->z - start->z)/(double)(end->x - start->x);
-
     int x_start = (int)start->x;
     int x_end = (int)end->x;
     int y_rounded = (int)start->y;
 
-    double ratio = 0;
     double ratioDiff;
     if (x_end - x_start == 0)
         ratioDiff = 0;
     else
         ratioDiff = 1/(double)(x_end - x_start);
 
-    for (int x = x_start; x <= x_end; x++){
+    // Настройка строки: значения в начале и приращения на пиксель
+    double inverseZ = 1.0 / start->z;
+    double inverseZSlope = (1.0 / end->z - inverseZ) * ratioDiff;
+
+    bool isLerpColor = start->color != end->color;
+
+    double redOverZ = 0, greenOverZ = 0, blueOverZ = 0;
+    double redSlope = 0, greenSlope = 0, blueSlope = 0;
+    if (isLerpColor){
+        double endInverseZ = 1.0 / end->z;
 
-        double correctZ = getPerspCorrectLerpValue(start->z, start->z, end->z, end->z, ratio);
+        redOverZ = extractColorChannel(start->color, 1) * inverseZ;
+        greenOverZ = extractColorChannel(start->color, 2) * inverseZ;
+        blueOverZ = extractColorChannel(start->color, 3) * inverseZ;
+
+        redSlope = (extractColorChannel(end->color, 1) * endInverseZ - redOverZ) * ratioDiff;
+        greenSlope = (extractColorChannel(end->color, 2) * endInverseZ - greenOverZ) * ratioDiff;
+        blueSlope = (extractColorChannel(end->color, 3) * endInverseZ - blueOverZ) * ratioDiff;
+    }
+
+    // Пиксель строки по значениям, продвинутым до x
+    auto drawPixel = [&](int x, double pixelInverseZ, double pixelRedOverZ, double pixelGreenOverZ, double pixelBlueOverZ){
+        double correctZ = 1.0 / pixelInverseZ;
 
         if (isVisible(x, y_rounded, correctZ) ){
+            unsigned int pixelColor = start->color;
+            if (isLerpColor)
+                pixelColor = combineColorChannels(pixelRedOverZ * correctZ, pixelGreenOverZ * correctZ, pixelBlueOverZ * correctZ);
+
             if (currentScene->isDepthFogged)
-                setPixel(x, y_rounded, correctZ, getFogPixelValue(start, end, ratio, correctZ) );
+                setPixel(x, y_rounded, correctZ, getDistanceFoggedColor(pixelColor, correctZ) );
             else
-                setPixel(x, y_rounded, correctZ, getPerspCorrectLerpColor(start, end, ratio) );
+                setPixel(x, y_rounded, correctZ, pixelColor );
         }
+    };
+
+    // Проход дополнительного образца: только пиксели краев строки, значения вычисляются для каждого из них
+    if (isSamplePass){
+        unsigned int first, last;
+        adaptiveSampler.getRowEdges(yRes - y_rounded, x_start, x_end, first, last);
+        for (unsigned int edge = first; edge < last; edge++){
+            int x = adaptiveSampler.getEdgeX(edge);
+            double steps = x - x_start;
+            drawPixel(x, inverseZ + steps * inverseZSlope, redOverZ + steps * redSlope, greenOverZ + steps * greenSlope, blueOverZ + steps * blueSlope);
+        }
+        return;
+    }
+
+    for (int x = x_start; x <= x_end; x++){
+        drawPixel(x, inverseZ, redOverZ, greenOverZ, blueOverZ);
 
-        z += z_slope;
-        ratio += ratioDiff;
+        inverseZ += inverseZSlope;
+        redOverZ += redSlope;
+        greenOverZ += greenSlope;
+        blueOverZ += blueSlope;
     }
 }
 
 // Рисуем линию развертки с подсветкой на пиксель (Фонг), с учетом Z-буфера
+// Как и drawScanlineIfVisible, продвигает 1 / z, цвет / z и нормаль / z сложением
 void Renderer::drawPerPxLitScanlineIfVisible(Vertex* start, Vertex* end, bool doAmbient, double specularCoefficient, double specularExponent){
 
-    double zCameraSpace = start->z;
-    double z_slope;
-    if (end->x - start->x == 0)
-        z_slope = 0;
-    else
-        z_slope = (end->z - start->z)/(double)(end->x - start->x);
-
     int x_start = (int)start->x;
     int x_end = (int)end->x;
 
     int y_rounded = (int)start->y;
 
-    double ratio = 0;
     double ratioDiff;
     if (x_end - x_start == 0)
         ratioDiff = 0;
     else
         ratioDiff = 1/(double)(x_end - x_start);
 
-    // Draw:
-    for (int x = x_start; x <= x_end; x++){
+    // Настройка строки: значения в начале и приращения на пиксель
+    double inverseZ = 1.0 / start->z;
+    double endInverseZ = 1.0 / end->z;
+    double inverseZSlope = (endInverseZ - inverseZ) * ratioDiff;
+
+    double normalXOverZ = start->normal.xn * inverseZ;
+    double normalYOverZ = start->normal.yn * inverseZ;
+    double normalZOverZ = start->normal.zn * inverseZ;
+    double normalXSlope = (end->normal.xn * endInverseZ - normalXOverZ) * ratioDiff;
+    double normalYSlope = (end->normal.yn * endInverseZ - normalYOverZ) * ratioDiff;
+    double normalZSlope = (end->normal.zn * endInverseZ - normalZOverZ) * ratioDiff;
+
+    bool isLerpColor = start->color != end->color;
+
+    double redOverZ = 0, greenOverZ = 0, blueOverZ = 0;
+    double redSlope = 0, greenSlope = 0, blueSlope = 0;
+    if (isLerpColor){
+        redOverZ = extractColorChannel(start->color, 1) * inverseZ;
+        greenOverZ = extractColorChannel(start->color, 2) * inverseZ;
+        blueOverZ = extractColorChannel(start->color, 3) * inverseZ;
+
+        redSlope = (extractColorChannel(end->color, 1) * endInverseZ - redOverZ) * ratioDiff;
+        greenSlope = (extractColorChannel(end->color, 2) * endInverseZ - greenOverZ) * ratioDiff;
+        blueSlope = (extractColorChannel(end->color, 3) * endInverseZ - blueOverZ) * ratioDiff;
+    }
 
-        double correctZ = getPerspCorrectLerpValue(start->z, start->z, end->z, end->z, ratio); // Calculate the perspective correct Z for the current pixel
+    // Пиксель строки по значениям, продвинутым до x
+    auto drawPixel = [&](int x, double pixelInverseZ, double normalX, double normalY, double normalZ, double pixelRedOverZ, double pixelGreenOverZ, double pixelBlueOverZ){
+        double correctZ = 1.0 / pixelInverseZ; // Perspective correct Z for the current pixel: the only division per pixel
 
 
         if ( isVisible(x, y_rounded, correctZ) ){
@@ -771,12 +1287,15 @@ void Renderer::drawPerPxLitScanlineIfVisible(Vertex* start, Vertex* end, bool do
             currentPosition.y *= correctZ;
 
 
-            currentPosition.normal.xn = getPerspCorrectLerpValue(start->normal.xn, start->z, end->normal.xn, end->z, ratio);
-            currentPosition.normal.yn = getPerspCorrectLerpValue(start->normal.yn, start->z, end->normal.yn, end->z, ratio);
-            currentPosition.normal.zn = getPerspCorrectLerpValue(start->normal.zn, start->z, end->normal.zn, end->z, ratio);
+            currentPosition.normal.xn = normalX * correctZ;
+            currentPosition.normal.yn = normalY * correctZ;
+            currentPosition.normal.zn = normalZ * correctZ;
             currentPosition.normal.normalize();
 
-            currentPosition.color = getPerspCorrectLerpColor(start, end, ratio);
+            if (isLerpColor)
+                currentPosition.color = combineColorChannels(pixelRedOverZ * correctZ, pixelGreenOverZ * correctZ, pixelBlueOverZ * correctZ);
+            else
+                currentPosition.color = start->color;
 
 
             NormalVector viewVector(-currentPosition.x, -currentPosition.y, -currentPosition.z);
@@ -788,17 +1307,39 @@ void Renderer::drawPerPxLitScanlineIfVisible(Vertex* start, Vertex* end, bool do
 
             setPixel(x, y_rounded, correctZ, currentPosition.color);
         }
+    };
+
+    // Проход дополнительного образца: только пиксели краев строки, значения вычисляются для каждого из них
+    if (isSamplePass){
+        unsigned int first, last;
+        adaptiveSampler.getRowEdges(yRes - y_rounded, x_start, x_end, first, last);
+        for (unsigned int edge = first; edge < last; edge++){
+            int x = adaptiveSampler.getEdgeX(edge);
+            double steps = x - x_start;
+            drawPixel(x, inverseZ + steps * inverseZSlope, normalXOverZ + steps * normalXSlope, normalYOverZ + steps * normalYSlope, normalZOverZ + steps * normalZSlope,
+                      redOverZ + steps * redSlope, greenOverZ + steps * greenSlope, blueOverZ + steps * blueSlope);
+        }
+        return;
+    }
 
-        ratio += ratioDiff;
-
-        zCameraSpace += z_slope;
+    // Draw:
+    for (int x = x_start; x <= x_end; x++){
+        drawPixel(x, inverseZ, normalXOverZ, normalYOverZ, normalZOverZ, redOverZ, greenOverZ, blueOverZ);
+
+        inverseZ += inverseZSlope;
+        normalXOverZ += normalXSlope;
+        normalYOverZ += normalYSlope;
+        normalZOverZ += normalZSlope;
+        redOverZ += redSlope;
+        greenOverZ += greenSlope;
+        blueOverZ += blueSlope;
     }
 }
 
 // Рекурсивно лучевая трассировка освещения точки
 unsigned int Renderer::recursivelyLightPointInCS(Vertex* currentPosition, NormalVector* viewVector, bool doAmbient, double specularExponent, double specularCoefficient, int bounceRays, bool isEndPoint){
 
-    unsigned int initialColor = lightPointInCameraSpace(currentPosition, viewVector, doAmbient, specularExponent, specularCoefficient);
+    unsigned int initialColor = lightPointInCameraSpace(currentPosition, viewVector, doAmbient, specularExponent, specularCoefficient, &polygonLights, currentPolygon);
 
 
     if (bounceRays > 0){
@@ -819,63 +1360,76 @@ unsigned int Renderer::recursivelyLightPointInCS(Vertex* currentPosition, Normal
 
 // Рекурсивная вспомогательная функция для трассировки лучей
 unsigned int Renderer::recursiveLightHelper(Vertex* currentPosition, NormalVector* inBounceDirection, bool doAmbient, double specularExponent, double specularCoefficient, int bounceRays, bool isEndPoint){
+    MEMORY_SCOPE(rayTracingMemory);
+    TRACE_SCOPE_ARG("traceRay", "bounces", bounceRays);
 
-    Vertex* intersectionResult;
+    Vertex intersectionResult;
     Polygon* hitPoly;
     double hitDistance;
 
-    intersectionResult = new Vertex();
-
     hitPoly = nullptr;
     hitDistance = std::numeric_limits<double>::max();
     Vertex closestIntersection;
 
-    for (auto &currentVisibleMesh : currentScene->theMeshes){
+    // Обратное направление луча вычисляется один раз для проверки всех прямоугольников
+    SlabRay bounceRay(*currentPosition, *inBounceDirection);
 
-        for (int i = 0; i < currentVisibleMesh.boundingBoxFaces.size(); i++){
+    // Ближайшее пересечение с гранями одной сетки. Найденное расстояние hitDistance сокращает обход иерархий
+    auto traceMesh = [&](unsigned int meshIndex){
+        Mesh& currentVisibleMesh = currentScene->theMeshes[meshIndex];
+        vector<Polygon>& traceFaces = getRayTraceFaces(&currentVisibleMesh, true);
 
+        auto traceFace = [&](unsigned int j){
 
-            if ( getPolyPlaneIntersectionPoint(currentPosition, inBounceDirection, &currentVisibleMesh.boundingBoxFaces[i].vertices[0], &currentVisibleMesh.boundingBoxFaces[i].faceNormal, intersectionResult ) ){
+            if ( &traceFaces[j] == currentPolygon )
+                return false;
 
+            frameStatistics.rays.faceTests++;
 
-                if ( pointIsInsidePoly( &currentVisibleMesh.boundingBoxFaces[i], intersectionResult ) || currentMesh == &currentVisibleMesh ){
+            if ( getPolyPlaneFrontFaceIntersectionPoint(currentPosition, inBounceDirection, &traceFaces[j].vertices[0], &traceFaces[j].faceNormal, &intersectionResult ) ){
 
 
-                    for (int j = 0; j < currentVisibleMesh.faces.size(); j++){
+                if( pointIsInsidePoly( &traceFaces[j], &intersectionResult )
 
+                        && (currentMesh !=  &currentVisibleMesh   || !isEndPoint || !haveSharedEdge(currentPolygon, &traceFaces[j]) || !isFaceReflexAngle(currentPolygon, &traceFaces[j]) )
+                  )
+                {
 
-                        if ( &currentVisibleMesh.faces[j] == currentPolygon )
-                            continue;
-
-
-                        if ( getPolyPlaneFrontFaceIntersectionPoint(currentPosition, inBounceDirection, &currentVisibleMesh.faces[j].vertices[0], &currentVisibleMesh.faces[j].faceNormal, intersectionResult ) ){
+                    double currentHitDistance = (intersectionResult - *currentPosition).length();
 
+                    if (currentHitDistance < hitDistance){
+                        hitDistance = currentHitDistance;
+                        hitPoly = &traceFaces[j];
+                        closestIntersection = intersectionResult;
+                    }
+                }
+            }
 
-                            if( pointIsInsidePoly( &currentVisibleMesh.faces[j], intersectionResult )
+            return false; // Ищем ближайшее пересечение: обход не останавливается
+        };
 
-                                    && (currentMesh !=  &currentVisibleMesh   || !isEndPoint || !haveSharedEdge(currentPolygon, &currentVisibleMesh.faces[j]) || !isFaceReflexAngle(currentPolygon, &currentVisibleMesh.faces[j]) )
-                              )
-                            {
+        const MeshBvh* meshBvh = sceneBvh.getMeshBvh(meshIndex, getRayTraceLevel(&currentVisibleMesh, true));
+        if (meshBvh != nullptr)
+            meshBvh->traverse(sceneBvh.getObjectRay(meshIndex, *currentPosition, *inBounceDirection), hitDistance, traceFace, frameStatistics.rays.boxTests);
+        else {
+            for (unsigned int j = 0; j < traceFaces.size(); j++)
+                traceFace(j);
+        }
+    };
 
-                                double currentHitDistance = (*intersectionResult - *currentPosition).length();
+    // Грани текущей сетки проверяются всегда: луч начинается на ее поверхности
+    if (currentMesh != nullptr && currentMesh->hasBounds())
+        traceMesh(currentMeshIndex);
 
-                                if (currentHitDistance < hitDistance){
-                                    hitDistance = currentHitDistance;
-                                    hitPoly = &currentVisibleMesh.faces[j];
-                                    closestIntersection = *intersectionResult;
-                                }
-                            }
-                        }
-                    }
+    sceneBvh.traverse(bounceRay, hitDistance, [&](unsigned int meshIndex){
+        if (&currentScene->theMeshes[meshIndex] != currentMesh)
+            traceMesh(meshIndex);
+        return false;
+    }, frameStatistics.rays.boxTests);
 
-                    break;
-                }
-            }
-        }
-    }
+    frameStatistics.rays.addReflectionRay(currentScene->numRayBounces - bounceRays, hitPoly != nullptr);
 
 
-    delete intersectionResult;
 
 
     if (hitPoly != nullptr){
@@ -886,7 +1440,7 @@ unsigned int Renderer::recursiveLightHelper(Vertex* currentPosition, NormalVecto
         inBounceDirection->reverse();
 
 
-        closestIntersection.color = lightPointInCameraSpace(&closestIntersection, inBounceDirection, hitPoly->isAffectedByAmbientLight(), hitPoly->getSpecularExponent(), hitPoly->getSpecularCoefficient());
+        closestIntersection.color = lightPointInCameraSpace(&closestIntersection, inBounceDirection, hitPoly->isAffectedByAmbientLight(), hitPoly->getSpecularExponent(), hitPoly->getSpecularCoefficient(), nullptr);
 
 
         if (bounceRays > 0 && hitPoly->getReflectivity() > 0){
@@ -911,8 +1465,9 @@ unsigned int Renderer::recursiveLightHelper(Vertex* currentPosition, NormalVecto
 }
 
 // Осветить заданную точку в пространстве камеры
-unsigned int Renderer::lightPointInCameraSpace(Vertex* currentPosition, NormalVector* viewVector, bool doAmbient, double specularExponent, double specularCoefficient) {
+unsigned int Renderer::lightPointInCameraSpace(Vertex* currentPosition, NormalVector* viewVector, bool doAmbient, double specularExponent, double specularCoefficient, vector<unsigned int>* nearbyLights, Polygon* surface) {
 
+    frameStatistics.rays.shadingPoints++;
 
     unsigned int ambientValue = 0;
     double redTotalDiffuseIntensity, greenTotalDiffuseIntensity, blueTotalDiffuseIntensity, redTotalSpecIntensity, greenTotalSpecIntensity, blueTotalSpecIntensity;
@@ -924,8 +1479,18 @@ unsigned int Renderer::lightPointInCameraSpace(Vertex* currentPosition, NormalVe
     }
 
 
-    for (unsigned int i = 0; i < currentScene->theLights.size(); i++){
+    // Видимость источников от неподвижных сеток в этой точке уже запечена:
+    unsigned int bakedShadowMask = 0;
+    bool isBaked = surface != nullptr && !currentScene->noRayShadows && getBakedShadowMask(surface, currentPosition, bakedShadowMask);
 
+    unsigned int numLights = (nearbyLights != nullptr) ? nearbyLights->size() : currentScene->theLights.size();
+
+    for (unsigned int j = 0; j < numLights; j++){
+        unsigned int i = (nearbyLights != nullptr) ? (*nearbyLights)[j] : j;
+
+        // Свет не достает до точки: пропускаем направление, ослабление и теневой луч
+        if (!currentScene->theLights[i].isInInfluence(currentPosition))
+            continue;
 
         NormalVector lightDirection(currentScene->theLights[i].position.x - currentPosition->x, currentScene->theLights[i].position.y - currentPosition->y, currentScene->theLights[i].position.z - currentPosition->z);
         lightDirection.normalize();
@@ -939,7 +1504,31 @@ unsigned int Renderer::lightPointInCameraSpace(Vertex* currentPosition, NormalVe
             double lightDistance = NormalVector(currentScene->theLights[i].position.x - currentPosition->x, currentScene->theLights[i].position.y - currentPosition->y, currentScene->theLights[i].position.z - currentPosition->z).length();
 
 
-            if (currentScene->noRayShadows || !isShadowed(*currentPosition, &lightDirection, lightDistance) ){
+            bool isInShadow;
+            if (currentScene->noRayShadows)
+                isInShadow = false;
+            else {
+                // Точка грани текущей сетки проверяет только сетки, которые могут ее затенять от этого источника
+                // (списки строятся только при включенных тенях)
+                vector<unsigned int>* casters = (surface != nullptr) ? shadowCasters.getCasters(i, currentMeshIndex) : nullptr;
+
+                if (isBaked && i < StaticLightingCache::MAX_LIGHTS){
+                    // Неподвижные сетки - по запеченной маске, подвижные - лучом
+                    isInShadow = (bakedShadowMask & (1u << i)) != 0;
+                    if (!isInShadow){
+                        shadowOccluders = dynamicOccluders;
+                        isInShadow = isShadowed(*currentPosition, &lightDirection, lightDistance, casters);
+                        shadowOccluders = allOccluders;
+                        frameStatistics.rays.addShadowRay(i, isInShadow);
+                    }
+                }
+                else {
+                    isInShadow = isShadowed(*currentPosition, &lightDirection, lightDistance, casters);
+                    frameStatistics.rays.addShadowRay(i, isInShadow);
+                }
+            }
+
+            if (!isInShadow){
 
                 double attenuationFactor = currentScene->theLights[i].getAttenuationFactor(lightDistance);
 
@@ -959,10 +1548,7 @@ unsigned int Renderer::lightPointInCameraSpace(Vertex* currentPosition, NormalVe
                 blueTotalDiffuseIntensity += blueDiffuseIntensity;
 
 
-                NormalVector reflectionVector = reflectOutVector(&(currentPosition->normal), &lightDirection);
-
-
-                double viewDotReflection = viewVector->dotProduct(reflectionVector);
+                double viewDotReflection = specularEvaluator.evaluate(&(currentPosition->normal), &lightDirection, viewVector, specularExponent);
 
                 if (viewDotReflection > 0){
 
@@ -970,8 +1556,6 @@ unsigned int Renderer::lightPointInCameraSpace(Vertex* currentPosition, NormalVe
                     double greenSpecIntensity = specularCoefficient;
                     double blueSpecIntensity = specularCoefficient;
 
-                    viewDotReflection = pow(viewDotReflection, specularExponent );
-
                     redSpecIntensity *= (currentScene->theLights[i].redIntensity * attenuationFactor * viewDotReflection);
                     greenSpecIntensity *= (currentScene->theLights[i].greenIntensity * attenuationFactor * viewDotReflection);
                     blueSpecIntensity *= (currentScene->theLights[i].blueIntensity * attenuationFactor * viewDotReflection);
@@ -1001,68 +1585,108 @@ unsigned int Renderer::lightPointInCameraSpace(Vertex* currentPosition, NormalVe
                         );
 }
 
-// Определяем, затенена ли текущая позиция каким-либо полигоном в сцене, которая находится между ней и источником света
-bool Renderer::isShadowed(Vertex currentPosition, NormalVector* lightDirection, double lightDistance){
-
-    currentPosition += (currentPosition.normal * 0.1);
-
+// Получить запеченную маску источников света, закрытых неподвижными сетками, в точке грани текущей сетки
+// Грани адресуются номером сетки, уровнем детализации и номером грани на этом уровне
+bool Renderer::getBakedShadowMask(Polygon* surface, Vertex* currentPosition, unsigned int& shadowMask){
+    if (!isBakedLightingEnabled || currentMesh == nullptr || !currentMesh->isStatic || currentMesh->isWireframe)
+        return false;
 
-    Vertex* intersectionResult = new Vertex();
+    vector<Polygon>& lodFaces = currentMesh->getLodFaces(currentMeshLodLevel);
+    if (lodFaces.empty() || surface < lodFaces.data() || surface >= lodFaces.data() + lodFaces.size())
+        return false;
 
+    frameStatistics.bakedShadowLookups++;
 
-    for (auto &currentVisibleMesh : currentScene->theMeshes){
+    // Узлы запекаются при первом обращении к грани. Угловые узлы лежат в вершинах с их нормалями,
+    // поэтому у граней, делящих вершину, они совпадают: освещение вершины Гуро не зависит от грани
+    return staticLighting.getShadowMask(currentMeshIndex, currentMeshLodLevel, surface - lodFaces.data(), surface, currentPosition, currentScene->theLights.size(),
+        [this](Vertex& position, unsigned int lightIndex){
+            Light& theLight = currentScene->theLights[lightIndex];
 
+            NormalVector lightDirection(theLight.position.x - position.x, theLight.position.y - position.y, theLight.position.z - position.z);
+            double lightDistance = lightDirection.length();
+            lightDirection.normalize();
 
-        for (int i = 0; i < currentVisibleMesh.boundingBoxFaces.size(); i++){
+            shadowOccluders = staticOccluders;
+            bool result = isShadowed(position, &lightDirection, lightDistance, shadowCasters.getCasters(lightIndex, currentMeshIndex));
+            shadowOccluders = allOccluders;
+            frameStatistics.rays.addShadowRay(lightIndex, result);
 
+            return result;
+        },
+        shadowMask);
+}
 
-            if (    ( getPolyPlaneIntersectionPoint(&currentPosition, lightDirection, &currentVisibleMesh.boundingBoxFaces[i].vertices[0], &currentVisibleMesh.boundingBoxFaces[i].faceNormal, intersectionResult ) )
+// Определяем, затенена ли текущая позиция каким-либо полигоном в сцене, которая находится между ней и источником света
+bool Renderer::isShadowed(Vertex currentPosition, NormalVector* lightDirection, double lightDistance, vector<unsigned int>* casters){
+    MEMORY_SCOPE(rayTracingMemory);
+    TRACE_SCOPE("shadowRay");
 
+    // Луч начинается над поверхностью вдоль нормали точки: собственные грани точки остаются позади него и не исключаются,
+    // поэтому результат не зависит от того, какая грань освещается
+    currentPosition += (currentPosition.normal * 0.1);
 
-                 && ( (*intersectionResult - currentPosition).length() < lightDistance )
 
+    Vertex intersectionResult;
 
-                 && ( pointIsInsidePoly( &currentVisibleMesh.boundingBoxFaces[i], intersectionResult ) )
-                ) {
 
-                        for (int j = 0; j < currentVisibleMesh.faces.size(); j++){
+    SlabRay shadowRay(currentPosition, *lightDirection);
 
+    // Закрывает ли грань одной сетки источник света
+    auto isBlockedByMesh = [&](unsigned int meshIndex){
+        Mesh& currentVisibleMesh = currentScene->theMeshes[meshIndex];
 
-                            if ( &currentVisibleMesh.faces[j] == currentPolygon )
-                                continue;
+        if ( (shadowOccluders == staticOccluders && !currentVisibleMesh.isStatic) || (shadowOccluders == dynamicOccluders && currentVisibleMesh.isStatic) )
+            return false;
 
+        vector<Polygon>& traceFaces = getRayTraceFaces(&currentVisibleMesh, false);
 
-                            if ( ( getPolyPlaneBackFaceIntersectionPoint(&currentPosition, lightDirection, &currentVisibleMesh.faces[j].vertices[0], &currentVisibleMesh.faces[j].faceNormal, intersectionResult ) )
+        auto isBlockedByFace = [&](unsigned int j){
 
+            frameStatistics.rays.faceTests++;
 
-                                && ( (*intersectionResult - currentPosition).length() < lightDistance )
+            return ( getPolyPlaneBackFaceIntersectionPoint(&currentPosition, lightDirection, &traceFaces[j].vertices[0], &traceFaces[j].faceNormal, &intersectionResult ) )
 
 
-                                && ( pointIsInsidePoly( &currentVisibleMesh.faces[j], intersectionResult ) )
+                && ( (intersectionResult - currentPosition).length() < lightDistance )
 
-                                 ){
 
+                && ( pointIsInsidePoly( &traceFaces[j], &intersectionResult ) );
+        };
 
-                                    delete intersectionResult;
+        const MeshBvh* meshBvh = sceneBvh.getMeshBvh(meshIndex, getRayTraceLevel(&currentVisibleMesh, false));
+        if (meshBvh != nullptr)
+            return meshBvh->traverse(sceneBvh.getObjectRay(meshIndex, currentPosition, *lightDirection), lightDistance, isBlockedByFace, frameStatistics.rays.boxTests);
 
-                                    return true;
+        for (unsigned int j = 0; j < traceFaces.size(); j++){
+            if (isBlockedByFace(j))
+                return true;
+        }
 
-                            }
-                        }
+        return false;
+    };
 
-                        break;
+    // Списки теневых сеток уже отобраны: прямоугольник каждой сетки проверяется отдельно
+    if (casters != nullptr){
+        for (unsigned int k = 0; k < casters->size(); k++){
+            Mesh& currentVisibleMesh = currentScene->theMeshes[ (*casters)[k] ];
 
-                    }
+            // Луч не пересекает прямоугольник сетки ближе источника: грани не проверяются
+            frameStatistics.rays.boxTests++;
+            if (!currentVisibleMesh.hasBounds() || !currentVisibleMesh.boundingBox.intersectsRay(shadowRay, lightDistance))
+                continue;
 
+            if (isBlockedByMesh( (*casters)[k] ))
+                return true;
         }
-    }
-
 
-    delete intersectionResult;
+        return false;
+    }
 
-    return false;
+    return sceneBvh.traverse(shadowRay, lightDistance, isBlockedByMesh, frameStatistics.rays.boxTests);
 }
 
+
 // Находим точку пересечения луча и плоскости многоугольника
 // Return: True, если луч пересекается, в противном случае - false. Изменяет результат Vertex, чтобы быть точкой пересечения, в противном случае оставляет его неизменным
 bool Renderer::getPolyPlaneBackFaceIntersectionPoint(Vertex* currentPosition, NormalVector* currentDirection, Vertex* planePoint, NormalVector* planeNormal, Vertex* intersectionResult){
@@ -1201,14 +1825,63 @@ unsigned int Renderer::getDistanceFoggedColor(unsigned int pixelColor, double co
 }
 
 // Сброс буфера глубины
+// Проход дополнительного образца проверяет глубину только в пикселях краев: сбрасываются лишь они
 void Renderer::resetDepthBuffer(){
-    for (int x = 0; x < xRes; x++){
-        for (int y = 0; y < yRes; y++){
-            ZBuffer[x][y] = maxZVal;
+    if (isSamplePass){
+        for (int y = scissor.yMin; y <= scissor.yMax; y++){
+            unsigned int first, last;
+            adaptiveSampler.getRowEdges(yRes - y, scissor.xMin, scissor.xMax, first, last);
+            for (unsigned int edge = first; edge < last; edge++)
+                ZBuffer[yRes - y][adaptiveSampler.getEdgeX(edge)] = maxZVal;
+        }
+        return;
+    }
+
+    for (int y = scissor.yMin; y <= scissor.yMax; y++){
+        for (int x = scissor.xMin; x <= scissor.xMax; x++){
+            ZBuffer[yRes - y][x] = maxZVal;
         }
     }
 }
 
+// Проверить, что многоугольник в пространстве камеры целиком вне области перерисовки
+bool Renderer::isOutsideScissor(Polygon* thePolygon){
+    if (!isPartialRedraw)
+        return false;
+
+    double xMin = 0, xMax = 0, yMin = 0, yMax = 0;
+    for (int i = 0; i < thePolygon->getVertexCount(); i++){
+        Vertex screenVertex( thePolygon->vertices[i].x, thePolygon->vertices[i].y, thePolygon->vertices[i].z );
+        screenVertex.transform(&cameraToPerspective);
+        screenVertex.transform(&perspectiveToScreen);
+
+        if (i == 0 || screenVertex.x < xMin)
+            xMin = screenVertex.x;
+        if (i == 0 || screenVertex.x > xMax)
+            xMax = screenVertex.x;
+        if (i == 0 || screenVertex.y < yMin)
+            yMin = screenVertex.y;
+        if (i == 0 || screenVertex.y > yMax)
+            yMax = screenVertex.y;
+    }
+
+    // Поле в 2 пикселя покрывает округление растеризатора
+    if (xMax + 2 < scissor.xMin || xMin - 2 > scissor.xMax || yMax + 2 < scissor.yMin || yMin - 2 > scissor.yMax)
+        return true;
+
+    // Проход дополнительного образца: многоугольник без пикселей краев не освещается и не растеризуется
+    if (isSamplePass){
+        ScreenRect polygonRect;
+        polygonRect.xMin = (int)std::floor(xMin) - 2;
+        polygonRect.xMax = (int)std::ceil(xMax) + 2;
+        polygonRect.yMin = (int)std::floor(yMin) - 2;
+        polygonRect.yMax = (int)std::ceil(yMax) + 2;
+        return !adaptiveSampler.hasEdges(polygonRect);
+    }
+
+    return false;
+}
+
 // Установить пиксель на растре
 // Предварительное условие: точка является действительной координатой на растровом холсте и была предварительно проверена по z-буферу
 void Renderer::setPixel(int x, int y, double z, unsigned int color){
@@ -1217,12 +1890,16 @@ void Renderer::setPixel(int x, int y, double z, unsigned int color){
 
     drawable->setPixel(x, y, color);
 
-    ZBuffer[x][y] = getScaledZVal( z );
+    // Сетка и глубина пикселя первого прохода - для поиска краев
+    if (adaptiveSampler.isEnabled() && !isSamplePass)
+        adaptiveSampler.markCoverage(x, y, currentMeshIndex + 1, z);
+
+    ZBuffer[y][x] = getScaledZVal( z );
 }
 
 // Проверяем, находится ли пиксельная координата перед текущей глубиной z-буфера
 bool Renderer::isVisible(int x, int y, double z){
-    return ( getScaledZVal( z ) < ZBuffer[x][yRes - y]);
+    return scissor.contains(x, y) && (!isSamplePass || adaptiveSampler.isEdge(x, yRes - y)) && ( getScaledZVal( z ) < ZBuffer[yRes - y][x]);
 }
 
 // Получить масштабированное значение z-буфера для данного Z
@@ -1232,8 +1909,7 @@ int Renderer::getScaledZVal(double correctZ){
 
 // Изменить форму усеченного конуса
 void Renderer::transformCamera(TransformationMatrix cameraMovement){
-
-    resetDepthBuffer();
+    TRACE_SCOPE("transformCamera");
 
     worldToCamera = cameraMovement.getInverse();
 
@@ -1252,6 +1928,8 @@ void Renderer::transformCamera(TransformationMatrix cameraMovement){
         highestXYDelta = currentScene->yHigh - currentScene->yLow;
 
 
+    screenScale = (highestResolution - (2 * border)) / (highestXYDelta);
+
     perspectiveToScreen.addTranslation(xRes/2, yRes/2, 0);
 
     perspectiveToScreen.addNonUniformScale( (highestResolution - (2 * border)) / (highestXYDelta), ( (highestResolution - (2 * border)) / (highestXYDelta) ), 1 ); // Scale
@@ -1263,17 +1941,6 @@ void Renderer::transformCamera(TransformationMatrix cameraMovement){
     screenToPerspective = screenToPerspective.getInverse();
 }
 
-// Рассчитать отражение вектора, направленного в сторону от поверхности
-NormalVector Renderer::reflectOutVector(NormalVector* faceNormal, NormalVector* outVector){
-
-    NormalVector bounceDirection( *faceNormal );
-    bounceDirection *= 2 * (faceNormal->dotProduct( *outVector ) );
-    bounceDirection -= *outVector;
-    bounceDirection.normalize();
-
-    return bounceDirection;
-}
-
 // Обновляем точку пересечения трассировки лучей с помощью интерполированных нормалей и значений цвета
 void Renderer::setInterpolatedIntersectionValues(Vertex* intersectionPoint, Polygon* hitPoly){
 
@@ -1428,6 +2095,75 @@ bool Renderer::isFaceReflexAngle(Polygon* currentPoly, Polygon* hitPoly){
 }
 
 
+// Выбрать растеризатор заполненных треугольников
+void Renderer::setRasterizer(RasterizerType newRasterizer){
+    dirtyRegions.invalidate();
+    rasterizer = newRasterizer;
+}
+
+// Получить текущий растеризатор
+RasterizerType Renderer::getRasterizer(){
+    return rasterizer;
+}
+
+// Выбрать модель зеркального отражения
+void Renderer::setSpecularModel(SpecularModel newModel){
+    dirtyRegions.invalidate();
+    specularEvaluator.setModel(newModel);
+}
+
+// Перерисовывать только изменившиеся области
+void Renderer::setDirtyRegionsEnabled(bool isEnabled){
+    dirtyRegions.setEnabled(isEnabled);
+}
+
+// Следующий кадр перерисовывается целиком
+void Renderer::invalidateFrame(){
+    dirtyRegions.invalidate();
+}
+
+// Запекать тени неподвижных сеток
+void Renderer::setBakedLightingEnabled(bool isEnabled){
+    dirtyRegions.invalidate();
+    isBakedLightingEnabled = isEnabled;
+    if (!isEnabled)
+        staticLighting.clear();
+}
+
+// Сглаживать края дополнительными образцами
+void Renderer::setAntiAliasingSamples(int samplesPerPixel){
+    dirtyRegions.invalidate();
+    adaptiveSampler.setSampleCount(samplesPerPixel, xRes, yRes);
+}
+
+// Масштабировать внутреннее разрешение кадра
+void Renderer::setRenderScale(double scale){
+    if (!resolutionScaler.setScale(scale))
+        return;
+
+    // Пиксели предыдущего кадра в другом разрешении не используются
+    xRes = resolutionScaler.getXRes();
+    yRes = resolutionScaler.getYRes();
+    dirtyRegions.invalidate();
+    adaptiveSampler.setSampleCount(adaptiveSampler.getSampleCount(), xRes, yRes);
+}
+
+// Получить масштаб внутреннего разрешения
+double Renderer::getRenderScale(){
+    return resolutionScaler.getScale();
+}
+
+// Выбрать фильтр увеличения внутреннего изображения
+void Renderer::setUpscaleFilter(UpscaleFilter newFilter){
+    dirtyRegions.invalidate();
+    resolutionScaler.setFilter(newFilter);
+}
+
+// Получить статистику последнего отрисованного кадра
+RenderStatistics& Renderer::getFrameStatistics(){
+    return frameStatistics;
+}
+
 void Renderer::debugLights(){
 
     for (unsigned int i = 0; i < currentScene->theLights.size(); i++){
@@ -10,8 +10,35 @@
 #include "transformationmatrix.h"
 #include "light.h"
 #include "scene.h"
+#include "memorystatistics.h"
+#include "tracer.h"
+#include "renderstatistics.h"
+#include "geometrybatch.h"
+#include "halfspacerasterizer.h"
+#include "specularevaluator.h"
+#include "vertexlightingcache.h"
+#include "framearena.h"
+#include "dirtyregiontracker.h"
+#include "staticlightingcache.h"
+#include "shadowcastertable.h"
+#include "scenebvh.h"
+#include "adaptivesampler.h"
+#include "resolutionscaler.h"
 #include <limits>
 
+// Сетки, которые проверяются теневым лучом
+enum ShadowOccluders{
+    allOccluders = 0,
+    staticOccluders = 1,    // Только неподвижные сетки (запекание освещения)
+    dynamicOccluders = 2    // Только подвижные сетки (точки с запеченной видимостью)
+};
+
+// Перечислитель растеризатора заполненных треугольников: переключается во время выполнения для сравнения
+enum RasterizerType{
+    scanlineRasterizer = 0,     // Построчный обход ребер (rasterizePolygon)
+    halfSpaceRasterizer = 1     // Функции ребер по блокам экрана (rasterizeTriangleHalfSpace)
+};
+
 class Renderer{
 public:
     // Конструктор
@@ -29,18 +56,58 @@ public:
 
     void debugLights();
 
+    // Получить статистику последнего отрисованного кадра
+    RenderStatistics& getFrameStatistics();
+
+    // Выбрать растеризатор заполненных треугольников
+    void setRasterizer(RasterizerType newRasterizer);
+
+    // Получить текущий растеризатор
+    RasterizerType getRasterizer();
+
+    // Выбрать модель зеркального отражения (точная, табличная или Блинн-Фонг)
+    void setSpecularModel(SpecularModel newModel);
+
+    // Перерисовывать только области, изменившиеся с предыдущего кадра (по умолчанию включено)
+    // Остальные пиксели остаются от предыдущего кадра: поверхность рисования не должна меняться между кадрами
+    void setDirtyRegionsEnabled(bool isEnabled);
+
+    // Следующий кадр перерисовывается целиком (например, если поверхность рисования изменена извне)
+    void invalidateFrame();
+
+    // Запекать тени неподвижных сеток от источников света (по умолчанию выключено)
+    // Теневые лучи точек неподвижных сеток проверяют только подвижные сетки; видимость от неподвижных берется из StaticLightingCache
+    void setBakedLightingEnabled(bool isEnabled);
+
+    // Сглаживать края: samplesPerPixel образцов для пикселей на краях сеток, складках и резких перепадах цвета (1 = выключено)
+    // Дополнительные образцы - проходы со сдвигом экрана на долю пикселя, освещающие только пиксели краев
+    void setAntiAliasingSamples(int samplesPerPixel);
+
+    // Рисовать кадр во внутреннем разрешении scale * разрешение вывода и увеличивать его до поверхности рисования (1 = выключено)
+    // Масштаб можно менять перед каждым кадром: буферы не перераспределяются, кадр после изменения перерисовывается целиком
+    void setRenderScale(double scale);
+
+    // Получить масштаб внутреннего разрешения
+    double getRenderScale();
+
+    // Выбрать фильтр увеличения внутреннего изображения
+    void setUpscaleFilter(UpscaleFilter newFilter);
+
     // Отрисовка линии
     void drawLine(Line theLine, ShadingModel theShadingModel, bool doAmbient, double specularCoefficient, double specularExponent);
 
 private:
-    Drawable* drawable; // Drawable объект, используемый для взаимодействия с каркасом QT
+    Drawable* drawable; // Поверхность, в которую рисуется кадр: поверхность вывода или внутреннее изображение resolutionScaler
+    Drawable* outputDrawable;   // Drawable объект, используемый для взаимодействия с каркасом QT
 
     // Растровые настройки:
     int border;         // Ширина границы экрана
-    int xRes;           // Расчетное разрешение растра по горизонтали
+    int xRes;           // Расчетное разрешение растра по горизонтали (внутреннее, если кадр масштабируется)
     int yRes;           // Расчетное вертикальное разрешение растра
+    int outputXRes;     // Разрешение поверхности вывода
+    int outputYRes;
 
-    int** ZBuffer;               // Z Глубина буфера
+    int** ZBuffer;               // Z Глубина буфера [строка][столбец], выделяется под разрешение вывода
     int maxZVal = std::numeric_limits<int>::max();    // Максимально возможное значение глубины z
 
     // Рисуются объекты текущей сцены, сетки и многоугольника (используются для доступа к различным переменным рендеринга)
@@ -48,6 +115,44 @@ private:
     Mesh* currentMesh;
     Polygon* currentPolygon;
 
+    RenderStatistics frameStatistics;   // Статистика текущего кадра
+
+    GeometryBatch geometryBatch;        // Пакет треугольников текущей сетки (массивы переиспользуются между кадрами)
+
+    RasterizerType rasterizer = scanlineRasterizer;    // Растеризатор заполненных треугольников
+    HalfSpaceRasterizer halfSpace;                      // Функции ребер текущего треугольника
+
+    vector<unsigned int> polygonLights; // Индексы источников света, достигающих текущего многоугольника
+
+    SpecularEvaluator specularEvaluator;    // Зеркальный член освещения: таблицы степеней сохраняются между кадрами
+
+    VertexLightingCache gouraudCache;       // Освещенные вершины текущего кадра (затенение Гуро)
+
+    DirtyRegionTracker dirtyRegions;        // Изменения сцены между кадрами
+    ScreenRect scissor;                     // Область перерисовки текущего кадра: пиксели вне нее не изменяются
+    bool isPartialRedraw = false;           // Область перерисовки меньше экрана
+
+    StaticLightingCache staticLighting;     // Запеченная видимость источников света для неподвижных сеток
+    bool isBakedLightingEnabled = false;
+    ShadowOccluders shadowOccluders = allOccluders;   // Сетки, проверяемые isShadowed
+
+    SceneBvh sceneBvh;                      // Иерархия лучей: сетки кадра (верхний уровень) и их грани в пространстве объекта
+    ShadowCasterTable shadowCasters;        // Сетки, которые могут затенять каждую сетку от каждого источника (строится каждый кадр)
+
+    AdaptiveSampler adaptiveSampler;        // Края первого прохода и их дополнительные образцы
+    bool isSamplePass = false;              // Идет проход дополнительного образца: рисуются только пиксели краев
+
+    ResolutionScaler resolutionScaler;      // Внутреннее разрешение кадра и его увеличение до поверхности вывода
+
+    FrameArena frameArena;                  // Память временных объектов кадра: сбрасывается в конце renderScene
+    vector<Polygon> triangulatedFaces;      // Треугольники текущего многоугольника (память вектора переиспользуется)
+
+    // Уровни детализации:
+    vector<int> previousLodLevels;  // Уровень, выбранный для каждой сетки (по индексу) в предыдущем кадре: используется для гистерезиса
+    int currentMeshLodLevel = 0;    // Уровень детализации текущей отрисовываемой сетки
+    unsigned int currentMeshIndex = 0;  // Номер текущей сетки в сцене
+    double screenScale = 1;         // Количество пикселей на единицу перспективного пространства
+
     // Матрица преобразования из мира в пространство камеры
     TransformationMatrix worldToCamera;
 
@@ -64,12 +169,41 @@ private:
     // Предварительное условие: все полигоны находятся в пространстве камеры
     void drawPolygon(Polygon thePolygon, bool isWireframe);
 
+    // Осветить многоугольник в соответствии с его моделью затенения
+    // Предварительное условие: многоугольник находится в пространстве камеры и уже обрезан по hither / yon
+    void shadePolygon(Polygon* thePolygon, bool isWireframe);
+
+    // Отсечь по экрану и растеризовать многоугольник, прошедший отбор
+    // Предварительное условие: многоугольник освещен и находится в перспективном пространстве
+    void drawProjectedPolygon(Polygon* thePolygon, bool isWireframe);
+
+    // Рисуем заполненные грани сетки пакетом: отбор -> отсечение -> освещение -> проекция
+    void drawMeshBatched(vector<Polygon>& faces);
+
     // Рисуем многоугольник только в каркасном режиме
     void drawPolygonWireframe(Polygon* thePolygon);
 
     // Рисуем объект сетки
     void drawMesh(Mesh* theMesh);
 
+    // Нарисовать сетки сцены в области перерисовки
+    // Предварительное условие: сетки находятся в пространстве камеры
+    void drawMeshes(Scene& theScene);
+
+    // Взять дополнительные образцы пикселей на краях и записать их средние цвета
+    void antiAliasEdges(Scene& theScene);
+
+    // Выбрать уровень детализации сетки по ее экранному размеру, с учетом гистерезиса
+    // Предварительное условие: сетка находится в пространстве камеры
+    int selectLodLevel(Mesh* theMesh, unsigned int meshIndex);
+
+    // Получить грани сетки, используемые при трассировке лучей
+    // Текущая сетка всегда использует отрисовываемый уровень; остальные сетки - rayLodLevel сцены для отраженных лучей
+    vector<Polygon>& getRayTraceFaces(Mesh* theMesh, bool isReflectionRay);
+
+    // Получить уровень детализации граней getRayTraceFaces
+    int getRayTraceLevel(Mesh* theMesh, bool isReflectionRay);
+
     // Нарисовать линию скана с учетом Z-буфера.
     // Предварительное условие: начальная и конечная вершины располагаются слева направо
     // Примечание: LERP, если start.color! = End.color. НЕ обновляет экран!
@@ -78,9 +212,13 @@ private:
     // Рисуем линию развертки с подсветкой на пиксель фонг, с учетом Z-буфера
     void drawPerPxLitScanlineIfVisible(Vertex* start, Vertex* end, bool doAmbient, double specularCoefficient, double specularExponent);
 
-    // Сброс буфера глубины
+    // Сброс буфера глубины в области перерисовки
     void resetDepthBuffer();
 
+    // Проверить, что многоугольник в пространстве камеры целиком вне области перерисовки (освещать и рисовать его не нужно)
+    // Предварительное условие: многоугольник обрезан по hither
+    bool isOutsideScissor(Polygon* thePolygon);
+
     // Изменить форму усеченного конуса
     void transformCamera(TransformationMatrix cameraMovement);
 
@@ -106,6 +244,14 @@ private:
     // Если вершины Полигона не одного цвета, цвет будет LERP'd
     void rasterizePolygon(Polygon* thePolygon);
 
+    // Рисуем треугольник функциями ребер, обходя экран блоками HalfSpaceRasterizer::TILE_SIZE
+    // Результат совпадает с rasterizePolygon с точностью до округления интерполированных значений
+    // Предварительное условие: треугольник находится в экранных координатах
+    void rasterizeTriangleHalfSpace(Polygon* thePolygon);
+
+    // Закрасить пиксель треугольника по барицентрическим весам, с учетом Z-буфера
+    void shadeHalfSpacePixel(Polygon* thePolygon, int x, int y);
+
     // Осветить полигон, используя плоскую заливку
     // Предварительное условие: все вершины имеют действительную нормаль
     void flatShadePolygon(Polygon* thePolygon);
@@ -115,7 +261,17 @@ private:
     void gouraudShadePolygon(Polygon* thePolygon);
 
     // Осветить заданную точку в пространстве камеры
-    unsigned int lightPointInCameraSpace(Vertex* currentPosition, NormalVector* viewVector, bool doAmbient, double specularExponent, double specularCoefficient);
+    // nearbyLights: индексы источников света, которые нужно учитывать (nullptr = все источники сцены)
+    // surface: грань текущей сетки, которой принадлежит точка (для запеченной видимости; nullptr = не использовать)
+    unsigned int lightPointInCameraSpace(Vertex* currentPosition, NormalVector* viewVector, bool doAmbient, double specularExponent, double specularCoefficient, vector<unsigned int>* nearbyLights, Polygon* surface = nullptr);
+
+    // Получить запеченную маску источников света, закрытых неподвижными сетками, в точке грани текущей сетки
+    // Возвращает: false, если для этой точки запеченной видимости нет
+    bool getBakedShadowMask(Polygon* surface, Vertex* currentPosition, unsigned int& shadowMask);
+
+    // Собрать источники света, радиус влияния которых достигает ограничивающей сферы многоугольника, в polygonLights
+    // Предварительное условие: многоугольник и источники света находятся в пространстве камеры
+    void gatherPolygonLights(Polygon* thePolygon);
 
     // Рекурсивно лучевая трассировка освещения точки
     unsigned int recursivelyLightPointInCS(Vertex* currentPosition, NormalVector* viewVector, bool doAmbient, double specularExponent, double specularCoefficient, int bounceRays, bool isEndPoint);
@@ -130,7 +286,8 @@ private:
     int getScaledZVal(double correctZ);
 
     // Определяем, затенена ли текущая позиция каким-либо полигоном в сцене, которая находится между ней и источником света
-    bool isShadowed(Vertex currentPosition, NormalVector* lightDirection, double lightDistance);
+    // casters: номера сеток, которые нужно проверять (nullptr = все сетки сцены)
+    bool isShadowed(Vertex currentPosition, NormalVector* lightDirection, double lightDistance, vector<unsigned int>* casters);
 
     // Находим точку пересечения луча и плоскости многоугольника
     // Return: True, если луч пересекается, в противном случае - false. Изменяет результат Vertex, чтобы быть точкой пересечения, в противном случае оставляет его неизменным
@@ -147,9 +304,6 @@ private:
     // Определяем, находится ли точка на плоскости многоугольника внутри многоугольника
     bool pointIsInsidePoly(Polygon* thePolygon, Vertex* intersectionPoint);
 
-    // Рассчитать отражение вектора, направленного в сторону от поверхности
-    NormalVector reflectOutVector(NormalVector* faceNormal, NormalVector* outVector);
-
     // Обновляем точку пересечения трассировки лучей с помощью интерполированных нормалей и значений цвета
     void setInterpolatedIntersectionValues(Vertex* intersectionPoint, Polygon* hitPoly);
 
@@ -0,0 +1,73 @@
+#include "renderstatistics.h"
+#include <iostream>
+
+using std::cout;
+
+// Конструктор
+RenderStatistics::RenderStatistics(){
+    reset();
+}
+
+// Сбросить все счетчики
+void RenderStatistics::reset(){
+    meshesDrawn = 0;
+    meshesCulled = 0;
+    meshesClean = 0;
+
+    facesDrawn = 0;
+    facesCulled = 0;
+    facesRejected = 0;
+    facesShaded = 0;
+    lightsCulled = 0;
+    gouraudCacheHits = 0;
+    gouraudCacheMisses = 0;
+    shadowCasters = 0;
+    shadowCasterPairs = 0;
+    bvhTopNodes = 0;
+    bvhInstances = 0;
+    bvhRebuilds = 0;
+    bvhRefits = 0;
+    bakedShadowLookups = 0;
+    bakedFaces = 0;
+    bakedCacheBytes = 0;
+    redrawnPixels = 0;
+    screenPixels = 0;
+    antiAliasedPixels = 0;
+    antiAliasSamples = 0;
+    renderXRes = 0;
+    renderYRes = 0;
+    upscaledPixels = 0;
+    arenaBytesUsed = 0;
+    arenaCapacity = 0;
+    tilesAccepted = 0;
+    tilesRejected = 0;
+    tilesPartial = 0;
+    rays.reset();
+}
+
+// Вывести статистику кадра
+void RenderStatistics::debug(){
+    cout << "Meshes drawn:\t" << meshesDrawn << "\tculled: " << meshesCulled << "\tclean: " << meshesClean << "\n";
+    if (screenPixels > 0)
+        cout << "Pixels redrawn:\t" << redrawnPixels << "\t(" << (100.0 * redrawnPixels / screenPixels) << "%)\n";
+    if (antiAliasedPixels > 0)
+        cout << "Anti-aliased pixels:\t" << antiAliasedPixels << "\textra samples: " << antiAliasSamples << "\n";
+    if (upscaledPixels > 0)
+        cout << "Render resolution:\t" << renderXRes << "x" << renderYRes << "\tupscaled pixels: " << upscaledPixels << "\n";
+    cout << "Faces drawn:\t" << facesDrawn << "\tculled: " << facesCulled << "\n";
+    cout << "Faces rejected before shading:\t" << facesRejected << "\tshaded: " << facesShaded << "\n";
+    cout << "Lights culled per face:\t" << lightsCulled << "\n";
+    if (gouraudCacheMisses + gouraudCacheHits > 0)
+        cout << "Gouraud vertices lit:\t" << gouraudCacheMisses << "\tcached: " << gouraudCacheHits << "\t(" << (100.0 * gouraudCacheHits / (gouraudCacheMisses + gouraudCacheHits)) << "% hits)\n";
+    if (shadowCasterPairs > 0)
+        cout << "Shadow casters kept:\t" << shadowCasters << " of " << shadowCasterPairs << "\n";
+    rays.debug();
+    if (bvhTopNodes > 0)
+        cout << "Ray BVH top nodes:\t" << bvhTopNodes << "\tinstances: " << bvhInstances << "\trebuilds: " << bvhRebuilds << "\trefits: " << bvhRefits << "\n";
+    if (bakedShadowLookups + bakedFaces > 0)
+        cout << "Baked shadow lookups:\t" << bakedShadowLookups << "\tfaces baked: " << bakedFaces << "\tcache: " << bakedCacheBytes << " bytes\n";
+    cout << "Frame arena used:\t" << arenaBytesUsed << " bytes\tcapacity: " << arenaCapacity << " bytes\n";
+
+    if (tilesAccepted + tilesRejected + tilesPartial > 0)
+        cout << "Tiles accepted:\t" << tilesAccepted << "\trejected: " << tilesRejected << "\tpartial: " << tilesPartial << "\n";
+}
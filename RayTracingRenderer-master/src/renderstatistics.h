@@ -0,0 +1,77 @@
+#ifndef RENDERSTATISTICS_H
+#define RENDERSTATISTICS_H
+
+#include <cstddef>
+#include "raystatistics.h"
+
+// Статистика отрисовки одного кадра
+class RenderStatistics
+{
+public:
+    // Конструктор
+    RenderStatistics();
+
+    // Сбросить все счетчики. Вызывается в начале каждого кадра
+    void reset();
+
+    // Вывести статистику кадра
+    void debug();
+
+    // Счетчики сеток:
+    unsigned int meshesDrawn;       // Сетки, переданные на отрисовку граней
+    unsigned int meshesCulled;      // Сетки, отброшенные целиком до обработки граней
+    unsigned int meshesClean;       // Сетки вне области перерисовки: их пиксели взяты из предыдущего кадра
+
+    // Счетчики граней:
+    unsigned int facesDrawn;        // Грани, переданные в drawPolygon
+    unsigned int facesCulled;       // Грани отброшенных сеток
+    unsigned int facesRejected;     // Грани, отброшенные пакетным отбором до освещения
+    unsigned int facesShaded;       // Освещенные грани (плоская заливка и Гуро)
+    unsigned int lightsCulled;      // Пары (грань, источник света), отброшенные по радиусу влияния света
+
+    // Кэш освещения вершин (затенение Гуро):
+    unsigned int gouraudCacheHits;      // Вершины, взятые из кэша
+    unsigned int gouraudCacheMisses;    // Вершины, освещенные заново
+
+    // Списки теневых сеток (ShadowCasterTable):
+    std::size_t shadowCasters;          // Сетки, оставшиеся в списках всех пар (источник, приемник)
+    std::size_t shadowCasterPairs;      // Тройки (источник, приемник, сетка) до отбора
+
+    // Иерархия лучей (SceneBvh):
+    std::size_t bvhTopNodes;            // Узлы верхнего уровня
+    std::size_t bvhInstances;           // Сетки с иерархией граней
+    std::size_t bvhRebuilds;            // Построения верхнего уровня с начала работы
+    std::size_t bvhRefits;              // Пересчеты верхнего уровня без перестроения с начала работы
+
+    // Трассировка лучей (теневые и отраженные лучи, проверки прямоугольников и граней):
+    RayStatistics rays;
+
+    // Запеченные тени неподвижных сеток (StaticLightingCache):
+    unsigned int bakedShadowLookups;    // Точки, освещенные по запеченной видимости
+    std::size_t bakedFaces;             // Грани, запеченные в этом кадре
+    std::size_t bakedCacheBytes;        // Объем запеченных данных
+
+    // Область перерисовки (DirtyRegionTracker):
+    long long redrawnPixels;        // Пиксели прямоугольника перерисовки
+    long long screenPixels;         // Пиксели всего экрана
+
+    // Сглаживание краев (AdaptiveSampler):
+    unsigned int antiAliasedPixels;         // Пиксели краев, получившие дополнительные образцы
+    unsigned long long antiAliasSamples;    // Дополнительные образцы
+
+    // Внутреннее разрешение (ResolutionScaler):
+    int renderXRes;                 // Разрешение, в котором нарисован кадр
+    int renderYRes;
+    long long upscaledPixels;       // Пиксели вывода, записанные увеличением внутреннего изображения
+
+    // Память кадра:
+    std::size_t arenaBytesUsed;     // Байты, выделенные из арены кадра
+    std::size_t arenaCapacity;      // Общий размер блоков арены
+
+    // Счетчики блоков растеризатора полупространств:
+    unsigned int tilesAccepted;     // Блоки, целиком лежащие внутри треугольника
+    unsigned int tilesRejected;     // Блоки, целиком лежащие снаружи
+    unsigned int tilesPartial;      // Блоки, пересекающие ребра треугольника
+};
+
+#endif // RENDERSTATISTICS_H
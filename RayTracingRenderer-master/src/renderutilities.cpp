@@ -164,4 +164,31 @@ double getPerspCorrectLerpValue(double startVal, double startZ, double endVal, d
             / (double)( (ratio * startZ) + (oneMinusRatio * endZ));
 }
 
+// Рассчитать отражение вектора, направленного в сторону от поверхности
+NormalVector reflectOutVector(NormalVector* faceNormal, NormalVector* outVector){
 
+    NormalVector bounceDirection( *faceNormal );
+    bounceDirection *= 2 * (faceNormal->dotProduct( *outVector ) );
+    bounceDirection -= *outVector;
+    bounceDirection.normalize();
+
+    return bounceDirection;
+}
+
+// Добавить байты к хэшу FNV-1a
+void hashBytes(unsigned long long& hash, const void* data, std::size_t size){
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (std::size_t i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+// Добавить значение к хэшу FNV-1a
+void hashValue(unsigned long long& hash, double value){
+    hashBytes(hash, &value, sizeof(value));
+}
+
+void hashValue(unsigned long long& hash, unsigned long long value){
+    hashBytes(hash, &value, sizeof(value));
+}
@@ -1,6 +1,9 @@
 #ifndef RENDERUTILITIES_H
 #define RENDERUTILITIES_H
 
+#include <cstddef>
+#include "normalvector.h"
+
 // Регулировка цвета путем умножения на некоторое соотношение
 // Возвращает: 32-битное значение ARGB, каждый канал изменяется согласно заданному соотношению
 unsigned int multiplyColorChannels(unsigned int color, double ratio);
@@ -29,4 +32,18 @@ double extractColorChannel(unsigned int color, int channel);
 // Рассчитать перспективную правильную линейную интерполяцию некоторого значения
 double getPerspCorrectLerpValue(double startVal, double startZ, double endVal, double endZ, double ratio);
 
+// Рассчитать отражение вектора, направленного в сторону от поверхности: R = 2 (N . V) N - V
+// Используется и для отраженных лучей, и для зеркального члена освещения
+NormalVector reflectOutVector(NormalVector* faceNormal, NormalVector* outVector);
+
+// Начальное значение хэша FNV-1a
+const unsigned long long HASH_SEED = 14695981039346656037ULL;
+
+// Добавить байты к хэшу FNV-1a
+void hashBytes(unsigned long long& hash, const void* data, std::size_t size);
+
+// Добавить значение к хэшу FNV-1a
+void hashValue(unsigned long long& hash, double value);
+void hashValue(unsigned long long& hash, unsigned long long value);
+
 #endif // RENDERUTILITIES_H
@@ -0,0 +1,176 @@
+#include "resolutionscaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Конструктор
+ResolutionScaler::ResolutionScaler(){
+    outputXRes = 0;
+    outputYRes = 0;
+    xRes = 0;
+    yRes = 0;
+    scale = 1;
+    filter = bilinearUpscale;
+}
+
+// Задать разрешение вывода
+void ResolutionScaler::setOutputResolution(int newOutputXRes, int newOutputYRes){
+    outputXRes = newOutputXRes;
+    outputYRes = newOutputYRes;
+    xRes = outputXRes;
+    yRes = outputYRes;
+
+    double currentScale = scale;
+    scale = 1;
+    setScale(currentScale);
+}
+
+// Задать масштаб внутреннего разрешения
+bool ResolutionScaler::setScale(double newScale){
+    scale = std::max(MIN_SCALE, std::min(newScale, 1.0));
+
+    int newXRes = std::max(1, (int)std::lround(outputXRes * scale));
+    int newYRes = std::max(1, (int)std::lround(outputYRes * scale));
+    if (newXRes == xRes && newYRes == yRes)
+        return false;
+
+    xRes = newXRes;
+    yRes = newYRes;
+    updateTaps();
+
+    return true;
+}
+
+// Масштаб внутреннего разрешения
+double ResolutionScaler::getScale(){
+    return scale;
+}
+
+// Выбрать фильтр увеличения
+void ResolutionScaler::setFilter(UpscaleFilter newFilter){
+    filter = newFilter;
+}
+
+// Получить внутреннее изображение
+Drawable* ResolutionScaler::getImage(){
+    return &image;
+}
+
+// Увеличить область внутреннего изображения до поверхности вывода
+// Выборки монотонны, поэтому затронутые столбцы и строки вывода - непрерывные отрезки
+long long ResolutionScaler::upscale(Drawable* target, const ScreenRect& region){
+    if (!isEnabled() || region.isEmpty())
+        return 0;
+
+    int xMin = std::max(0, region.xMin), xMax = std::min(xRes - 1, region.xMax);
+    int rowMin = std::max(0, yRes - region.yMax), rowMax = std::min(yRes - 1, yRes - region.yMin);
+
+    int xFirst = 0, xLast = outputXRes - 1;
+    while (xFirst < outputXRes && columnTaps[xFirst].second < xMin)
+        xFirst++;
+    while (xLast >= 0 && columnTaps[xLast].first > xMax)
+        xLast--;
+
+    int rowFirst = 0, rowLast = outputYRes - 1;
+    while (rowFirst < outputYRes && rowTaps[rowFirst].second < rowMin)
+        rowFirst++;
+    while (rowLast >= 0 && rowTaps[rowLast].first > rowMax)
+        rowLast--;
+
+    long long pixels = 0;
+    for (int row = rowFirst; row <= rowLast; row++){
+        const Tap& rowTap = rowTaps[row];
+        const unsigned int* upper = &image.colors[rowTap.first * xRes];
+        const unsigned int* lower = &image.colors[rowTap.second * xRes];
+
+        for (int x = xFirst; x <= xLast; x++){
+            const Tap& columnTap = columnTaps[x];
+            unsigned int colors[4] = { upper[columnTap.first], upper[columnTap.second], lower[columnTap.first], lower[columnTap.second] };
+
+            // Внутри однотонных областей смешивать нечего
+            if (colors[0] == colors[1] && colors[0] == colors[2] && colors[0] == colors[3]){
+                target->setPixel(x, row, colors[0]);
+                continue;
+            }
+
+            int weights[4] = { (256 - columnTap.weight) * (256 - rowTap.weight), columnTap.weight * (256 - rowTap.weight),
+                               (256 - columnTap.weight) * rowTap.weight, columnTap.weight * rowTap.weight };
+            target->setPixel(x, row, blend(colors, weights));
+        }
+
+        pixels += xLast - xFirst + 1;
+    }
+
+    return pixels;
+}
+
+// Пересчитать таблицы выборки
+void ResolutionScaler::updateTaps(){
+    if (!isEnabled())
+        return;
+
+    // Изображение выделяется один раз под разрешение вывода: меньшие разрешения используют его начало
+    std::size_t capacity = (std::size_t)outputXRes * outputYRes;
+    if (image.colors.size() < capacity)
+        image.colors.resize(capacity, 0);
+    image.width = xRes;
+
+    buildTaps(columnTaps, outputXRes, xRes);
+    buildTaps(rowTaps, outputYRes, yRes);
+}
+
+// Таблица выборки одной оси: центр пикселя вывода o переходит в точку (o + 0.5) * inputSize / outputSize - 0.5 входа
+void ResolutionScaler::buildTaps(vector<Tap>& taps, int outputSize, int inputSize){
+    taps.resize(outputSize);
+    double ratio = (double)inputSize / outputSize;
+
+    for (int o = 0; o < outputSize; o++){
+        double position = std::max(0.0, (o + 0.5) * ratio - 0.5);
+        Tap& tap = taps[o];
+        tap.first = (int)position;
+
+        if (tap.first >= inputSize - 1){
+            tap.first = inputSize - 1;
+            tap.second = tap.first;
+            tap.weight = 0;
+        }
+        else {
+            tap.second = tap.first + 1;
+            tap.weight = (int)std::lround((position - tap.first) * 256);
+        }
+    }
+}
+
+// Смешать 4 соседних пикселя
+// Края: соседи, цвет которых отличается от ближайшего больше EDGE_THRESHOLD по какому-либо каналу, не учитываются
+unsigned int ResolutionScaler::blend(const unsigned int* colors, const int* weights) const {
+    int nearest = 0;
+    for (int i = 1; i < 4; i++){
+        if (weights[i] > weights[nearest])
+            nearest = i;
+    }
+
+    int used[4] = { weights[0], weights[1], weights[2], weights[3] };
+    if (filter == edgeAwareUpscale){
+        for (int i = 0; i < 4; i++){
+            for (int shift = 0; shift <= 16; shift += 8){
+                if (std::abs((int)((colors[i] >> shift) & 0xff) - (int)((colors[nearest] >> shift) & 0xff)) > EDGE_THRESHOLD){
+                    used[i] = 0;
+                    break;
+                }
+            }
+        }
+    }
+
+    unsigned int total = used[0] + used[1] + used[2] + used[3];
+    unsigned int result = colors[nearest] & 0xff000000;
+    for (int shift = 0; shift <= 16; shift += 8){
+        unsigned int sum = total / 2;
+        for (int i = 0; i < 4; i++)
+            sum += used[i] * ((colors[i] >> shift) & 0xff);
+        result |= (sum / total) << shift;
+    }
+
+    return result;
+}
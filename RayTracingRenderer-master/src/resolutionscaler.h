@@ -0,0 +1,97 @@
+#ifndef RESOLUTIONSCALER_H
+#define RESOLUTIONSCALER_H
+
+#include <vector>
+#include "drawable.h"
+#include "dirtyregiontracker.h"
+
+using std::vector;
+
+// Фильтр увеличения внутреннего изображения до разрешения вывода
+enum UpscaleFilter{
+    bilinearUpscale = 0,    // Билинейная интерполяция 4 соседних пикселей
+    edgeAwareUpscale = 1    // Билинейная, но без соседей, цвет которых резко отличается от ближайшего: края остаются четкими
+};
+
+// Внутреннее разрешение отрисовки: кадр рисуется в изображение меньшего размера (scale от MIN_SCALE до 1 по каждой оси),
+// а затем увеличивается до поверхности рисования. Время кадра примерно пропорционально scale * scale.
+// Память изображения выделяется один раз под разрешение вывода, поэтому масштаб можно менять каждый кадр
+// без перераспределения буферов; таблицы выборки пересчитываются только при изменении масштаба.
+// Координаты пикселей - координаты поверхности рисования (строка 0 сверху)
+class ResolutionScaler
+{
+public:
+    // Конструктор
+    ResolutionScaler();
+
+    // Задать разрешение вывода
+    void setOutputResolution(int newOutputXRes, int newOutputYRes);
+
+    // Задать масштаб внутреннего разрешения (ограничивается [MIN_SCALE, 1]; 1 = рисовать прямо в поверхность вывода)
+    // Возвращает: true, если внутреннее разрешение изменилось
+    bool setScale(double newScale);
+
+    // Масштаб внутреннего разрешения
+    double getScale();
+
+    // Кадр рисуется во внутреннее изображение
+    bool isEnabled() const { return xRes != outputXRes || yRes != outputYRes; }
+
+    // Внутреннее разрешение
+    int getXRes() const { return xRes; }
+    int getYRes() const { return yRes; }
+
+    // Выбрать фильтр увеличения
+    void setFilter(UpscaleFilter newFilter);
+
+    // Получить внутреннее изображение
+    // Предварительное условие: isEnabled()
+    Drawable* getImage();
+
+    // Увеличить область внутреннего изображения до поверхности вывода
+    // region: изменившиеся пиксели в координатах рендерера внутреннего разрешения (строка y выводится в строку yRes - y)
+    // Возвращает: количество записанных пикселей вывода
+    long long upscale(Drawable* target, const ScreenRect& region);
+
+    static constexpr double MIN_SCALE = 0.25;
+    static constexpr int EDGE_THRESHOLD = 48;   // Разница канала цвета, 0..255, при которой сосед не смешивается
+
+private:
+    // Внутреннее изображение: хранит цвета в памяти
+    class ScaledImage : public Drawable {
+    public:
+        vector<unsigned int> colors;
+        int width = 0;
+
+        void setPixel(int x, int y, unsigned int color) override { colors[y * width + x] = color; }
+        unsigned int getPixel(int x, int y) override { return colors[y * width + x]; }
+        void updateScreen() override {}
+    };
+
+    // Выборка одной оси для пикселя вывода: два соседних пикселя внутреннего изображения и вес второго, 0..256
+    struct Tap {
+        int first;
+        int second;
+        int weight;
+    };
+
+    int outputXRes, outputYRes;
+    int xRes, yRes;
+    double scale;
+    UpscaleFilter filter;
+
+    ScaledImage image;
+    vector<Tap> columnTaps;     // По столбцам вывода
+    vector<Tap> rowTaps;        // По строкам вывода
+
+    // Пересчитать таблицы выборки для текущего внутреннего разрешения
+    void updateTaps();
+
+    // Таблица выборки одной оси
+    static void buildTaps(vector<Tap>& taps, int outputSize, int inputSize);
+
+    // Смешать 4 соседних пикселя с весами (сумма весов 256 * 256)
+    unsigned int blend(const unsigned int* colors, const int* weights) const;
+};
+
+#endif // RESOLUTIONSCALER_H
@@ -36,6 +36,12 @@ Scene::Scene(const Scene &rhs){
 
     this->numRayBounces = rhs.numRayBounces;
     this->noRayShadows = rhs.noRayShadows;
+
+    this->lodPixelsPerFace = rhs.lodPixelsPerFace;
+    this->lodHysteresis = rhs.lodHysteresis;
+    this->rayLodLevel = rhs.rayLodLevel;
+
+    this->minLightContribution = rhs.minLightContribution;
 }
 
 // перегружен оператор присваивания
@@ -75,5 +81,11 @@ Scene& Scene::operator=(const Scene& rhs){
     this->numRayBounces = rhs.numRayBounces;
     this->noRayShadows = rhs.noRayShadows;
 
+    this->lodPixelsPerFace = rhs.lodPixelsPerFace;
+    this->lodHysteresis = rhs.lodHysteresis;
+    this->rayLodLevel = rhs.rayLodLevel;
+
+    this->minLightContribution = rhs.minLightContribution;
+
     return *this;
 }
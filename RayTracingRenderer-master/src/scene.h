@@ -48,6 +48,14 @@ public:
     // Настройки трассировки лучей сцены:
     int numRayBounces = 0;          // Количество отскоков по умолчанию при трассировке лучей. По умолчанию = 0 (т.е. без трассировки лучей)
     bool noRayShadows = false;      // Использовать или нет теневые лучи. По умолчанию = false
+
+    // Настройки уровней детализации:
+    double lodPixelsPerFace = 16;   // Минимальная экранная площадь (в пикселях) на одну грань. Определяет выбор уровня детализации
+    double lodHysteresis = 0.1;     // Гистерезис переключения уровней: предотвращает мерцание на границе между уровнями
+    int rayLodLevel = 0;            // Уровень детализации других сеток для отраженных лучей. По умолчанию = 0 (исходные грани)
+
+    // Настройки отбора источников света:
+    double minLightContribution = 1.0 / 512;    // Минимальный вклад света (интенсивность * ослабление), ниже которого свет не учитывается. 0 = без отбора
 };
 
 #endif // SCENE_H
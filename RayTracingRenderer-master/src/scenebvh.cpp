@@ -0,0 +1,186 @@
+#include "scenebvh.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Конструктор
+SceneBvh::SceneBvh(){
+    builtSurfaceArea = 0;
+    rebuildCount = 0;
+    refitCount = 0;
+    instanceCount = 0;
+}
+
+// Обновить экземпляры и верхний уровень по сеткам сцены
+void SceneBvh::update(Scene& theScene){
+    unsigned int numMeshes = theScene.theMeshes.size();
+
+    // Экземпляры: обратная матрица переводит лучи из пространства камеры в пространство объекта иерархий сетки
+    instances.resize(numMeshes);
+    instanceCount = 0;
+
+    for (unsigned int i = 0; i < numMeshes; i++){
+        Mesh& currentMesh = theScene.theMeshes[i];
+        instances[i].levels = nullptr;
+
+        if (currentMesh.objectBvhs == nullptr || (int)currentMesh.objectBvhs->size() != currentMesh.getLodCount())
+            continue;
+
+        TransformationMatrix meshToObject = currentMesh.objectToMesh.getInverse();
+
+        bool isFinite = true;
+        for (int row = 0; row < 3; row++){
+            for (int col = 0; col < 4; col++){
+                instances[i].meshToObject[row][col] = meshToObject.arrayVal(row, col);
+                isFinite = isFinite && std::isfinite(meshToObject.arrayVal(row, col));
+            }
+        }
+
+        // Вырожденное преобразование (например, нулевой масштаб): грани проверяются без иерархии
+        if (isFinite){
+            instances[i].levels = currentMesh.objectBvhs.get();
+            instanceCount++;
+        }
+    }
+
+    // Верхний уровень: разбиение сохраняется, пока набор сеток с границами тот же
+    bool isSameMeshSet = !nodes.empty() && isBounded.size() == numMeshes;
+    for (unsigned int i = 0; i < numMeshes && isSameMeshSet; i++)
+        isSameMeshSet = (isBounded[i] == theScene.theMeshes[i].hasBounds());
+
+    if (isSameMeshSet && refit(theScene) <= builtSurfaceArea * REBUILD_AREA_RATIO){
+        refitCount++;
+        return;
+    }
+
+    boundedMeshes.clear();
+    isBounded.assign(numMeshes, false);
+    for (unsigned int i = 0; i < numMeshes; i++){
+        if (theScene.theMeshes[i].hasBounds()){
+            boundedMeshes.push_back(i);
+            isBounded[i] = true;
+        }
+    }
+
+    nodes.clear();
+    builtSurfaceArea = 0;
+    rebuildCount++;
+
+    if (boundedMeshes.empty())
+        return;
+
+    buildNode(theScene, 0, boundedMeshes.size());
+
+    for (auto &currentNode : nodes)
+        builtSurfaceArea += currentNode.bounds.getSurfaceArea();
+}
+
+// Получить иерархию граней уровня детализации сетки
+const MeshBvh* SceneBvh::getMeshBvh(unsigned int meshIndex, int lodLevel) const {
+    if (meshIndex >= instances.size() || instances[meshIndex].levels == nullptr)
+        return nullptr;
+
+    const vector<MeshBvh>& levels = *instances[meshIndex].levels;
+    if (lodLevel < 0 || lodLevel >= (int)levels.size() || levels[lodLevel].isEmpty())
+        return nullptr;
+
+    return &levels[lodLevel];
+}
+
+// Перевести луч в пространство объекта сетки
+// Направление не нормализуется: параметр точки вдоль луча в обоих пространствах один и тот же
+SlabRay SceneBvh::getObjectRay(unsigned int meshIndex, const Vertex& origin, const NormalVector& direction) const {
+    const double (&matrix)[3][4] = instances[meshIndex].meshToObject;
+
+    Vertex objectOrigin( matrix[0][0] * origin.x + matrix[0][1] * origin.y + matrix[0][2] * origin.z + matrix[0][3],
+                         matrix[1][0] * origin.x + matrix[1][1] * origin.y + matrix[1][2] * origin.z + matrix[1][3],
+                         matrix[2][0] * origin.x + matrix[2][1] * origin.y + matrix[2][2] * origin.z + matrix[2][3] );
+
+    NormalVector objectDirection( matrix[0][0] * direction.xn + matrix[0][1] * direction.yn + matrix[0][2] * direction.zn,
+                                  matrix[1][0] * direction.xn + matrix[1][1] * direction.yn + matrix[1][2] * direction.zn,
+                                  matrix[2][0] * direction.xn + matrix[2][1] * direction.yn + matrix[2][2] * direction.zn );
+
+    return SlabRay(objectOrigin, objectDirection);
+}
+
+// Узлы верхнего уровня
+std::size_t SceneBvh::getNodeCount(){
+    return nodes.size();
+}
+
+// Построения верхнего уровня
+std::size_t SceneBvh::getRebuildCount(){
+    return rebuildCount;
+}
+
+// Пересчеты прямоугольников без перестроения
+std::size_t SceneBvh::getRefitCount(){
+    return refitCount;
+}
+
+// Сетки с иерархией граней
+std::size_t SceneBvh::getInstanceCount(){
+    return instanceCount;
+}
+
+// Построить поддерево сеток
+// Сетки делятся пополам по медиане центров прямоугольников вдоль самой длинной оси
+unsigned int SceneBvh::buildNode(Scene& theScene, unsigned int first, unsigned int count){
+    unsigned int nodeIndex = nodes.size();
+    nodes.emplace_back();
+
+    BoundingBox bounds;
+    BoundingBox centroidBounds;
+    for (unsigned int i = first; i < first + count; i++){
+        BoundingBox& meshBox = theScene.theMeshes[ boundedMeshes[i] ].boundingBox;
+        bounds.add(meshBox);
+        centroidBounds.add( Vertex( (meshBox.min[0] + meshBox.max[0]) / 2.0, (meshBox.min[1] + meshBox.max[1]) / 2.0, (meshBox.min[2] + meshBox.max[2]) / 2.0 ) );
+    }
+    nodes[nodeIndex].bounds = bounds;
+
+    if (count == 1){
+        nodes[nodeIndex].meshIndex = boundedMeshes[first];
+        return nodeIndex;
+    }
+
+    int axis = 0;
+    for (int i = 1; i < 3; i++){
+        if (centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis])
+            axis = i;
+    }
+
+    unsigned int middle = first + count / 2;
+    std::nth_element(boundedMeshes.begin() + first, boundedMeshes.begin() + middle, boundedMeshes.begin() + first + count,
+        [&theScene, axis](unsigned int a, unsigned int b){
+            BoundingBox& boxA = theScene.theMeshes[a].boundingBox;
+            BoundingBox& boxB = theScene.theMeshes[b].boundingBox;
+            return boxA.min[axis] + boxA.max[axis] < boxB.min[axis] + boxB.max[axis];
+        });
+
+    buildNode(theScene, first, middle - first);
+    unsigned int rightChild = buildNode(theScene, middle, first + count - middle);
+    nodes[nodeIndex].rightChild = rightChild;
+
+    return nodeIndex;
+}
+
+// Пересчитать прямоугольники узлов при прежнем разбиении
+// Потомки хранятся после родителя, поэтому обход с конца пересчитывает их раньше
+double SceneBvh::refit(Scene& theScene){
+    double surfaceArea = 0;
+
+    for (int i = (int)nodes.size() - 1; i >= 0; i--){
+        Node& currentNode = nodes[i];
+
+        if (currentNode.meshIndex >= 0)
+            currentNode.bounds = theScene.theMeshes[currentNode.meshIndex].boundingBox;
+        else {
+            currentNode.bounds = nodes[i + 1].bounds;
+            currentNode.bounds.add(nodes[currentNode.rightChild].bounds);
+        }
+
+        surfaceArea += currentNode.bounds.getSurfaceArea();
+    }
+
+    return surfaceArea;
+}
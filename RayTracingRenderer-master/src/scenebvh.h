@@ -0,0 +1,112 @@
+#ifndef SCENEBVH_H
+#define SCENEBVH_H
+
+#include <cstddef>
+#include <vector>
+#include "scene.h"
+#include "boundingbox.h"
+#include "meshbvh.h"
+
+using std::vector;
+
+// Двухуровневая иерархия для трассировки лучей
+// Верхний уровень - небольшая иерархия ограничивающих прямоугольников сеток в пространстве камеры, обновляемая каждый кадр:
+// если количество сеток не изменилось, сохраняется прежнее разбиение и пересчитываются только прямоугольники узлов (refit);
+// разбиение строится заново, если сеток стало другое количество или площадь узлов после пересчета выросла больше чем в REBUILD_AREA_RATIO раз.
+// Нижний уровень - MeshBvh граней сетки в пространстве объекта (общий с AssetCache). Луч переводится в пространство объекта
+// обратной матрицей экземпляра, поэтому стоимость обновления за кадр пропорциональна количеству сеток, а не граней
+class SceneBvh
+{
+public:
+    // Конструктор
+    SceneBvh();
+
+    // Обновить экземпляры и верхний уровень по сеткам сцены
+    // Предварительное условие: сетки находятся в пространстве камеры, их границы созданы
+    void update(Scene& theScene);
+
+    // Обойти сетки, прямоугольники которых луч пересекает на [0, maxDistance]
+    // visitMesh(номер сетки) возвращает true, чтобы остановить обход; maxDistance может уменьшаться во время обхода
+    // boxTests увеличивается на количество проверенных прямоугольников узлов
+    // Возвращает: true, если обход остановлен посетителем
+    template <typename MeshVisitor>
+    bool traverse(const SlabRay& theRay, const double& maxDistance, MeshVisitor visitMesh, unsigned long long& boxTests) const;
+
+    // Получить иерархию граней уровня детализации сетки
+    // Возвращает: nullptr, если у сетки нет иерархии (грани проверяются все подряд)
+    const MeshBvh* getMeshBvh(unsigned int meshIndex, int lodLevel) const;
+
+    // Перевести луч в пространство объекта сетки. Расстояния вдоль луча сохраняются
+    // Предварительное условие: getMeshBvh(meshIndex, ...) != nullptr
+    SlabRay getObjectRay(unsigned int meshIndex, const Vertex& origin, const NormalVector& direction) const;
+
+    // Счетчики:
+    std::size_t getNodeCount();         // Узлы верхнего уровня
+    std::size_t getRebuildCount();      // Построения верхнего уровня
+    std::size_t getRefitCount();        // Пересчеты прямоугольников без перестроения
+    std::size_t getInstanceCount();     // Сетки с иерархией граней
+
+    static constexpr double REBUILD_AREA_RATIO = 2.0;
+
+private:
+    // Экземпляр сетки
+    struct Instance {
+        const vector<MeshBvh>* levels = nullptr;    // Иерархии уровней детализации; nullptr - нет
+        double meshToObject[3][4];                  // Обратная матрица экземпляра (аффинная часть)
+    };
+
+    // Узел верхнего уровня: лист, если meshIndex >= 0
+    struct Node {
+        BoundingBox bounds;
+        int meshIndex = -1;
+        unsigned int rightChild = 0;    // Левый потомок следует сразу за узлом
+    };
+
+    vector<Instance> instances;
+    vector<Node> nodes;
+    vector<unsigned int> boundedMeshes;     // Сетки с границами, по которым построен верхний уровень (в порядке листьев)
+    vector<bool> isBounded;                 // Была ли у сетки граница при построении
+    double builtSurfaceArea;                // Сумма площадей узлов после построения
+    std::size_t rebuildCount, refitCount, instanceCount;
+
+    // Построить поддерево сеток boundedMeshes[first, first + count)
+    unsigned int buildNode(Scene& theScene, unsigned int first, unsigned int count);
+
+    // Пересчитать прямоугольники узлов при прежнем разбиении
+    // Возвращает: сумму площадей узлов
+    double refit(Scene& theScene);
+};
+
+// Обойти сетки, прямоугольники которых пересекает луч
+template <typename MeshVisitor>
+bool SceneBvh::traverse(const SlabRay& theRay, const double& maxDistance, MeshVisitor visitMesh, unsigned long long& boxTests) const {
+    if (nodes.empty())
+        return false;
+
+    // Разбиение по медиане: глубина не больше log2(количество сеток) + 1
+    unsigned int stack[MeshBvh::MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0){
+        unsigned int nodeIndex = stack[--stackSize];
+        const Node& currentNode = nodes[nodeIndex];
+
+        boxTests++;
+        if (!currentNode.bounds.intersectsRay(theRay, maxDistance))
+            continue;
+
+        if (currentNode.meshIndex >= 0){
+            if (visitMesh((unsigned int)currentNode.meshIndex))
+                return true;
+            continue;
+        }
+
+        stack[stackSize++] = currentNode.rightChild;
+        stack[stackSize++] = nodeIndex + 1;
+    }
+
+    return false;
+}
+
+#endif // SCENEBVH_H
@@ -0,0 +1,213 @@
+#include "sequencerenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <QDir>
+#include <QFileInfo>
+#include <QString>
+#include "fileinterpreter.h"
+#include "imagedrawable.h"
+
+using std::chrono::high_resolution_clock;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::cout;
+
+// Конструктор
+SequenceRenderer::SequenceRenderer(int newXRes, int newYRes){
+    xRes = newXRes;
+    yRes = newYRes;
+    firstFrame = 1;
+    lastFrame = 1;
+    threadCount = 0;
+    outputPrefix = "./frames/frame_";
+    outputExtension = "png";
+    sceneFile = FileInterpreter::DEFAULT_SCENE_FILENAME;
+    latitude = 0;
+    xCam = 0;
+    yCam = 1;
+    zCam = -4.05;
+    rasterizer = scanlineRasterizer;
+    specularModel = phongSpecular;
+    isDirtyRegionsEnabled = true;
+    isBakedLightingEnabled = false;
+    antiAliasingSamples = 1;
+    renderScale = 1;
+    upscaleFilter = bilinearUpscale;
+    nextFrame = 0;
+    framesWritten = 0;
+}
+
+// Задать диапазон кадров
+void SequenceRenderer::setFrameRange(int newFirstFrame, int newLastFrame){
+    firstFrame = newFirstFrame;
+    lastFrame = newLastFrame;
+}
+
+// Ограничить количество потоков
+void SequenceRenderer::setThreadCount(unsigned int newThreadCount){
+    threadCount = newThreadCount;
+}
+
+// Задать имена файлов кадров
+void SequenceRenderer::setOutput(string newOutputPrefix, string newOutputExtension){
+    outputPrefix = newOutputPrefix;
+    outputExtension = newOutputExtension;
+}
+
+// Задать файл описания сцены
+void SequenceRenderer::setSceneFile(string newSceneFile){
+    sceneFile = newSceneFile;
+}
+
+// Задать широту маятника
+void SequenceRenderer::setLatitude(double newLatitude){
+    latitude = newLatitude;
+}
+
+// Задать положение камеры
+void SequenceRenderer::setCamera(double newXCam, double newYCam, double newZCam){
+    xCam = newXCam;
+    yCam = newYCam;
+    zCam = newZCam;
+}
+
+// Выбрать растеризатор
+void SequenceRenderer::setRasterizer(RasterizerType newRasterizer){
+    rasterizer = newRasterizer;
+}
+
+// Выбрать модель зеркального отражения
+void SequenceRenderer::setSpecularModel(SpecularModel newModel){
+    specularModel = newModel;
+}
+
+// Перерисовывать только изменившиеся области
+void SequenceRenderer::setDirtyRegionsEnabled(bool isEnabled){
+    isDirtyRegionsEnabled = isEnabled;
+}
+
+// Запекать тени неподвижных сеток
+void SequenceRenderer::setBakedLightingEnabled(bool isEnabled){
+    isBakedLightingEnabled = isEnabled;
+}
+
+// Сглаживать края
+void SequenceRenderer::setAntiAliasingSamples(int samplesPerPixel){
+    antiAliasingSamples = samplesPerPixel;
+}
+
+// Масштабировать внутреннее разрешение кадров
+void SequenceRenderer::setRenderScale(double scale, UpscaleFilter filter){
+    renderScale = scale;
+    upscaleFilter = filter;
+}
+
+// Отрисовать и сохранить все кадры диапазона
+int SequenceRenderer::render(){
+    if (lastFrame < firstFrame)
+        return 0;
+
+    // Каталог кадров:
+    QDir().mkpath( QFileInfo(QString::fromStdString(outputPrefix + "0")).absolutePath() );
+
+    unsigned int frameCount = (unsigned int)(lastFrame - firstFrame + 1);
+    unsigned int workerCount = threadCount;
+    if (workerCount == 0)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    workerCount = std::min(workerCount, frameCount);
+
+    nextFrame = firstFrame;
+    framesWritten = 0;
+    sequenceRays = RayStatistics();
+
+    cout << "Rendering frames " << firstFrame << ".." << lastFrame << " on " << workerCount << " threads\n";
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < workerCount; i++)
+        workers.emplace_back(&SequenceRenderer::renderFrames, this, i);
+    renderFrames(0);    // Текущий поток тоже работает
+
+    for (auto &currentWorker : workers)
+        currentWorker.join();
+
+    double seconds = duration_cast<milliseconds>( high_resolution_clock::now() - t1 ).count() / 1000.0;
+    cout << framesWritten << " frames written in " << seconds << "s (" << (seconds > 0 ? framesWritten / seconds : 0) << " frames/s)\n";
+    sequenceRays.debug();
+    AssetCache::getInstance().debug();
+
+    return framesWritten;
+}
+
+// Положение маятника в момент timeStep
+void SequenceRenderer::getPendulumPosition(double latitude, int timeStep, double& sphereX, double& sphereZ){
+    double a = 0.9;
+    if (latitude == 90 || latitude == 180)
+        latitude = 89.9999;
+    // double omega1 = (15*PI/180)*sin((latitude*3.14)/180);
+    double omega1 = 0.075;
+    //double omega1 = 0.0000727;
+
+    double omega2 = 1;
+    sphereX = a * cos(omega2*timeStep) * sin(omega1* timeStep);
+    sphereZ = a * cos(omega2*timeStep) * cos(omega1* timeStep);
+}
+
+// Рабочий поток: берет кадры, пока они не закончатся
+void SequenceRenderer::renderFrames(unsigned int threadIndex){
+    if (threadIndex > 0)
+        TRACE_THREAD_NAME("sequence worker");
+
+    ImageDrawable theImage(xRes, yRes);
+    Renderer theRenderer(&theImage, xRes, yRes, 1);
+    theRenderer.setRasterizer(rasterizer);
+    theRenderer.setSpecularModel(specularModel);
+    theRenderer.setDirtyRegionsEnabled(isDirtyRegionsEnabled);
+    theRenderer.setBakedLightingEnabled(isBakedLightingEnabled);
+    theRenderer.setAntiAliasingSamples(antiAliasingSamples);
+    theRenderer.setRenderScale(renderScale);
+    theRenderer.setUpscaleFilter(upscaleFilter);
+
+    FileInterpreter theInterpreter;
+    theInterpreter.setSceneFilename(sceneFile);
+
+    for (int frame = nextFrame++; frame <= lastFrame; frame = nextFrame++){
+        high_resolution_clock::time_point t1 = high_resolution_clock::now();
+
+        double sphereX, sphereZ;
+        getPendulumPosition(latitude, frame, sphereX, sphereZ);
+
+        Scene theScene = theInterpreter.buildSceneFromFile(sphereX, sphereZ, xCam, yCam, zCam);
+        {
+            MEMORY_SCOPE(sceneMemory);
+            theRenderer.renderScene(theScene);
+        }
+
+        string filename = getFrameFilename(frame);
+        bool isSaved = theImage.save(filename);
+        if (isSaved)
+            framesWritten++;
+
+        auto duration = duration_cast<milliseconds>( high_resolution_clock::now() - t1 ).count();
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        sequenceRays.merge(theRenderer.getFrameStatistics().rays);
+        if (isSaved)
+            cout << "Frame " << frame << " -> " << filename << "\t" << duration << "ms\t(thread " << threadIndex << ")\n";
+        else
+            cout << "Could not write frame " << frame << " to " << filename << "\n";
+    }
+}
+
+// Имя файла кадра
+string SequenceRenderer::getFrameFilename(int frame){
+    char number[16];
+    std::snprintf(number, sizeof(number), "%04d", frame);
+    return outputPrefix + number + "." + outputExtension;
+}
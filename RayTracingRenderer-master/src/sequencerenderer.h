@@ -0,0 +1,89 @@
+#ifndef SEQUENCERENDERER_H
+#define SEQUENCERENDERER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include "renderer.h"
+
+using std::string;
+
+// Отрисовка последовательности кадров анимации маятника Фуко без интерфейса
+// Кадры независимы (положение маятника зависит только от номера кадра), поэтому они раздаются потокам по одному:
+// у каждого потока свои Renderer, FileInterpreter и изображение. Сетки obj читаются один раз через общий AssetCache.
+// Кадр k сохраняется в файл <outputPrefix><k, 4 цифры>.<outputExtension>
+class SequenceRenderer
+{
+public:
+    // Конструктор
+    SequenceRenderer(int newXRes, int newYRes);
+
+    // Задать диапазон кадров [first, last]
+    void setFrameRange(int newFirstFrame, int newLastFrame);
+
+    // Ограничить количество потоков. 0 = по количеству ядер
+    void setThreadCount(unsigned int newThreadCount);
+
+    // Задать начало имени файлов кадров (может содержать каталог) и расширение, определяющее формат
+    void setOutput(string newOutputPrefix, string newOutputExtension);
+
+    // Задать файл описания сцены .simp
+    void setSceneFile(string newSceneFile);
+
+    // Задать широту маятника и положение камеры (те же значения, что вводятся в окне)
+    void setLatitude(double newLatitude);
+    void setCamera(double newXCam, double newYCam, double newZCam);
+
+    // Выбрать растеризатор и модель зеркального отражения всех потоков
+    void setRasterizer(RasterizerType newRasterizer);
+    void setSpecularModel(SpecularModel newModel);
+
+    // Перерисовывать в каждом потоке только области, изменившиеся с предыдущего кадра этого потока
+    void setDirtyRegionsEnabled(bool isEnabled);
+
+    // Запекать тени неподвижных сеток (каждый поток запекает свою копию при первом кадре)
+    void setBakedLightingEnabled(bool isEnabled);
+
+    // Сглаживать края: образцов на пиксель края (1 = выключено)
+    void setAntiAliasingSamples(int samplesPerPixel);
+
+    // Рисовать кадры во внутреннем разрешении scale * разрешение кадра и увеличивать их фильтром filter (1 = выключено)
+    void setRenderScale(double scale, UpscaleFilter filter);
+
+    // Отрисовать и сохранить все кадры диапазона
+    // Возвращает: количество записанных кадров
+    int render();
+
+    // Положение маятника в момент timeStep (используется и анимацией в окне)
+    static void getPendulumPosition(double latitude, int timeStep, double& sphereX, double& sphereZ);
+
+private:
+    int xRes, yRes;
+    int firstFrame, lastFrame;
+    unsigned int threadCount;
+    string outputPrefix;
+    string outputExtension;
+    string sceneFile;
+    double latitude;
+    double xCam, yCam, zCam;
+    RasterizerType rasterizer;
+    SpecularModel specularModel;
+    bool isDirtyRegionsEnabled;
+    bool isBakedLightingEnabled;
+    int antiAliasingSamples;
+    double renderScale;
+    UpscaleFilter upscaleFilter;
+
+    std::atomic<int> nextFrame;         // Следующий неразданный кадр
+    std::atomic<int> framesWritten;
+    std::mutex outputMutex;             // Строки вывода потоков не перемешиваются
+    RayStatistics sequenceRays;         // Счетчики лучей всех кадров всех потоков (под outputMutex)
+
+    // Рабочий поток: берет кадры, пока они не закончатся
+    void renderFrames(unsigned int threadIndex);
+
+    // Имя файла кадра
+    string getFrameFilename(int frame);
+};
+
+#endif // SEQUENCERENDERER_H
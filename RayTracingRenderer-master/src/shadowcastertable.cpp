@@ -0,0 +1,106 @@
+#include "shadowcastertable.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Начало теневого луча смещено от поверхности вдоль нормали (Renderer::isShadowed): сфера приемника расширяется на это смещение
+static const double RAY_ORIGIN_MARGIN = 0.1;
+
+// Расстояние между точками
+static double getDistance(const Vertex& a, const Vertex& b){
+    return std::sqrt( (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z) );
+}
+
+// Конструктор
+ShadowCasterTable::ShadowCasterTable(){
+    numMeshes = 0;
+    casterCount = 0;
+    pairCount = 0;
+}
+
+// Построить списки для всех пар (источник света, приемник)
+void ShadowCasterTable::build(Scene& theScene){
+    numMeshes = theScene.theMeshes.size();
+    casterCount = 0;
+    pairCount = 0;
+
+    spheres.resize(numMeshes);
+    for (unsigned int i = 0; i < numMeshes; i++){
+        Mesh& currentMesh = theScene.theMeshes[i];
+
+        spheres[i].hasBounds = currentMesh.hasBounds();
+        if (spheres[i].hasBounds)
+            currentMesh.getBoundingSphere(spheres[i].center, spheres[i].radius);
+    }
+
+    // Векторы списков сохраняются между кадрами: их память переиспользуется
+    casters.resize(theScene.theLights.size() * numMeshes);
+
+    for (unsigned int lightIndex = 0; lightIndex < theScene.theLights.size(); lightIndex++){
+        Vertex& lightPosition = theScene.theLights[lightIndex].position;
+
+        for (unsigned int receiverIndex = 0; receiverIndex < numMeshes; receiverIndex++){
+            vector<unsigned int>& receiverCasters = casters[lightIndex * numMeshes + receiverIndex];
+            receiverCasters.clear();
+
+            for (unsigned int casterIndex = 0; casterIndex < numMeshes; casterIndex++){
+                if (!spheres[casterIndex].hasBounds)
+                    continue;
+
+                pairCount++;
+
+                // Приемник без границ нельзя проверить: в список входят все сетки
+                if (casterIndex == receiverIndex || !spheres[receiverIndex].hasBounds || canShadow(lightPosition, spheres[receiverIndex], spheres[casterIndex]))
+                    receiverCasters.push_back(casterIndex);
+            }
+
+            casterCount += receiverCasters.size();
+        }
+    }
+}
+
+// Получить номера сеток, которые могут затенять приемник от источника
+vector<unsigned int>* ShadowCasterTable::getCasters(unsigned int lightIndex, unsigned int receiverIndex){
+    if (receiverIndex >= numMeshes || (std::size_t)lightIndex * numMeshes + receiverIndex >= casters.size())
+        return nullptr;
+
+    return &casters[lightIndex * numMeshes + receiverIndex];
+}
+
+// Сумма длин всех списков
+std::size_t ShadowCasterTable::getCasterCount(){
+    return casterCount;
+}
+
+// Пары без отбора
+std::size_t ShadowCasterTable::getPairCount(){
+    return pairCount;
+}
+
+// Может ли сфера caster пересечь теневой луч от какой-либо точки сферы receiver к источнику
+// Лучи приемника лежат в конусе с вершиной в источнике и полууглом asin(radius / distance) вокруг направления на центр приемника;
+// сфера caster пересекает этот конус, только если угол между направлениями на центры не больше суммы полууглов
+bool ShadowCasterTable::canShadow(const Vertex& lightPosition, const MeshSphere& receiver, const MeshSphere& caster){
+    double receiverRadius = receiver.radius + RAY_ORIGIN_MARGIN;
+
+    if (getDistance(receiver.center, caster.center) <= receiverRadius + caster.radius)
+        return true;
+
+    double receiverDistance = getDistance(lightPosition, receiver.center);
+    double casterDistance = getDistance(lightPosition, caster.center);
+
+    // Источник внутри одной из сфер: конус не определен
+    if (receiverDistance <= receiverRadius || casterDistance <= caster.radius)
+        return true;
+
+    // Сетка целиком дальше от источника, чем любая точка приемника: лучи до нее не доходят
+    if (casterDistance - caster.radius >= receiverDistance + receiverRadius)
+        return false;
+
+    double cosAngle = ( (receiver.center.x - lightPosition.x) * (caster.center.x - lightPosition.x)
+                      + (receiver.center.y - lightPosition.y) * (caster.center.y - lightPosition.y)
+                      + (receiver.center.z - lightPosition.z) * (caster.center.z - lightPosition.z) ) / (receiverDistance * casterDistance);
+    double angle = std::acos( std::max(-1.0, std::min(1.0, cosAngle)) );
+
+    return angle <= std::asin(receiverRadius / receiverDistance) + std::asin(caster.radius / casterDistance);
+}
@@ -0,0 +1,52 @@
+#ifndef SHADOWCASTERTABLE_H
+#define SHADOWCASTERTABLE_H
+
+#include <cstddef>
+#include <vector>
+#include "scene.h"
+#include "vertex.h"
+
+using std::vector;
+
+// Списки сеток, которые могут отбрасывать тень на сетку-приемник от каждого источника света
+// Строятся раз в кадр по ограничивающим сферам сеток. Теневой луч из точки приемника к источнику лежит внутри конуса с вершиной
+// в источнике, описанного вокруг сферы приемника, и не дальше дальней точки этой сферы. Сетка попадает в список, только если ее сфера
+// пересекает этот конус ближе дальней точки приемника или пересекает сферу приемника. Приемник всегда входит в свой список (самозатенение).
+// Проверка консервативна: сетки вне списка гарантированно не пересекают ни один теневой луч приемника к этому источнику
+class ShadowCasterTable
+{
+public:
+    // Конструктор
+    ShadowCasterTable();
+
+    // Построить списки для всех пар (источник света, приемник)
+    // Предварительное условие: сетки и источники света находятся в одном пространстве, ограничивающие прямоугольники сеток созданы
+    void build(Scene& theScene);
+
+    // Получить номера сеток, которые могут затенять receiverIndex от источника lightIndex
+    // Return: nullptr, если пара не входит в последнее построение (тогда проверяются все сетки)
+    vector<unsigned int>* getCasters(unsigned int lightIndex, unsigned int receiverIndex);
+
+    // Счетчики последнего построения:
+    std::size_t getCasterCount();       // Сумма длин всех списков
+    std::size_t getPairCount();         // Пары (источник, приемник, сетка) без отбора
+
+private:
+    // Ограничивающая сфера сетки
+    struct MeshSphere {
+        Vertex center;
+        double radius = 0;
+        bool hasBounds = false;         // У сетки есть ограничивающий прямоугольник (без него сетка не затеняет)
+    };
+
+    unsigned int numMeshes;
+    vector<MeshSphere> spheres;
+    vector< vector<unsigned int> > casters;     // [источник * numMeshes + приемник]
+    std::size_t casterCount;
+    std::size_t pairCount;
+
+    // Может ли сфера caster пересечь теневой луч от какой-либо точки сферы receiver к источнику в точке lightPosition
+    static bool canShadow(const Vertex& lightPosition, const MeshSphere& receiver, const MeshSphere& caster);
+};
+
+#endif // SHADOWCASTERTABLE_H
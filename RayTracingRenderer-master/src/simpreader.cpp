@@ -0,0 +1,152 @@
+#include "simpreader.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using std::ifstream;
+
+// Конструктор
+SimpReader::SimpReader(){
+    position = 0;
+    lineNumber = 1;
+}
+
+// Открыть файл и прочитать его в буфер
+bool SimpReader::open(const string& filename){
+    ifstream input(filename, std::ios::in | std::ios::binary);
+    if (!input.is_open())
+        return false;
+
+    std::ostringstream contents;
+    contents << input.rdbuf();
+    buffer = contents.str();
+
+    position = 0;
+    lineNumber = 1;
+    return true;
+}
+
+// Задать значение параметра $name
+void SimpReader::setParameter(const string& name, double value){
+    parameters[name] = value;
+}
+
+// Прочитать следующее слово
+bool SimpReader::readWord(string& result){
+    skipWhitespace();
+    if (position >= buffer.size())
+        return false;
+
+    readToken(result);
+    return true;
+}
+
+// Прочитать слово-аргумент команды: как и числа, аргументы не переносятся на следующую строку
+bool SimpReader::readArgumentWord(string& result){
+    skipSpaces();
+    if (position >= buffer.size() || buffer[position] == '\n')
+        return false;
+
+    readToken(result);
+    return true;
+}
+
+// Прочитать слово, начинающееся в текущей позиции
+void SimpReader::readToken(string& result){
+    // Слово в кавычках может содержать пробелы:
+    if (buffer[position] == '"'){
+        std::size_t end = buffer.find('"', position + 1);
+        if (end == string::npos)
+            end = buffer.size();
+
+        result.assign(buffer, position + 1, end - position - 1);
+        position = (end < buffer.size()) ? end + 1 : end;
+        return;
+    }
+
+    std::size_t start = position;
+    while (position < buffer.size() && !isDelimiter(buffer[position]))
+        position++;
+
+    // Фигурные скобки - отдельные токены, даже если записаны слитно со словом:
+    if (position == start)
+        position++;
+
+    result.assign(buffer, start, position - start);
+}
+
+// Прочитать следующее число или параметр $name
+// Аргументы команды записываются в ее строке: перевод строки не пропускается, и недостающее число
+// обнаруживается в строке команды, а skipLine после ошибки пропускает только ее
+bool SimpReader::readNumber(double& result){
+    skipSpaces();
+    if (position >= buffer.size() || buffer[position] == '\n')
+        return false;
+
+    if (buffer[position] == '$'){
+        std::size_t start = position + 1;
+        std::size_t end = start;
+        while (end < buffer.size() && !isDelimiter(buffer[end]))
+            end++;
+
+        auto found = parameters.find( std::string_view(buffer).substr(start, end - start) );
+        if (found == parameters.end())
+            return false;
+
+        result = found->second;
+        position = end;
+        return true;
+    }
+
+    // strtod разбирает число прямо из буфера; буфер std::string завершается нулем
+    const char* start = buffer.c_str() + position;
+    char* end;
+    result = std::strtod(start, &end);
+
+    if (end == start || (*end != '\0' && !isDelimiter(*end)))
+        return false;
+
+    position += end - start;
+    return true;
+}
+
+// Пропустить остаток текущей строки
+void SimpReader::skipLine(){
+    while (position < buffer.size() && buffer[position] != '\n')
+        position++;
+}
+
+// Номер текущей строки
+int SimpReader::getLineNumber(){
+    return lineNumber;
+}
+
+// Пропустить пробелы, переводы строк и комментарии
+void SimpReader::skipWhitespace(){
+    skipSpaces();
+    while (position < buffer.size() && buffer[position] == '\n'){
+        lineNumber++;
+        position++;
+        skipSpaces();
+    }
+}
+
+// Пропустить пробелы и комментарий в текущей строке
+void SimpReader::skipSpaces(){
+    while (position < buffer.size()){
+        char current = buffer[position];
+
+        if (current == ' ' || current == '\t' || current == '\r' || current == ',')
+            position++;
+        else if (current == '#')
+            skipLine();
+        else
+            return;
+    }
+}
+
+// Является ли символ концом токена
+bool SimpReader::isDelimiter(char theChar){
+    return theChar == ' ' || theChar == '\t' || theChar == '\r' || theChar == '\n' || theChar == ',' || theChar == '#' || theChar == '{' || theChar == '}';
+}
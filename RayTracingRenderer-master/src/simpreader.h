@@ -0,0 +1,67 @@
+#ifndef SIMPREADER_H
+#define SIMPREADER_H
+
+#include <string>
+#include <functional>
+#include <map>
+#include <string_view>
+
+using std::string;
+
+// Потоковый читатель файлов описания сцены .simp
+// Файл читается в память один раз, затем слова и числа извлекаются по одному прямо из буфера,
+// без промежуточных списков токенов и без копирования чисел в строки
+// Комментарии начинаются с '#' и продолжаются до конца строки. Имена файлов можно заключать в кавычки
+// Вместо числа можно указать параметр: $name. Значения параметров задаются перед чтением (например, положение камеры в анимации)
+class SimpReader
+{
+public:
+    // Конструктор
+    SimpReader();
+
+    // Открыть файл и прочитать его в буфер
+    // Возвращает: false, если файл не удалось открыть
+    bool open(const string& filename);
+
+    // Задать значение параметра $name
+    void setParameter(const string& name, double value);
+
+    // Прочитать следующее слово (команду). Пробелы, переводы строк и комментарии пропускаются
+    // Возвращает: false, если файл закончился
+    bool readWord(string& result);
+
+    // Прочитать слово-аргумент команды (имя оси, имя файла) в текущей строке
+    // Возвращает: false, если строка закончилась. Перевод строки при этом не пропускается
+    bool readArgumentWord(string& result);
+
+    // Прочитать следующее число или параметр $name в текущей строке
+    // Возвращает: false, если строка закончилась или следующий токен не является числом или известным параметром.
+    // Токен и перевод строки при этом не пропускаются
+    bool readNumber(double& result);
+
+    // Пропустить остаток текущей строки (используется после ошибки)
+    void skipLine();
+
+    // Номер текущей строки, начиная с 1: для сообщений об ошибках
+    int getLineNumber();
+
+private:
+    string buffer;                          // Содержимое файла
+    std::size_t position;                   // Позиция чтения в буфере
+    int lineNumber;
+    std::map<string, double, std::less<>> parameters;  // Значения параметров $name (поиск по string_view без копирования имени)
+
+    // Пропустить пробелы, переводы строк и комментарии
+    void skipWhitespace();
+
+    // Пропустить пробелы и комментарий, не переходя на следующую строку
+    void skipSpaces();
+
+    // Прочитать слово, начинающееся в текущей позиции
+    void readToken(string& result);
+
+    // Является ли символ концом токена
+    bool isDelimiter(char theChar);
+};
+
+#endif // SIMPREADER_H
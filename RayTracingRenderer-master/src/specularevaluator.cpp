@@ -0,0 +1,116 @@
+#include "specularevaluator.h"
+#include "renderutilities.h"
+
+#include <cmath>
+#include <algorithm>
+
+// Границы размера таблицы (количество интервалов)
+static const int MIN_TABLE_INTERVALS = 256;
+static const int MAX_TABLE_INTERVALS = 16384;
+
+// Конструктор
+SpecularEvaluator::SpecularEvaluator(){
+    model = phongSpecular;
+    lastExponent = -1;
+    lastTable = nullptr;
+}
+
+// Выбрать модель зеркального отражения
+void SpecularEvaluator::setModel(SpecularModel newModel){
+    model = newModel;
+}
+
+// Получить текущую модель
+SpecularModel SpecularEvaluator::getModel(){
+    return model;
+}
+
+// Вычислить зеркальный множитель в точке
+double SpecularEvaluator::evaluate(NormalVector* normal, NormalVector* lightDirection, NormalVector* viewVector, double exponent){
+
+    double cosine;
+
+    if (model == blinnPhongSpecular){
+        // Вектор половинного угла: не требует отражения направления на свет
+        NormalVector halfVector(lightDirection->xn + viewVector->xn, lightDirection->yn + viewVector->yn, lightDirection->zn + viewVector->zn);
+        if (halfVector.isZero())
+            return 0;
+        halfVector.normalize();
+
+        cosine = normal->dotProduct(halfVector);
+        exponent *= BLINN_EXPONENT_SCALE;
+    }
+    else {
+        // Отраженное направление на свет
+        NormalVector reflectionVector = reflectOutVector(normal, lightDirection);
+
+        cosine = viewVector->dotProduct(reflectionVector);
+    }
+
+    if (cosine <= 0)
+        return 0;
+
+    return power(cosine, exponent);
+}
+
+// Возвести косинус в степень в соответствии с текущей моделью
+double SpecularEvaluator::power(double cosine, double exponent){
+    if (model == phongSpecular)
+        return pow(cosine, exponent);
+
+    PowerTable* theTable = getTable(exponent);
+
+    double position = cosine * theTable->scale;
+    int index = (int)position;
+    if (index >= (int)theTable->values.size() - 1)
+        return theTable->values.back();
+
+    double fraction = position - index;
+    return theTable->values[index] + (theTable->values[index + 1] - theTable->values[index]) * fraction;
+}
+
+// Получить максимальную ошибку таблицы для показателя
+double SpecularEvaluator::getTableError(double exponent){
+    return getTable(exponent)->maxError;
+}
+
+// Получить (при необходимости построить) таблицу для показателя
+SpecularEvaluator::PowerTable* SpecularEvaluator::getTable(double exponent){
+    if (lastTable != nullptr && exponent == lastExponent)
+        return lastTable;
+
+    auto found = tables.find(exponent);
+    if (found == tables.end()){
+        found = tables.emplace(exponent, PowerTable()).first;
+        buildTable(&found->second, exponent);
+    }
+
+    lastExponent = exponent;
+    lastTable = &found->second;
+
+    return lastTable;
+}
+
+// Построить таблицу, удваивая количество интервалов, пока ошибка не станет меньше MAX_TABLE_ERROR
+void SpecularEvaluator::buildTable(PowerTable* theTable, double exponent){
+
+    for (int intervals = MIN_TABLE_INTERVALS; intervals <= MAX_TABLE_INTERVALS; intervals *= 2){
+
+        theTable->values.resize(intervals + 1);
+        for (int i = 0; i <= intervals; i++)
+            theTable->values[i] = pow(i / (double)intervals, exponent);
+
+        theTable->scale = intervals;
+
+        // Для x ^ e ошибка линейной интерполяции на интервале наибольшая около его середины:
+        theTable->maxError = 0;
+        for (int i = 0; i < intervals; i++){
+            double exact = pow((i + 0.5) / intervals, exponent);
+            double interpolated = (theTable->values[i] + theTable->values[i + 1]) / 2.0;
+            theTable->maxError = std::max(theTable->maxError, std::fabs(exact - interpolated));
+        }
+
+        if (theTable->maxError < MAX_TABLE_ERROR)
+            return;
+    }
+}
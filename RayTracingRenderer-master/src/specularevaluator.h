@@ -0,0 +1,73 @@
+#ifndef SPECULAREVALUATOR_H
+#define SPECULAREVALUATOR_H
+
+#include "normalvector.h"
+#include <map>
+#include <vector>
+
+using std::map;
+using std::vector;
+
+// перечислитель модели зеркального отражения: выбирается во время выполнения для сравнения качества и скорости
+enum SpecularModel{
+    phongSpecular = 0,          // (V . R) ^ e, точное значение pow()
+    tablePhongSpecular = 1,     // (V . R) ^ e по таблице с линейной интерполяцией
+    blinnPhongSpecular = 2      // (N . H) ^ (4 * e), H = normalize(L + V), по таблице
+};
+
+// Вычисление зеркального члена освещения
+// Показатель степени постоянен для многоугольника, поэтому таблицы строятся один раз для каждого показателя и переиспользуются
+class SpecularEvaluator
+{
+public:
+    // Конструктор
+    SpecularEvaluator();
+
+    // Выбрать модель зеркального отражения
+    void setModel(SpecularModel newModel);
+
+    // Получить текущую модель
+    SpecularModel getModel();
+
+    // Вычислить зеркальный множитель в точке
+    // Предварительное условие: все векторы нормализованы, lightDirection и viewVector направлены от точки
+    // Возвращает: значение в [0, 1], которое умножается на коэффициент зеркального отражения и интенсивность света
+    double evaluate(NormalVector* normal, NormalVector* lightDirection, NormalVector* viewVector, double exponent);
+
+    // Возвести косинус в степень в соответствии с текущей моделью
+    // Предварительное условие: cosine в [0, 1]
+    double power(double cosine, double exponent);
+
+    // Получить максимальную ошибку таблицы для показателя (измеряется в серединах интервалов при построении)
+    double getTableError(double exponent);
+
+    // Допустимая ошибка таблицы: меньше половины шага 8-битного цвета
+    static constexpr double MAX_TABLE_ERROR = 1.0 / 1024;
+
+    // Множитель показателя для Блинна-Фонга: дает блик примерно того же размера, что и модель Фонга
+    static constexpr double BLINN_EXPONENT_SCALE = 4.0;
+
+private:
+    // Таблица значений x ^ exponent на равномерной сетке [0, 1]
+    struct PowerTable {
+        vector<double> values;
+        double scale;           // Количество интервалов: values.size() - 1
+        double maxError;        // Измеренная максимальная ошибка
+    };
+
+    SpecularModel model;
+
+    map<double, PowerTable> tables;     // Таблицы по показателю степени
+
+    // Последняя использованная таблица: показатель обычно совпадает для всех пикселей многоугольника
+    double lastExponent;
+    PowerTable* lastTable;
+
+    // Получить (при необходимости построить) таблицу для показателя
+    PowerTable* getTable(double exponent);
+
+    // Построить таблицу, удваивая количество интервалов, пока ошибка не станет меньше MAX_TABLE_ERROR
+    static void buildTable(PowerTable* theTable, double exponent);
+};
+
+#endif // SPECULAREVALUATOR_H
@@ -0,0 +1,212 @@
+#include "staticlightingcache.h"
+
+#include <algorithm>
+#include <cmath>
+#include "renderutilities.h"
+
+// Добавить вершины граней к подписи
+static void hashFaces(unsigned long long& hash, vector<Polygon>& faces){
+    hashValue(hash, (unsigned long long)faces.size());
+
+    for (auto &currentFace : faces){
+        for (int i = 0; i < currentFace.getVertexCount(); i++){
+            hashValue(hash, currentFace.vertices[i].x);
+            hashValue(hash, currentFace.vertices[i].y);
+            hashValue(hash, currentFace.vertices[i].z);
+        }
+    }
+}
+
+// Конструктор
+StaticLightingCache::StaticLightingCache(){
+    signature = 0;
+    bakedFaces = 0;
+    bakedSamples = 0;
+}
+
+// Сбросить кэш, если изменились неподвижные сетки или источники света
+bool StaticLightingCache::update(Scene& theScene){
+    unsigned long long newSignature = getSignature(theScene);
+    if (newSignature == signature)
+        return false;
+
+    clear();
+    signature = newSignature;
+    return true;
+}
+
+// Получить маску источников света, закрытых неподвижными сетками в точке грани
+bool StaticLightingCache::getShadowMask(unsigned int meshIndex, int lodLevel, unsigned int faceIndex, Polygon* theFace, Vertex* position, unsigned int numLights, ShadowTest isStaticShadowed, unsigned int& shadowMask){
+    FaceSamples& samples = getFaceSamples(meshIndex, lodLevel, faceIndex);
+
+    if (samples.resolution == 0 && samples.isBakeable)
+        bakeFace(theFace, numLights, isStaticShadowed, samples);
+
+    if (!samples.isBakeable)
+        return false;
+
+    // Барицентрические координаты точки относительно ребер v0v1 и v0v2:
+    Vertex& v0 = theFace->vertices[0];
+    Vertex& v1 = theFace->vertices[1];
+    Vertex& v2 = theFace->vertices[2];
+
+    double e1[3] = { v1.x - v0.x, v1.y - v0.y, v1.z - v0.z };
+    double e2[3] = { v2.x - v0.x, v2.y - v0.y, v2.z - v0.z };
+    double d[3] = { position->x - v0.x, position->y - v0.y, position->z - v0.z };
+
+    double d11 = e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2];
+    double d12 = e1[0] * e2[0] + e1[1] * e2[1] + e1[2] * e2[2];
+    double d22 = e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2];
+    double dp1 = d[0] * e1[0] + d[1] * e1[1] + d[2] * e1[2];
+    double dp2 = d[0] * e2[0] + d[1] * e2[1] + d[2] * e2[2];
+    double denominator = d11 * d22 - d12 * d12;
+
+    double u = (d22 * dp1 - d12 * dp2) / denominator;
+    double v = (d11 * dp2 - d12 * dp1) / denominator;
+
+    // Ближайший узел внутри грани:
+    int n = samples.resolution;
+    int a = std::max(0, std::min(n, (int)std::lround(u * n)));
+    int b = std::max(0, std::min(n, (int)std::lround(v * n)));
+    if (a + b > n){
+        if (a > b)
+            a = n - b;
+        else
+            b = n - a;
+    }
+
+    shadowMask = samples.shadowMasks[getSampleIndex(a, b, n)];
+    return true;
+}
+
+// Забыть все запеченные грани
+void StaticLightingCache::clear(){
+    meshFaces.clear();
+    bakedFaces = 0;
+    bakedSamples = 0;
+}
+
+// Грани, запеченные с последнего сброса
+std::size_t StaticLightingCache::getBakedFaces(){
+    return bakedFaces;
+}
+
+// Узлы запеченных граней
+std::size_t StaticLightingCache::getBakedSamples(){
+    return bakedSamples;
+}
+
+// Приблизительный объем данных
+std::size_t StaticLightingCache::getMemoryUsed(){
+    std::size_t result = 0;
+
+    for (auto &currentMesh : meshFaces){
+        for (auto &currentLevel : currentMesh)
+            result += currentLevel.size() * sizeof(FaceSamples);
+    }
+
+    return result + bakedSamples * sizeof(unsigned int);
+}
+
+// Подпись неподвижных сеток и источников света
+// Номера сеток входят в подпись: записи кэша адресуются номером сетки в сцене
+unsigned long long StaticLightingCache::getSignature(Scene& theScene){
+    unsigned long long result = HASH_SEED;
+
+    hashValue(result, (unsigned long long)theScene.theMeshes.size());
+
+    for (unsigned int meshIndex = 0; meshIndex < theScene.theMeshes.size(); meshIndex++){
+        Mesh& currentMesh = theScene.theMeshes[meshIndex];
+        if (!currentMesh.isStatic)
+            continue;
+
+        hashValue(result, (unsigned long long)meshIndex);
+        hashFaces(result, currentMesh.faces);
+        for (auto &currentLevel : currentMesh.lodFaces)
+            hashFaces(result, currentLevel);
+    }
+
+    hashValue(result, (unsigned long long)theScene.theLights.size());
+    for (auto &currentLight : theScene.theLights){
+        hashValue(result, currentLight.position.x);
+        hashValue(result, currentLight.position.y);
+        hashValue(result, currentLight.position.z);
+    }
+
+    return result;
+}
+
+// Найти (создать) запись грани
+StaticLightingCache::FaceSamples& StaticLightingCache::getFaceSamples(unsigned int meshIndex, int lodLevel, unsigned int faceIndex){
+    if (meshFaces.size() <= meshIndex)
+        meshFaces.resize(meshIndex + 1);
+
+    vector< vector<FaceSamples> >& levels = meshFaces[meshIndex];
+    if (levels.size() <= (unsigned int)lodLevel)
+        levels.resize(lodLevel + 1);
+
+    vector<FaceSamples>& faces = levels[lodLevel];
+    if (faces.size() <= faceIndex)
+        faces.resize(faceIndex + 1);
+
+    return faces[faceIndex];
+}
+
+// Запечь все узлы грани
+// Нормаль узла интерполируется по нормалям вершин: теневой луч смещается вдоль нее так же, как при освещении вершины или пикселя
+void StaticLightingCache::bakeFace(Polygon* theFace, unsigned int numLights, ShadowTest& isStaticShadowed, FaceSamples& result){
+    if (theFace->getVertexCount() != 3){
+        result.isBakeable = false;
+        return;
+    }
+
+    Vertex& v0 = theFace->vertices[0];
+    Vertex& v1 = theFace->vertices[1];
+    Vertex& v2 = theFace->vertices[2];
+
+    double edges[3] = { (v1 - v0).length(), (v2 - v0).length(), (v2 - v1).length() };
+    double maxEdge = std::max(edges[0], std::max(edges[1], edges[2]));
+
+    NormalVector e1(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z);
+    NormalVector e2(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z);
+    if (e1.crossProduct(e2).length() < 1e-12){
+        result.isBakeable = false;
+        return;
+    }
+
+    int n = std::max(1, std::min(MAX_RESOLUTION, (int)std::ceil(maxEdge / SAMPLE_SPACING)));
+    unsigned int bakedLights = std::min(numLights, MAX_LIGHTS);
+
+    result.resolution = n;
+    result.shadowMasks.assign(getSampleIndex(n, 0, n) + 1, 0);
+
+    for (int a = 0; a <= n; a++){
+        for (int b = 0; a + b <= n; b++){
+            double u = (double)a / n;
+            double v = (double)b / n;
+            double w = 1 - u - v;
+
+            Vertex samplePoint(v0.x * w + v1.x * u + v2.x * v, v0.y * w + v1.y * u + v2.y * v, v0.z * w + v1.z * u + v2.z * v);
+            samplePoint.normal = NormalVector(v0.normal.xn * w + v1.normal.xn * u + v2.normal.xn * v,
+                                              v0.normal.yn * w + v1.normal.yn * u + v2.normal.yn * v,
+                                              v0.normal.zn * w + v1.normal.zn * u + v2.normal.zn * v);
+            samplePoint.normal.normalize();
+
+            unsigned int mask = 0;
+            for (unsigned int i = 0; i < bakedLights; i++){
+                if (isStaticShadowed(samplePoint, i))
+                    mask |= (1u << i);
+            }
+
+            result.shadowMasks[getSampleIndex(a, b, n)] = mask;
+        }
+    }
+
+    bakedFaces++;
+    bakedSamples += result.shadowMasks.size();
+}
+
+// Номер узла (a, b) в массиве грани: строки 0..a-1 содержат (N + 1) + N + ... + (N + 2 - a) узлов
+std::size_t StaticLightingCache::getSampleIndex(int a, int b, int resolution){
+    return (std::size_t)a * (resolution + 1) - (std::size_t)a * (a - 1) / 2 + b;
+}
@@ -0,0 +1,78 @@
+#ifndef STATICLIGHTINGCACHE_H
+#define STATICLIGHTINGCACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "scene.h"
+#include "polygon.h"
+#include "vertex.h"
+
+using std::vector;
+
+// Запеченная видимость источников света для неподвижной геометрии
+// Тени, которые неподвижные сетки (Mesh::isStatic) отбрасывают друг на друга, не меняются между кадрами. Для каждой
+// треугольной грани неподвижной сетки видимость источников хранится в узлах барицентрической сетки с шагом около SAMPLE_SPACING:
+// узел (a, b) - точка v0 + (v1 - v0) * a / N + (v2 - v0) * b / N, a + b <= N. В узле хранится маска источников света,
+// закрытых неподвижными сетками. Грань запекается при первом обращении, при отрисовке берется ближайший узел.
+// Подвижные сетки по-прежнему проверяются лучом, рассеянный и зеркальный члены освещения вычисляются как обычно.
+// Подпись неподвижных сеток и источников света в мировом пространстве проверяется каждый кадр: любое изменение сбрасывает кэш
+class StaticLightingCache
+{
+public:
+    // Конструктор
+    StaticLightingCache();
+
+    // Проверка тени точки узла от неподвижных сеток для источника света lightIndex
+    typedef std::function< bool(Vertex& position, unsigned int lightIndex) > ShadowTest;
+
+    // Сбросить кэш, если изменились неподвижные сетки или источники света
+    // Предварительное условие: сцена находится в мировом пространстве
+    // Возвращает: true, если кэш сброшен
+    bool update(Scene& theScene);
+
+    // Получить маску источников света, закрытых неподвижными сетками в точке грани (бит i - источник i)
+    // При первом обращении к грани запекает все ее узлы с помощью isStaticShadowed
+    // Предварительное условие: грань и точка находятся в пространстве камеры
+    // Возвращает: false, если грань нельзя запечь (не треугольник или вырожденная)
+    bool getShadowMask(unsigned int meshIndex, int lodLevel, unsigned int faceIndex, Polygon* theFace, Vertex* position, unsigned int numLights, ShadowTest isStaticShadowed, unsigned int& shadowMask);
+
+    // Забыть все запеченные грани
+    void clear();
+
+    // Счетчики:
+    std::size_t getBakedFaces();        // Грани, запеченные с последнего сброса
+    std::size_t getBakedSamples();      // Узлы этих граней
+    std::size_t getMemoryUsed();        // Приблизительный объем данных, байт
+
+    static constexpr unsigned int MAX_LIGHTS = 32;  // Источники с большими номерами не запекаются
+    static constexpr double SAMPLE_SPACING = 0.05;  // Желаемое расстояние между узлами в единицах сцены
+    static constexpr int MAX_RESOLUTION = 256;      // Наибольшее количество отрезков ребра
+
+private:
+    // Запеченная грань
+    struct FaceSamples {
+        int resolution = 0;                 // N: количество отрезков ребра; 0 - грань еще не запечена
+        bool isBakeable = true;
+        vector<unsigned int> shadowMasks;   // Узлы по строкам a: строка a содержит N + 1 - a узлов
+    };
+
+    vector< vector< vector<FaceSamples> > > meshFaces;  // [сетка][уровень детализации][грань]
+    unsigned long long signature;
+    std::size_t bakedFaces;
+    std::size_t bakedSamples;
+
+    // Подпись неподвижных сеток и источников света
+    static unsigned long long getSignature(Scene& theScene);
+
+    // Найти (создать) запись грани
+    FaceSamples& getFaceSamples(unsigned int meshIndex, int lodLevel, unsigned int faceIndex);
+
+    // Запечь все узлы грани
+    void bakeFace(Polygon* theFace, unsigned int numLights, ShadowTest& isStaticShadowed, FaceSamples& result);
+
+    // Номер узла (a, b) в массиве грани
+    static std::size_t getSampleIndex(int a, int b, int resolution);
+};
+
+#endif // STATICLIGHTINGCACHE_H
@@ -0,0 +1,172 @@
+#include "tracer.h"
+
+#include <chrono>
+#include <cstdio>
+
+std::mutex Tracer::buffersMutex;
+vector<Tracer::ThreadBuffer*> Tracer::buffers;
+thread_local Tracer::ThreadBuffer* Tracer::threadBuffer = nullptr;
+
+// Момент запуска: от него отсчитывается время всех событий
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+// Собрано ли приложение с трассировкой
+bool Tracer::isEnabled(){
+#ifdef RENDER_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Задать имя текущего потока
+void Tracer::setThreadName(const char* name){
+    getThreadBuffer()->threadName = name;
+}
+
+// Записать все события в файл JSON
+bool Tracer::writeJson(const string& filename){
+    FILE* output = std::fopen(filename.c_str(), "w");
+    if (output == nullptr)
+        return false;
+
+    std::fprintf(output, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool isFirst = true;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto currentBuffer : buffers){
+
+        // Имя потока - метаданные трассы:
+        if (currentBuffer->threadName != nullptr){
+            std::fprintf(output, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         isFirst ? "" : ",\n", currentBuffer->threadId, currentBuffer->threadName);
+            isFirst = false;
+        }
+
+        std::size_t eventCount = currentBuffer->count.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < eventCount; i++){
+            Event& theEvent = currentBuffer->chunks[i / EVENTS_PER_CHUNK][i % EVENTS_PER_CHUNK];
+
+            // Полное событие ("X"): время и длительность в микросекундах
+            std::fprintf(output, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                         isFirst ? "" : ",\n", theEvent.name, currentBuffer->threadId, theEvent.start / 1000.0, theEvent.duration / 1000.0);
+            if (theEvent.argName != nullptr)
+                std::fprintf(output, ",\"args\":{\"%s\":%lld}", theEvent.argName, theEvent.argValue);
+            std::fprintf(output, "}");
+
+            isFirst = false;
+        }
+    }
+
+    std::fprintf(output, "\n]}\n");
+    std::fclose(output);
+
+    return true;
+}
+
+// Удалить все записанные события
+void Tracer::clear(){
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto currentBuffer : buffers){
+        currentBuffer->count.store(0, std::memory_order_release);
+        currentBuffer->dropped.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Количество записанных событий во всех потоках
+std::size_t Tracer::getEventCount(){
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    std::size_t result = 0;
+    for (auto currentBuffer : buffers)
+        result += currentBuffer->count.load(std::memory_order_acquire);
+    return result;
+}
+
+// Количество событий, не поместившихся в буферы потоков
+std::size_t Tracer::getDroppedEventCount(){
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    std::size_t result = 0;
+    for (auto currentBuffer : buffers)
+        result += currentBuffer->dropped.load(std::memory_order_relaxed);
+    return result;
+}
+
+// Получить буфер текущего потока
+// Буферы не освобождаются до завершения программы, чтобы события завершившихся потоков попали в трассу
+Tracer::ThreadBuffer* Tracer::getThreadBuffer(){
+    if (threadBuffer != nullptr)
+        return threadBuffer;
+
+    ThreadBuffer* newBuffer = new ThreadBuffer();
+    for (std::size_t i = 0; i < MAX_CHUNKS_PER_THREAD; i++)
+        newBuffer->chunks[i] = nullptr;
+    newBuffer->count = 0;
+    newBuffer->dropped = 0;
+    newBuffer->threadName = nullptr;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    newBuffer->threadId = buffers.size() + 1;
+    buffers.push_back(newBuffer);
+
+    threadBuffer = newBuffer;
+    return threadBuffer;
+}
+
+// Добавить событие в буфер текущего потока
+void Tracer::record(const char* name, const char* argName, long long argValue, long long start, long long duration){
+    ThreadBuffer* theBuffer = getThreadBuffer();
+
+    // Только этот поток меняет count, поэтому достаточно прочитать его без синхронизации
+    std::size_t index = theBuffer->count.load(std::memory_order_relaxed);
+    std::size_t chunkIndex = index / EVENTS_PER_CHUNK;
+
+    if (chunkIndex >= MAX_CHUNKS_PER_THREAD){
+        theBuffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (theBuffer->chunks[chunkIndex] == nullptr)
+        theBuffer->chunks[chunkIndex] = new Event[EVENTS_PER_CHUNK];
+
+    Event& theEvent = theBuffer->chunks[chunkIndex][index % EVENTS_PER_CHUNK];
+    theEvent.name = name;
+    theEvent.argName = argName;
+    theEvent.argValue = argValue;
+    theEvent.start = start;
+    theEvent.duration = duration;
+
+    // Публикуем событие для writeJson:
+    theBuffer->count.store(index + 1, std::memory_order_release);
+}
+
+// Текущее время в наносекундах
+long long Tracer::now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+// Начать событие
+Tracer::Scope::Scope(const char* newName){
+    name = newName;
+    argName = nullptr;
+    argValue = 0;
+    start = now();
+}
+
+// Начать событие с числовым аргументом
+Tracer::Scope::Scope(const char* newName, const char* newArgName, long long newArgValue){
+    name = newName;
+    argName = newArgName;
+    argValue = newArgValue;
+    start = now();
+}
+
+// Завершить событие и записать его
+Tracer::Scope::~Scope(){
+    record(name, argName, argValue, start, now() - start);
+}
+
+// Задать числовой аргумент события
+void Tracer::Scope::setArg(const char* newArgName, long long newArgValue){
+    argName = newArgName;
+    argValue = newArgValue;
+}
@@ -0,0 +1,111 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Трассировщик событий кадра: вложенные интервалы времени, записываемые в формате Chrome trace (chrome://tracing, Perfetto)
+// Включается при сборке с RENDER_TRACE (qmake CONFIG+=trace); без него макросы TRACE_* раскрываются в пустые инструкции.
+// Каждый поток пишет в собственный буфер без блокировок: блокировка берется только при первой записи потока,
+// чтобы зарегистрировать его буфер. Имена событий и аргументов должны быть строковыми литералами:
+// сохраняются только указатели на них
+class Tracer
+{
+public:
+    // Собрано ли приложение с трассировкой
+    static bool isEnabled();
+
+    // Задать имя текущего потока, отображаемое в трассе. Предварительное условие: name - строковый литерал
+    static void setThreadName(const char* name);
+
+    // Записать все события в файл JSON
+    // Возвращает: false, если файл не удалось открыть
+    static bool writeJson(const string& filename);
+
+    // Удалить все записанные события
+    // Предварительное условие: ни один поток в этот момент не записывает события
+    static void clear();
+
+    // Количество записанных событий во всех потоках
+    static std::size_t getEventCount();
+
+    // Количество событий, не поместившихся в буферы потоков
+    static std::size_t getDroppedEventCount();
+
+    // Событие, длящееся от создания до уничтожения объекта
+    class Scope
+    {
+    public:
+        Scope(const char* newName);
+        Scope(const char* newName, const char* newArgName, long long newArgValue);
+        ~Scope();
+
+        // Задать числовой аргумент события, если он становится известен внутри интервала
+        void setArg(const char* newArgName, long long newArgValue);
+
+    private:
+        const char* name;
+        const char* argName;
+        long long argValue;
+        long long start;
+    };
+
+    static const std::size_t EVENTS_PER_CHUNK = 16384;
+    static const std::size_t MAX_CHUNKS_PER_THREAD = 64;   // Не больше ~1 млн событий на поток
+
+private:
+    // Записанное событие. Время в наносекундах от запуска трассировщика
+    struct Event {
+        const char* name;
+        const char* argName;
+        long long argValue;
+        long long start;
+        long long duration;
+    };
+
+    // Буфер одного потока. Блоки событий выделяются по мере заполнения и не перемещаются,
+    // поэтому writeJson может читать первые count событий, пока поток продолжает запись
+    struct ThreadBuffer {
+        Event* chunks[MAX_CHUNKS_PER_THREAD];
+        std::atomic<std::size_t> count;
+        std::atomic<std::size_t> dropped;
+        unsigned int threadId;
+        const char* threadName;
+    };
+
+    static std::mutex buffersMutex;
+    static vector<ThreadBuffer*> buffers;
+    static thread_local ThreadBuffer* threadBuffer;
+
+    // Получить (при необходимости зарегистрировать) буфер текущего потока
+    static ThreadBuffer* getThreadBuffer();
+
+    // Добавить событие в буфер текущего потока
+    static void record(const char* name, const char* argName, long long argValue, long long start, long long duration);
+
+    // Текущее время в наносекундах
+    static long long now();
+};
+
+// Макросы трассировки: TRACE_SCOPE("name") отмечает интервал до конца текущего блока,
+// TRACE_SCOPE_ARG("name", "arg", value) добавляет к нему числовой аргумент, TRACE_SET_ARG меняет аргумент интервала блока,
+// TRACE_THREAD_NAME("name") задает имя текущего потока (без трассировки буфер потока не создается)
+#ifdef RENDER_TRACE
+#define TRACE_SCOPE(name) Tracer::Scope traceScope(name)
+#define TRACE_SCOPE_ARG(name, argName, argValue) Tracer::Scope traceScope(name, argName, argValue)
+#define TRACE_SET_ARG(argName, argValue) traceScope.setArg(argName, argValue)
+#define TRACE_THREAD_NAME(name) Tracer::setThreadName(name)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_SCOPE_ARG(name, argName, argValue) do {} while (0)
+#define TRACE_SET_ARG(argName, argValue) do {} while (0)
+#define TRACE_THREAD_NAME(name) do {} while (0)
+#endif
+
+#endif // TRACER_H
@@ -9,10 +9,7 @@ using std::cout;
 
 
 TransformationMatrix::TransformationMatrix(){
-    CTM = new double*[DIMENSION];
-
     for (int row = 0; row < DIMENSION; row++){
-        CTM[row] = new double[DIMENSION];
         for (int col = 0; col < DIMENSION; col++){
             if (row == col)
                 CTM[row][col] = 1;
@@ -24,10 +21,7 @@ TransformationMatrix::TransformationMatrix(){
 
 
 TransformationMatrix::TransformationMatrix(const TransformationMatrix& existingMatrix){
-    CTM = new double*[DIMENSION];
-
     for (int row = 0; row < DIMENSION; row++){
-        CTM[row] = new double[DIMENSION];
         for (int col = 0; col < DIMENSION; col++){
             this->CTM[row][col] = existingMatrix.CTM[row][col];
         }
@@ -46,12 +40,7 @@ TransformationMatrix& TransformationMatrix::operator=(const TransformationMatrix
 
 
 TransformationMatrix::~TransformationMatrix(){
-    if (CTM != nullptr){
-        for (int i = 0; i < DIMENSION; i++){
-                delete [] CTM[i];
-        }
-    }
-    delete [] CTM;
+    // Ничего не делает: матрица хранится внутри объекта
 }
 
 
@@ -189,13 +178,13 @@ TransformationMatrix operator*(TransformationMatrix& lhs, TransformationMatrix&
 TransformationMatrix TransformationMatrix::getInverse(){
 
 
-    double** theCofactors = new double*[DIMENSION];
+    double theCofactors[DIMENSION][DIMENSION];
+    double currentMinor[DIMENSION][DIMENSION];
     for (int i = 0; i < DIMENSION; i++){
-        theCofactors[i] = new double[DIMENSION];
         for (int j = 0; j < DIMENSION; j++){
 
 
-            double** currentMinor = makeMinor(CTM, DIMENSION, i, j);
+            makeMinor(CTM, DIMENSION, i, j, currentMinor);
             int minorDimension = DIMENSION - 1;
 
 
@@ -205,12 +194,6 @@ TransformationMatrix TransformationMatrix::getInverse(){
             if ((i + j) % 2 != 0){
                 theCofactors[i][j] *= -1;
             }
-
-
-            for (int i = 0; i < minorDimension; i++){
-                delete [] currentMinor[i];
-            }
-            delete [] currentMinor;
         }
     }
 
@@ -227,12 +210,6 @@ TransformationMatrix TransformationMatrix::getInverse(){
         }
     }
 
-
-    for (int i = 0; i < DIMENSION; i++){
-        delete [] theCofactors[i];
-    }
-    delete theCofactors;
-
     return result;
 }
 
@@ -242,43 +219,30 @@ double TransformationMatrix::getDeterminant(){
 }
 
 
-double TransformationMatrix::getDeterminantRecursive(double** theMatrix, int theDimension){
+double TransformationMatrix::getDeterminantRecursive(const double theMatrix[DIMENSION][DIMENSION], int theDimension){
     if (theDimension == 2){
         return ((theMatrix[0][0] * theMatrix[1][1]) - (theMatrix[0][1] * theMatrix[1][0]));
     }
 
 
     double determinant = 0;
-    double** theMinor;
+    double theMinor[DIMENSION][DIMENSION];
     for (int coefficient = 0; coefficient < theDimension; coefficient++){
-        theMinor = makeMinor(theMatrix, theDimension, 0, coefficient);;
+        makeMinor(theMatrix, theDimension, 0, coefficient, theMinor);
         if (coefficient % 2 == 0){
             determinant += theMatrix[0][coefficient] * getDeterminantRecursive( theMinor, theDimension - 1);
         }
         else {
             determinant -= theMatrix[0][coefficient] * getDeterminantRecursive( theMinor, theDimension - 1);
         }
-
-        for (int i = 0; i < theDimension - 1; i++){
-            delete theMinor[i];
-        }
-        delete theMinor;
     }
     return determinant;
 }
 
 
-double** TransformationMatrix::makeMinor(double** theMajor, int currentDimension, int row, int col){
+void TransformationMatrix::makeMinor(const double theMajor[DIMENSION][DIMENSION], int currentDimension, int row, int col, double theMinor[DIMENSION][DIMENSION]){
 
     int minorDimension = currentDimension - 1;
-    double** theMinor = new double*[minorDimension];
-    for (int i = 0; i < minorDimension; i++){
-        theMinor[i] = new double[minorDimension];
-        for (int j = 0; j < minorDimension; j++){
-            theMinor[i][j] = 0;
-        }
-    }
-
 
     for (int minorRow = 0, majorRow = 0; minorRow < minorDimension; minorRow++, majorRow++){
         for (int minorCol = 0, majorCol = 0; minorCol < minorDimension; minorCol++, majorCol++){
@@ -291,7 +255,6 @@ double** TransformationMatrix::makeMinor(double** theMajor, int currentDimension
             theMinor[minorRow][minorCol] = theMajor[majorRow][majorCol];
         }
     }
-    return theMinor;
 }
 
 
@@ -54,17 +54,18 @@ private:
     // Свойства матрицы
     static const int DIMENSION = 4;
 
-    double** CTM;// Матрица преобразования
+    double CTM[DIMENSION][DIMENSION];// Матрица преобразования: хранится внутри объекта, поэтому временные матрицы не выделяют память в куче
 
 
     // Вычисляем определитель этой матрицы: вызывает рекурсивную вспомогательную функцию
     double getDeterminant();
 
     // Рекурсивная вспомогательная функция: получить определитель матрицы
-    double getDeterminantRecursive(double** theMatrix, int theDimension);
+    double getDeterminantRecursive(const double theMatrix[DIMENSION][DIMENSION], int theDimension);
 
     // Сделать второстепенную матрицу из текущей матрицы
-    double** makeMinor(double** theMatrix, int currentDimension, int row, int col);
+    // Минор записывается в левый верхний угол theMinor размером (currentDimension - 1)
+    void makeMinor(const double theMatrix[DIMENSION][DIMENSION], int currentDimension, int row, int col, double theMinor[DIMENSION][DIMENSION]);
 };
 
 TransformationMatrix operator*(TransformationMatrix& lhs, TransformationMatrix& rhs);
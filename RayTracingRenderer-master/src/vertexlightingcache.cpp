@@ -0,0 +1,123 @@
+#include "vertexlightingcache.h"
+
+#include <functional>
+
+// Конструктор
+VertexLightingCache::VertexLightingCache(){
+    slots.resize(INITIAL_SLOTS);
+    for (auto &currentSlot : slots)
+        currentSlot.generation = 0;
+    currentGeneration = 1;
+    count = 0;
+}
+
+// Очистить кэш
+void VertexLightingCache::clear(){
+    count = 0;
+    currentGeneration++;
+
+    // Переполнение счетчика поколений: старые ячейки могли бы снова стать действительными
+    if (currentGeneration == 0){
+        for (auto &currentSlot : slots)
+            currentSlot.generation = 0;
+        currentGeneration = 1;
+    }
+}
+
+// Найти освещенный цвет вершины
+bool VertexLightingCache::find(Vertex* theVertex, unsigned int meshIndex, int lodLevel, bool doAmbient, double specularExponent, double specularCoefficient, unsigned int& result){
+    Slot* theSlot = findSlot( makeKey(theVertex, meshIndex, lodLevel, doAmbient, specularExponent, specularCoefficient) );
+    if (theSlot->generation != currentGeneration)
+        return false;
+
+    result = theSlot->litColor;
+    return true;
+}
+
+// Сохранить освещенный цвет вершины
+void VertexLightingCache::store(Vertex* theVertex, unsigned int meshIndex, int lodLevel, bool doAmbient, double specularExponent, double specularCoefficient, unsigned int litColor){
+    // Заполненность не больше половины, чтобы последовательности проб оставались короткими:
+    if ((count + 1) * 2 > slots.size())
+        grow();
+
+    Key theKey = makeKey(theVertex, meshIndex, lodLevel, doAmbient, specularExponent, specularCoefficient);
+    Slot* theSlot = findSlot(theKey);
+
+    if (theSlot->generation != currentGeneration){
+        theSlot->key = theKey;
+        theSlot->generation = currentGeneration;
+        count++;
+    }
+    theSlot->litColor = litColor;
+}
+
+// Найти ячейку с ключом или первую свободную ячейку последовательности проб (линейное пробирование)
+VertexLightingCache::Slot* VertexLightingCache::findSlot(const Key& theKey){
+    std::size_t mask = slots.size() - 1;
+    std::size_t index = KeyHash()(theKey) & mask;
+
+    while (slots[index].generation == currentGeneration && !(slots[index].key == theKey))
+        index = (index + 1) & mask;
+
+    return &slots[index];
+}
+
+// Удвоить размер таблицы, перенося ячейки текущего поколения
+void VertexLightingCache::grow(){
+    vector<Slot> oldSlots;
+    oldSlots.swap(slots);
+
+    slots.resize(oldSlots.size() * 2);
+    for (auto &currentSlot : slots)
+        currentSlot.generation = 0;
+
+    unsigned int oldGeneration = currentGeneration;
+    currentGeneration = 1;
+
+    for (auto &currentSlot : oldSlots){
+        if (currentSlot.generation == oldGeneration){
+            Slot* newSlot = findSlot(currentSlot.key);
+            *newSlot = currentSlot;
+            newSlot->generation = currentGeneration;
+        }
+    }
+}
+
+// Построить ключ для вершины
+VertexLightingCache::Key VertexLightingCache::makeKey(Vertex* theVertex, unsigned int meshIndex, int lodLevel, bool doAmbient, double specularExponent, double specularCoefficient){
+    Key result;
+    result.x = theVertex->x;
+    result.y = theVertex->y;
+    result.z = theVertex->z;
+    result.xn = theVertex->normal.xn;
+    result.yn = theVertex->normal.yn;
+    result.zn = theVertex->normal.zn;
+    result.color = theVertex->color;
+    result.meshIndex = meshIndex;
+    result.lodLevel = lodLevel;
+    result.doAmbient = doAmbient;
+    result.specularExponent = specularExponent;
+    result.specularCoefficient = specularCoefficient;
+    return result;
+}
+
+// Сравнение ключей: точное совпадение, так как копии одной вершины преобразуются одинаково
+bool VertexLightingCache::Key::operator==(const Key& rhs) const {
+    return     x == rhs.x && y == rhs.y && z == rhs.z
+            && xn == rhs.xn && yn == rhs.yn && zn == rhs.zn
+            && color == rhs.color && meshIndex == rhs.meshIndex && lodLevel == rhs.lodLevel && doAmbient == rhs.doAmbient
+            && specularExponent == rhs.specularExponent && specularCoefficient == rhs.specularCoefficient;
+}
+
+// Хэш ключа: копии вершины с одинаковым положением почти всегда совпадают и в остальных полях, поэтому хэшируются положение, цвет и сетка
+std::size_t VertexLightingCache::KeyHash::operator()(const Key& theKey) const {
+    std::hash<double> hashDouble;
+
+    std::size_t result = hashDouble(theKey.x);
+    result = result * 31 + hashDouble(theKey.y);
+    result = result * 31 + hashDouble(theKey.z);
+    result = result * 31 + theKey.color;
+    result = result * 31 + theKey.meshIndex;
+
+    return result;
+}
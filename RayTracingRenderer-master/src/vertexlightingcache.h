@@ -0,0 +1,78 @@
+#ifndef VERTEXLIGHTINGCACHE_H
+#define VERTEXLIGHTINGCACHE_H
+
+#include "vertex.h"
+#include <vector>
+#include <cstddef>
+
+using std::vector;
+
+// Кэш освещения вершин для затенения Гуро
+// Грани хранят собственные копии вершин, поэтому вершина, общая для нескольких граней, иначе освещается несколько раз.
+// Ключ - все, от чего зависит результат lightPointInCameraSpace: положение и нормаль в пространстве камеры, цвет и материал,
+// а также сетка и уровень детализации (от них зависят списки теневых сеток и запеченная видимость). Теневые лучи
+// не исключают грань, а начинаются над вершиной вдоль ее нормали, поэтому вершина делится между всеми гранями сетки
+// Источники света отбрасываются по точной проверке влияния в каждой точке, поэтому набор источников грани на результат не влияет.
+// Кэш действителен в течение одного кадра: Renderer очищает его перед первым проходом, а проходы дополнительных образцов
+// сглаживания повторно используют освещение вершин; изменение источников света или преобразования сеток между кадрами
+// не требует отдельной проверки
+// Таблица с открытой адресацией хранится в векторе и не освобождается при очистке: после первых кадров кэш не выделяет память
+class VertexLightingCache
+{
+public:
+    // Конструктор
+    VertexLightingCache();
+
+    // Очистить кэш. Память таблицы сохраняется для следующего кадра
+    void clear();
+
+    // Найти освещенный цвет вершины
+    // Возвращает: true и цвет в result, если вершина с таким же материалом уже освещена
+    bool find(Vertex* theVertex, unsigned int meshIndex, int lodLevel, bool doAmbient, double specularExponent, double specularCoefficient, unsigned int& result);
+
+    // Сохранить освещенный цвет вершины
+    void store(Vertex* theVertex, unsigned int meshIndex, int lodLevel, bool doAmbient, double specularExponent, double specularCoefficient, unsigned int litColor);
+
+private:
+    // Ключ кэша: исходные (не освещенные) значения вершины, сетка и материал
+    struct Key {
+        double x, y, z;
+        double xn, yn, zn;
+        unsigned int color;
+        unsigned int meshIndex;
+        int lodLevel;
+        bool doAmbient;
+        double specularExponent, specularCoefficient;
+
+        bool operator==(const Key& rhs) const;
+    };
+
+    // Хэш ключа: только положение, цвет и номер сетки; остальные поля сравнивает operator==
+    struct KeyHash {
+        std::size_t operator()(const Key& theKey) const;
+    };
+
+    // Ячейка таблицы: действительна, только если generation совпадает с текущим поколением кэша
+    struct Slot {
+        Key key;
+        unsigned int litColor;
+        unsigned int generation;
+    };
+
+    vector<Slot> slots;             // Размер - степень двойки
+    unsigned int currentGeneration; // Очистка кэша увеличивает поколение вместо перезаписи всех ячеек
+    std::size_t count;              // Количество ячеек текущего поколения
+
+    static const std::size_t INITIAL_SLOTS = 1024;
+
+    // Найти ячейку с ключом или первую свободную ячейку последовательности проб
+    Slot* findSlot(const Key& theKey);
+
+    // Удвоить размер таблицы, перенося ячейки текущего поколения
+    void grow();
+
+    // Построить ключ для вершины
+    Key makeKey(Vertex* theVertex, unsigned int meshIndex, int lodLevel, bool doAmbient, double specularExponent, double specularCoefficient);
+};
+
+#endif // VERTEXLIGHTINGCACHE_H
@@ -5,9 +5,9 @@
 #include <QMessageBox>
 #include <string>
 
-Window361::Window361()
+Window361::Window361(int xRes, int yRes)
 {
-    renderArea = new RenderArea361((QWidget *)0);
+    renderArea = new RenderArea361(xRes, yRes, (QWidget *)0);
 
     nextPageButton = new QPushButton("Запустить");
     connect(nextPageButton, SIGNAL(clicked()), this, SLOT(getLatitude()));
@@ -23,7 +23,7 @@ class Window361 : public QWidget
     Q_OBJECT
 
 public:
-    Window361();
+    Window361(int xRes, int yRes);
     ~Window361();
     Drawable *getDrawable();
     void setPageTurner(PageTurner *pageTurner);